@@ -30,195 +30,302 @@ Rules for limited regular expressions:
 //              `*', `?', or `['.
 
 Any other character matches itself.
+
+As in MS-DOS, case doesn't matter, and a `?' at the end of the
+expression may also match nothing at the end of the string.
+
+Compiled expressions:
+
+Scanning a directory tests every entry against the same expression,
+so compile_rexp() translates the expression once into a REXP, and
+match_rexp() tests each string against that.  The REXP holds one
+byte per token:  a lowercase literal character, or one of the codes
+REXP_END, REXP_STAR, REXP_ANY, or REXP_SET plus the number of a
+set.  Each `[]' set is kept as a bitmap with one bit per character
+code, so testing a character against a set takes a single lookup.
+
+Before any wildcards are looked at, match_rexp() compares the
+literal characters at the beginning of the expression, and at the
+end if the expression contains a `*', with the string.  Most
+entries in a directory fail one of these checks.
+
+The `*' wildcard is matched without recursion.  Only the position
+of the most recent `*' is remembered; when a later token fails to
+match, that `*' takes one more character and matching resumes after
+it.  Since the expression is matched left to right, an earlier `*'
+never needs to take back characters, so the time taken is bounded
+by the length of the string times the length of the expression.
 =========================================================================
 */
 
 #include <string.h>
 #include "fnexp.h"
 
+/* Lowercase a character, as strlwr() does. */
+#define LOWC(c)         ((c) >= 'A' && (c) <= 'Z' ? (c) + ('a' - 'A') : (c))
+
+/* Test a character against one of the sets in a REXP. */
+#define IN_SET(cre, n, c) \
+                ((cre)->rset[n][(c) >> 3] & (1 << ((c) & 7)))
+
 /*
-** check_rexp:
-** Checks to see if the specified string matches the specified
-** limited regular expression.
+** compile_rexp:
+** Translates a limited regular expression into the compiled
+** form used by match_rexp().  The expression itself is not
+** modified.
 **
 ** Parameters:
 **      Value   Meaning
 **      -----   -------
-**      str     String to be tested.
-**      rexp    Limited regular expression to test with.
+**      rexp    Limited regular expression to compile.
+**      cre     Pointer to structure to receive compiled expression.
 **
+** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       String matched specified expression.
-**      0       String doesn't match specified expression.
-**      -1      Error in expression.
+**      1       Successful.
+**      -1      Error in expression, or expression too long.
 */
 int
-check_rexp(str, rexp)
-        char    *str;
+compile_rexp(rexp, cre)
         char    *rexp;
+        REXP    *cre;
 {
-        int     s = 0;          /* Current position in str. */
-        int     r = 0;          /* Current position in rexp. */
-        int     tmp, tmp2;      /* Temporary variable. */
+        unsigned char   *r;             /* Current position in rexp. */
+        unsigned        lo, hi;         /* Range of set characters. */
+        int             t = 0;          /* Number of tokens. */
+        int             nsets = 0;      /* Number of sets. */
+        int             last = -1;      /* Index of last `*' token. */
 
-        /* In MS-DOS, case doesn't matter in filenames. */
-        strlwr(str);
-        strlwr(rexp);
-
-        /* Compare each token of rexp to str. */
-        while (str[s] || rexp[r])
+        cre->rpre = -1;
+        r = (unsigned char *)rexp;
+        while (*r)
         {
-                if (rexp[r] == '[')
+                if (t >= REXP_MAXTOK - 1)
+                {
+                        /* Expression is too long. */
+                        return -1;
+                }
+
+                if (*r == '[')
                 {
                         /* `[' is beginning of a group of characters. */
+                        if (nsets >= REXP_MAXSET)
+                        {
+                                /* Too many groups. */
+                                return -1;
+                        }
+                        memset(cre->rset[nsets], 0, sizeof(cre->rset[0]));
 
                         /* Skip `[' */
                         r++;
 
-                        tmp = 0;
-                        while (rexp[r] != ']' && rexp[r])
+                        while (*r != ']' && *r)
                         {
-                                if (rexp[r+1] == '-')
+                                lo = LOWC(*r);
+                                hi = lo;
+                                if (r[1] == '-' && r[2] != ']' && r[2])
                                 {
-                                        if (str[s] >= rexp[r] &&
-                                                str[s] <= rexp[r+2])
-                                        {
-                                                tmp = 1;
-                                        }
-                                        r += 3;
+                                        hi = LOWC(r[2]);
+                                        r += 2;
                                 }
-                                else if (rexp[r] == str[s])
-                                {
-                                        tmp = 1;
-                                        r++;
-                                }
-                                else
+                                r++;
+                                for (; lo <= hi; lo++)
                                 {
-                                        r++;
+                                        cre->rset[nsets][lo >> 3] |=
+                                                1 << (lo & 7);
                                 }
                         }
 
-                        if (rexp[r] != ']')
+                        if (*r != ']')
                         {
                                 /* No ']' at end of expression. */
                                 return -1;
                         }
                         r++;
 
-                        if (!tmp)
+                        if (cre->rpre < 0)
+                                cre->rpre = t;
+                        cre->rtok[t++] = (unsigned char)(REXP_SET + nsets);
+                        nsets++;
+                }
+                else if (*r == '?' || *r == '*')
+                {
+                        if (cre->rpre < 0)
+                                cre->rpre = t;
+                        if (*r == '*')
                         {
-                                /* String char didn't match group. */
-                                return 0;
+                                last = t;
+                                cre->rtok[t++] = REXP_STAR;
                         }
-
-                        if (str[s])
-                                s++;
+                        else
+                        {
+                                cre->rtok[t++] = REXP_ANY;
+                        }
+                        r++;
                 }
-                else if (rexp[r] == '?')
+                else if (*r < REXP_LIT)
                 {
-                        /* `?' means we don't care what this character is. */
-
-                        /* Skip `[' */
+                        /* Control characters can't be in filenames. */
+                        return -1;
+                }
+                else
+                {
+                        /* Regular character. */
+                        cre->rtok[t++] = (unsigned char)LOWC(*r);
                         r++;
-
-                        if (str[s])
-                                s++;
                 }
-                else if (rexp[r] == '*')
+        }
+        cre->rtok[t] = REXP_END;
+        cre->rlen = t;
+
+        /*
+        ** Count the literal characters at each end of the
+        ** expression.  The characters after the last `*' must
+        ** always be at the end of the string; without a `*',
+        ** the whole expression is matched from the beginning.
+        */
+        if (cre->rpre < 0)
+                cre->rpre = t;
+        cre->rsuf = 0;
+        if (last >= 0)
+        {
+                while (t - cre->rsuf - 1 > last &&
+                        cre->rtok[t - cre->rsuf - 1] >= REXP_LIT)
                 {
-                        /*
-                        ** `*' means we don't care what str is up until
-                        ** the next matching character.
-                        */
+                        cre->rsuf++;
+                }
+        }
 
-                        /* Skip `*' */
-                        r++;
+        return 1;
+}
 
-                        if (rexp[r] == '*' || rexp[r] == '?')
-                        {
-                                /* Can't have multiple wildcards in a row. */
-                                return -1;
-                        }
+/*
+** match_rexp:
+** Checks to see if the specified string matches a limited
+** regular expression that was compiled by compile_rexp().
+** The string is not modified.
+**
+** Parameters:
+**      Value   Meaning
+**      -----   -------
+**      cre     Compiled limited regular expression.
+**      str     String to be tested.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       String matched expression.
+**      0       String doesn't match expression.
+*/
+int
+match_rexp(cre, str)
+        REXP    *cre;
+        char    *str;
+{
+        unsigned char   *s;             /* String as unsigned chars. */
+        unsigned char   *tok;           /* Expression tokens. */
+        int             i;              /* Current position in s. */
+        int             t;              /* Current token. */
+        int             len;            /* Length of string. */
+        int             star = -1;      /* Token after last `*'. */
+        int             spos = 0;       /* String position at last `*'. */
+        unsigned        c;              /* Current string character. */
 
-#if 0
-                        /*
-                        ** If no characters are left in string, then
-                        ** error, because * must match something.
-                        */
-                        if (!str[s])
-                                return 0;
-#endif /* 0 */
-
-                        /*
-                        ** If no characters follow the `*' in the
-                        ** expression, then the string automatically
-                        ** matches.
-                        */
-                        if (!rexp[r])
-                        {
-                                /* Force match `*' */
-                                return 1;
-                        }
+        s = (unsigned char *)str;
+        tok = cre->rtok;
 
-                        if (str[s]
-#if 1
-                                && str[s] != rexp[r]
-#endif
-                                )
-                        {
-                                /* `*' must skip at least one character. */
-                                s++;
-                        }
-#if 0
-                        else
-                        {
-                                /* End of string, but not end of rexp. */
+        /* Check the literal characters at the start. */
+        for (i = 0; i < cre->rpre; i++)
+        {
+                if (LOWC(s[i]) != tok[i])
+                        return 0;
+        }
+
+        /* Check the literal characters at the end. */
+        if (cre->rsuf > 0)
+        {
+                len = strlen(str);
+                if (len < cre->rpre + cre->rsuf)
+                        return 0;
+                t = cre->rlen;
+                for (i = 1; i <= cre->rsuf; i++)
+                {
+                        if (LOWC(s[len - i]) != tok[t - i])
                                 return 0;
-                        }
-#endif
-
-                        /*
-                        ** Search for last match of character following
-                        ** the `*'.
-                        */
-                        tmp2 = -1;
-                        tmp = s;
-                        while (str[tmp])
-                        {
-                                if (str[tmp] == rexp[r])
-                                        tmp2 = tmp;
-                                tmp++;
-                        }
+                }
+        }
 
-                        if (tmp2 != -1)
-                        {
-                                s = tmp2;
-                        }
+        /* Match the rest of the expression. */
+        t = i = cre->rpre;
+        while (1)
+        {
+                if (tok[t] == REXP_STAR)
+                {
+                        /* Let the `*' match nothing for now. */
+                        star = ++t;
+                        spos = i;
+                        continue;
+                }
 
-                        if (str[s] != rexp[r])
-                                return 0;
+                c = LOWC(s[i]);
+                if (c == '\0')
+                {
+                        /* `?' and `*' can match nothing at the end. */
+                        while (tok[t] == REXP_ANY || tok[t] == REXP_STAR)
+                                t++;
+                        return tok[t] == REXP_END;
+                }
 
-                        if (str[s])
-                                s++;
-                        if (rexp[r])
-                                r++;
+                if (tok[t] == REXP_ANY ||
+                        (tok[t] >= REXP_LIT && tok[t] == c) ||
+                        (tok[t] >= REXP_SET && tok[t] < REXP_LIT &&
+                                IN_SET(cre, tok[t] - REXP_SET, c)))
+                {
+                        /* Token matched this character. */
+                        t++;
+                        i++;
+                }
+                else if (star >= 0)
+                {
+                        /* Let the last `*' take one more character. */
+                        t = star;
+                        i = ++spos;
                 }
                 else
                 {
-                        /* Regular character. */
-                        if (str[s] != rexp[r])
-                        {
-                                /* Current characters don't match. */
-                                return 0;
-                        }
-                        if (rexp[r])
-                                r++;
-                        if (str[s])
-                                s++;
+                        /* No match. */
+                        return 0;
                 }
         }
-
-        return 1;
 }
 
+/*
+** check_rexp:
+** Checks to see if the specified string matches the specified
+** limited regular expression.  To test many strings against
+** the same expression, use compile_rexp() and match_rexp().
+**
+** Parameters:
+**      Value   Meaning
+**      -----   -------
+**      str     String to be tested.
+**      rexp    Limited regular expression to test with.
+**
+**      Value   Meaning
+**      -----   -------
+**      1       String matched specified expression.
+**      0       String doesn't match specified expression.
+**      -1      Error in expression.
+*/
+int
+check_rexp(str, rexp)
+        char    *str;
+        char    *rexp;
+{
+        REXP    cre;
+
+        if (compile_rexp(rexp, &cre) != 1)
+                return -1;
+        return match_rexp(&cre, str);
+}
@@ -31,9 +31,72 @@ Rules for limited regular expressions:
                 `*', `?', or `['.
 
 Any other character matches itself.
+
+As in MS-DOS, case doesn't matter, and a `?' at the end of the
+expression may also match nothing at the end of the string.
 =========================================================================
 */
 
+/* Limits of a compiled expression. */
+#define REXP_MAXTOK     64      /* Max tokens, including REXP_END. */
+#define REXP_MAXSET     4       /* Max `[]' sets. */
+
+/* Token codes in a compiled expression. */
+#define REXP_END        0       /* End of expression. */
+#define REXP_STAR       1       /* `*' */
+#define REXP_ANY        2       /* `?' */
+#define REXP_SET        3       /* First `[]' set; others follow. */
+#define REXP_LIT        ' '     /* Tokens from here up are literals. */
+
+/* REXP data structure for a compiled limited regular expression. */
+struct rexp_s
+{
+        unsigned char   rtok[REXP_MAXTOK];      /* Tokens. */
+        unsigned char   rset[REXP_MAXSET][32];  /* Bitmaps of `[]' sets. */
+        int             rlen;   /* Number of tokens. */
+        int             rpre;   /* Number of literal tokens at start. */
+        int             rsuf;   /* Literal tokens at end after a `*'. */
+};
+typedef struct rexp_s REXP;
+
+/*
+** compile_rexp:
+** Translates a limited regular expression into the compiled
+** form used by match_rexp().
+**
+** Parameters:
+**      Value   Meaning
+**      -----   -------
+**      rexp    Limited regular expression to compile.
+**      cre     Pointer to structure to receive compiled expression.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      -1      Error in expression, or expression too long.
+*/
+int     compile_rexp(char *rexp, REXP *cre);
+
+/*
+** match_rexp:
+** Checks to see if the specified string matches a limited
+** regular expression that was compiled by compile_rexp().
+**
+** Parameters:
+**      Value   Meaning
+**      -----   -------
+**      cre     Compiled limited regular expression.
+**      str     String to be tested.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       String matched expression.
+**      0       String doesn't match expression.
+*/
+int     match_rexp(REXP *cre, char *str);
+
 /*
 ** check_rexp:
 ** Checks to see if the specified string matches the specified
@@ -46,6 +46,7 @@ by the other modules in the program.
 /* Functions that are local to this file: */
 static int      load_env(char *menvp[]);
 static int      find_inifile(char *str);
+static int      read_makefiles(char *menvp[], char *ifname);
 static void     usage(void);
 static int      initialize(void);
 static void     deinitialize(void);
@@ -56,6 +57,12 @@ static void     errstop(void);
 /* Default filenames. */
 #define DEFAULT_MAKEFILE "Makefile"
 #define DEFAULT_INIFILE "make.inf"
+#define DEFAULT_DIGESTFILE "make.dig"
+#define DEFAULT_SNAPFILE "make.snp"
+
+/* Names of macros that configure the artifact cache. */
+#define MACRO_CACHEDIR  "MAKECACHE"
+#define MACRO_CACHESIZE "MAKECACHESIZE"
 
 /* For "copynote.h", so it won't use printf() which is big. */
 #define COPYNOTE_PRINT_FUNC     mputs
@@ -164,6 +171,70 @@ find_inifile(str)
         return 0;
 }
 
+/*
+** read_makefiles:
+** Reads the environment, the predefined macros, the INI file,
+** and the makefile, in the order that gives each its proper
+** precedence.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      menvp   Array of environment strings.
+**      ifname  Pathname of INI file (NULL if none).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+read_makefiles(menvp, ifname)
+        char    *menvp[];
+        char    *ifname;
+{
+        /*
+        ** If environment override is not enabled, then
+        ** read the environment before the makefile is read.
+        */
+        if (!CHKFLAG(FLAG_ENV_OVERRIDE))
+        {
+                if (!load_env(menvp))
+                        return 0;
+        }
+
+        /* Initialize predefined macros. */
+        if (!predefine_macros())
+                return 0;
+
+        /*
+        ** If defaults are not disabled, read the default
+        ** macros and rules from the initialization file.
+        */
+        if (ifname != (char *)NULL)
+        {
+                if (!process_makefile(ifname))
+                        return 0;
+        }
+
+        /* Parse the contents of the makefile. */
+        if (!process_makefile(makefile_name))
+                return 0;
+
+        /*
+        ** If environment override is enabled, read the
+        ** environment now.
+        */
+        if (CHKFLAG(FLAG_ENV_OVERRIDE))
+        {
+                if (!load_env(menvp))
+                        return 0;
+        }
+
+        return 1;
+}
+
 /*
 ** usage:
 ** Displays information about the program.
@@ -202,6 +273,7 @@ initialize(void)
         strcpy(makefile_name, DEFAULT_MAKEFILE);
         strcpy(cwd_name, "");
         makeflags = 0;
+        maxjobs = 1;
 
         /* Initialize memory handler. */
         if (!mem_init())
@@ -214,9 +286,18 @@ initialize(void)
         /* Set up lists. */
         init_macros();                  /* Macro list is empty. */
         init_rules();                   /* Rule list is empty. */
+        init_patterns();                /* Pattern rule list is empty. */
         init_targets();                 /* Target list is empty. */
         init_precious();                /* Precious names list is empty. */
+        init_restat();                  /* Restat names list is empty. */
+        init_phony();                   /* Phony names table is empty. */
         init_suffixes();                /* Suffixes list is empty. */
+        init_jobs();                    /* Job queue is empty. */
+        init_states();                  /* No targets checked yet. */
+        init_mstat();                   /* No file times cached yet. */
+        init_dirs();                    /* No directories read yet. */
+        init_digests();                 /* No file digests known yet. */
+        init_cache();                   /* No artifact cache yet. */
 
         return 1;
 }
@@ -240,15 +321,45 @@ deinitialize(void)
         /* Free rule list. */
         flush_rules();
 
+        /* Free pattern rule list. */
+        flush_patterns();
+
         /* Free target list. */
         flush_targets();
 
         /* Free the precious filenames list. */
         flush_precious();
 
+        /* Free the restat filenames list. */
+        flush_restat();
+
+        /* Free the phony targets table. */
+        flush_phony();
+
         /* Free the suffixes list. */
         flush_suffixes();
 
+        /* Free the included files. */
+        flush_includes();
+
+        /* Free the job queue. */
+        flush_jobs();
+
+        /* Free the target state table. */
+        flush_states();
+
+        /* Save and free the artifact cache index. */
+        save_cache();
+        flush_cache();
+
+        /* Save and free the digest database. */
+        save_digests();
+        flush_digests();
+
+        /* Free the file time/date stamp cache. */
+        flush_mstat();
+        flush_dirs();
+
         /* Shut down memory handler. */
         mem_deinit();
 
@@ -324,6 +435,14 @@ main(argc, argv, envp)
         int     result;         /* Function return code. */
         int     query_result = 0; /* Up-to-date flag. */
         char    inifile_name[MAXPATH]; /* Pathname of INI file. */
+        char    digest_name[MAXPATH]; /* Pathname of digest database. */
+        char    snap_name[MAXPATH]; /* Pathname of makefile snapshot. */
+        unsigned long snap_key; /* Key of makefile snapshot. */
+        unsigned int pflags;    /* Flags before makefile was parsed. */
+        int     have_inifile;   /* Flag, nonzero if INI file was found. */
+        int     snapped;        /* Flag, nonzero if snapshot was loaded. */
+        char    *cache_dir;     /* Name of artifact cache directory. */
+        char    *cache_size;    /* Size limit of artifact cache. */
 
         /* See if user wants help. */
         if (argv[1][0] == '-' && argv[1][1] == '?')
@@ -379,6 +498,21 @@ main(argc, argv, envp)
                                                 SETFLAG(FLAG_ENV_OVERRIDE);
                                                 break;
 
+                                        case OPT_DIGEST:
+                                                /* Compare file contents. */
+                                                SETFLAG(FLAG_DIGEST);
+                                                break;
+
+                                        case OPT_CMDSIG:
+                                                /* Compare commands. */
+                                                SETFLAG(FLAG_CMDSIG);
+                                                break;
+
+                                        case OPT_SNAPSHOT:
+                                                /* Reuse parsed makefile. */
+                                                SETFLAG(FLAG_SNAPSHOT);
+                                                break;
+
                                         case OPT_WORKINGDIR:
                                                 /* Set working directory. */
                                                 if (argv[i][j + 1])
@@ -421,6 +555,28 @@ main(argc, argv, envp)
                                                 }
                                                 break;
 
+                                        case OPT_JOBS:
+                                                /* Run commands at once. */
+                                                if (argv[i][j + 1] >= '1' &&
+                                                        argv[i][j + 1] <= '9')
+                                                {
+                                                        maxjobs = atoi(
+                                                        &argv[i][j + 1]);
+                                                        j = strlen(argv[i]);
+                                                        j--;
+                                                }
+                                                else
+                                                {
+                                                        /* No count. */
+                                                        errmsg(
+                                                        MSG_ERR_JNOCOUNT,
+                                                                (char *)NULL,
+                                                                NOVAL);
+                                                        errstop();
+                                                        return 1;
+                                                }
+                                                break;
+
                                         case OPT_IGNORE:
                                                 /* Ignore return codes. */
                                                 SETFLAG(FLAG_IGNORE);
@@ -544,13 +700,26 @@ main(argc, argv, envp)
                 i++;
         }
 
+        /* See if make initialization file exists. */
+        cvt_slash(makefile_name);
+        have_inifile = !CHKFLAG(FLAG_NO_DEFAULTS) &&
+                find_inifile(inifile_name);
+
         /*
-        ** If environment override is not enabled, then
-        ** read the environment before the makefile is read.
+        ** If snapshots are enabled, try to load the parsed
+        ** makefile from the snapshot in the makefile's directory.
         */
-        if (!CHKFLAG(FLAG_ENV_OVERRIDE))
+        snapped = 0;
+        if (CHKFLAG(FLAG_SNAPSHOT))
         {
-                if (!load_env(envp))
+                get_part_filename(1, makefile_name, snap_name);
+                if (snap_name[0] != '\0')
+                        strcat(snap_name, "\\");
+                strcat(snap_name, DEFAULT_SNAPFILE);
+                snap_key = snapshot_key(argc, argv, envp, makefile_name,
+                        have_inifile ? inifile_name : (char *)NULL);
+                snapped = load_snapshot(snap_name, snap_key);
+                if (snapped == -1)
                 {
                         deinitialize();
                         errstop();
@@ -558,62 +727,75 @@ main(argc, argv, envp)
                 }
         }
 
-        /* Initialize predefined macros. */
-        if (!predefine_macros())
+        if (!snapped)
         {
-                deinitialize();
-                return 1;
-        }
+                /* Parse the makefiles and the environment. */
+                pflags = makeflags;
+                if (!read_makefiles(envp,
+                        have_inifile ? inifile_name : (char *)NULL))
+                {
+                        deinitialize();
+                        errstop();
+                        return 1;
+                }
 
-        /*
-        ** If defaults are not disabled, read the default
-        ** macros and rules from the initialization file.
-        */
-        if (!CHKFLAG(FLAG_NO_DEFAULTS))
-        {
-                /* See if make initialization file exists. */
-                if (find_inifile(inifile_name))
+                /*
+                ** Save the results for next time.  The build can
+                ** go on even if the snapshot can't be written.
+                */
+                if (CHKFLAG(FLAG_SNAPSHOT))
                 {
-                        /* Process the make initialization file. */
-                        if (!process_makefile(inifile_name))
-                        {
-                                deinitialize();
-                                errstop();
-                                return 1;
-                        }
+                        save_snapshot(snap_name, snap_key,
+                                makeflags & ~pflags);
                 }
         }
 
-        /* Parse the contents of the makefile. */
-        cvt_slash(makefile_name);
-        if (!process_makefile(makefile_name))
+        /* Make sure at least one target was found in the makefile. */
+        if (default_target() == (char *)NULL)
         {
+                errmsg(MSG_ERR_NOTARGETS, makefile_name, NOVAL);
                 deinitialize();
                 errstop();
                 return 1;
         }
 
         /*
-        ** If environment override is enabled, read the
-        ** environment now.
+        ** If an artifact cache directory is named by a macro,
+        ** read the cache's index.
         */
-        if (CHKFLAG(FLAG_ENV_OVERRIDE))
+        cache_dir = find_macro(MACRO_CACHEDIR);
+        if (cache_dir != (char *)NULL && cache_dir[0] != '\0')
         {
-                if (!load_env(envp))
+                cache_size = find_macro(MACRO_CACHESIZE);
+                if (!load_cache(cache_dir, cache_size == (char *)NULL ?
+                        0L : atol(cache_size)))
                 {
                         deinitialize();
                         errstop();
                         return 1;
                 }
+                SETFLAG(FLAG_CACHE);
         }
 
-        /* Make sure at least one target was found in the makefile. */
-        if (default_target() == (char *)NULL)
+        /*
+        ** If contents or commands are being compared, targets
+        ** are being cached, or targets are to be checked again
+        ** after their commands are run, read the digest database
+        ** from the makefile's directory.
+        */
+        if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) ||
+                uses_restat())
         {
-                errmsg(MSG_ERR_NOTARGETS, makefile_name, NOVAL);
-                deinitialize();
-                errstop();
-                return 1;
+                get_part_filename(1, makefile_name, digest_name);
+                if (digest_name[0] != '\0')
+                        strcat(digest_name, "\\");
+                strcat(digest_name, DEFAULT_DIGESTFILE);
+                if (!load_digests(digest_name))
+                {
+                        deinitialize();
+                        errstop();
+                        return 1;
+                }
         }
 
         /* If info mode is enabled, then display collected information. */
@@ -621,8 +803,11 @@ main(argc, argv, envp)
         {
                 dump_macros();
                 dump_precious();
+                dump_restat();
+                dump_phony();
                 dump_suffixes();
                 dump_rules();
+                dump_patterns();
                 dump_targets();
         }
 
@@ -704,6 +889,30 @@ main(argc, argv, envp)
                         query_result++;
         }
 
+        /* Run the commands for any targets in the job queue. */
+        if (!run_jobs())
+        {
+                deinitialize();
+                errstop();
+                return 1;
+        }
+
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                /* Tell the user how well the file time cache did. */
+                dump_mstat();
+                dump_dirs();
+
+                /* Tell the user how much memory the arenas used. */
+                dump_arenas();
+        }
+
+        if (CHKFLAG(FLAG_CACHE) && !CHKFLAG(FLAG_NO_SHOW))
+        {
+                /* Tell the user how well the artifact cache did. */
+                report_cache();
+        }
+
         /* Shut down. */
         deinitialize();
 
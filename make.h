@@ -39,14 +39,6 @@ in that module.
 
 /******************************* CONSTANTS **************************/
 
-/*
-** If BT_TARGETS is defined, the target list will be stored in a
-** binary tree; otherwise, a linked list will be used.
-*/
-/*
-#define BT_TARGETS
-*/
-
 /* Maximum length for filenames and macro names (including the ending null). */
 #define MAXPATH         128
 
@@ -56,9 +48,22 @@ in that module.
 /* Maximum length for filename suffixes (not including '.' or ending null). */
 #define MAX_SUFFIX_STR  3
 
+/* Maximum number of pattern rules find_patterns() returns for one file. */
+#define MAX_PATMATCH    8
+
+/* Largest block of memory that a growing table is allowed to use. */
+#define MAXALLOC        ((unsigned int)-16)
+
 /* Value for errmsg() function to indicate no integer display. */
 #define NOVAL           32767
 
+/*
+** Timestamp returned by make_target() for a target whose commands
+** are waiting in the job queue, or for a phony target that is
+** always out of date; newer than any real file time.
+*/
+#define TIME_PENDING    0x7FFFFFFFL
+
 /*
 ** Bit positions for makeflags.
 */
@@ -99,6 +104,18 @@ in that module.
 /* 1 = display sign-on message. */
 #define FLAG_SIGNON             2048
 
+/* 1 = compare dependents' contents instead of their timestamps. */
+#define FLAG_DIGEST             4096
+
+/* 1 = rebuild targets whose commands have changed. */
+#define FLAG_CMDSIG             8192
+
+/* 1 = restore built targets from the artifact cache. */
+#define FLAG_CACHE              16384
+
+/* 1 = reuse a snapshot of the parsed makefile. */
+#define FLAG_SNAPSHOT           32768
+
 /******************************* MACROS *****************************/
 
 #define SETFLAG(f)              (makeflags |= (f))
@@ -110,57 +127,338 @@ in that module.
 struct mstat_t
 {
         unsigned long   st_mtime; /* Time/date stamp of file. */
+        unsigned long   st_size;  /* Size of file in bytes. */
+};
+
+/* FSTAT data structure for cache of file time/date stamps. */
+struct fstat_s
+{
+        char            *fname;         /* Name of file (lowercase). */
+        unsigned int    fhash;          /* hash_name() value of fname. */
+        int             fresult;        /* Value mstat() returned. */
+        unsigned long   ftime;          /* Time/date stamp of file. */
+        unsigned long   fsize;          /* Size of file in bytes. */
+        struct fstat_s  *fnext;         /* Next entry in hash bucket. */
 };
+typedef struct fstat_s FSTAT;
+
+/* CMDPART data structure for one piece of a compiled command line. */
+struct cmdpart_s
+{
+        char            ckind;  /* What the piece is (CMD_xxx). */
+        unsigned int    clen;   /* Length of text (CMD_TEXT only). */
+        char            *ctext; /* Text of piece (CMD_TEXT only). */
+};
+typedef struct cmdpart_s CMDPART;
+
+/* Kinds of pieces in a compiled command line. */
+#define CMD_END         0       /* End of command line. */
+#define CMD_TEXT        1       /* Literal text. */
+#define CMD_TARGET      2       /* '$@', name of target. */
+#define CMD_BASE        3       /* '$*', basename of target. */
+#define CMD_SOURCE      4       /* '$<', rule's source file. */
+#define CMD_NEWER       5       /* '$?', list of dependents. */
+#define CMD_ALLDEPS     6       /* '$**', list of dependents. */
 
 /* LINE data structure for linked lists of lines. */
 struct line_s
 {
         char            *ldata; /* Text of line. */
+        CMDPART         *lcmd;  /* Compiled command line (or NULL). */
         struct line_s   *lnext; /* Pointer to next line of text. */
 };
 typedef struct line_s LINE;
 
+/* LIST data structure for a list of lines that is added to at its end. */
+struct list_s
+{
+        LINE            *lhead;         /* First line in list (or NULL). */
+        LINE            *ltail;         /* Last line in list (or NULL). */
+        unsigned int    lcount;         /* Number of lines in list. */
+};
+typedef struct list_s LIST;
+
+/* STRVEC data structure for a set of strings kept in one block. */
+struct strvec_s
+{
+        unsigned int    *voff;          /* Offset of each string in vpool. */
+        unsigned int    vcount;         /* Number of strings. */
+        unsigned int    vmax;           /* Number of entries voff holds. */
+        char            *vpool;         /* The strings, end to end. */
+        unsigned int    vused;          /* Bytes used in vpool. */
+        unsigned int    vsize;          /* Size of vpool, in bytes. */
+};
+typedef struct strvec_s STRVEC;
+
+/* Gets a pointer to string number 'i' of a string vector. */
+#define VSTR(v, i)      (&(v)->vpool[(v)->voff[i]])
+
 /* MACRO data structure for linked list of macros. */
 struct macro_s
 {
-        char            *mname; /* Name of macro. */
-        char            *mexp;  /* Text of macro expansion. */
-        struct macro_s  *mnext; /* Pointer to next macro in list. */
+        char            *mname;  /* Name of macro. */
+        char            *mexp;   /* Text of macro expansion. */
+        char            *mfull;  /* mexp with macros expanded (or NULL). */
+        unsigned int    mgen;    /* macro_gen when mfull was made. */
+        char            mbusy;   /* Nonzero while mfull is being made. */
+        unsigned int    mhash;   /* hash_name() value of mname. */
+        struct macro_s  *mhnext; /* Next macro in same hash bucket. */
+        struct macro_s  *mnext;  /* Pointer to next macro in list. */
 };
 typedef struct macro_s MACRO;
 
-/* RULE data structure for linked list of rules. */
+/*
+** RULE data structure for linked list of rules.  For a pattern
+** rule, rsrc and rdest are the source and target patterns.
+*/
 struct rule_s
 {
         char            *rsrc;          /* Source file extension of rule. */
         char            *rdest;         /* Dest file extension of rule. */
+        int             rpattern;       /* Nonzero for a pattern rule. */
         LINE            *rcommands;     /* Commands to build target. */
         struct rule_s   *rnext;         /* Pointer to next rule in list. */
 };
 typedef struct rule_s RULE;
 
-#ifdef BT_TARGETS
-/* TARGET data structure for binary tree of targets. */
-struct target_s
+/* RULESET data structure for the rules that build one suffix. */
+struct ruleset_s
 {
-        char            *tname;         /* Name of target file. */
-        char            *tdependents;   /* Target's dependent files. */
-        LINE            *tcommands;     /* Commands to build the target. */
-        struct target_s *tleft;         /* Pointer to next target in tree. */
-        struct target_s *tright;        /* Pointer to next target in tree. */
+        char            *sdest;         /* Destination suffix of rules. */
+        unsigned int    shash;          /* hash_name() value of sdest. */
+        RULE            **srules;       /* Rules in .SUFFIXES order. */
+        struct ruleset_s *snext;        /* Next set in hash bucket. */
 };
-typedef struct target_s TARGET;
-#else
+typedef struct ruleset_s RULESET;
+
+/* PATENT data structure for a pattern rule in the pattern index. */
+struct patent_s
+{
+        RULE            *erule;         /* Pattern rule. */
+        int             eseq;           /* Position in pattern rule list. */
+        int             eprelen;        /* Length of prefix before '%'. */
+        int             esuflen;        /* Length of suffix after '%'. */
+        struct patent_s *enext;         /* Next rule at same trie node. */
+};
+typedef struct patent_s PATENT;
+
+/* PATNODE data structure for a node of the pattern index trie. */
+struct patnode_s
+{
+        char            nchar;          /* Suffix character (lower case). */
+        struct patnode_s *nchild;       /* First node for next character. */
+        struct patnode_s *nsibling;     /* Next node at same position. */
+        PATENT          *nrules;        /* Rules whose suffix ends here. */
+};
+typedef struct patnode_s PATNODE;
+
+/* DEPEND data structure for array of a target's expanded dependents. */
+struct depend_s
+{
+        char            *dname;         /* Name of dependent (NULL at end). */
+        time_t          dtime;          /* Timestamp make_target() returned. */
+};
+typedef struct depend_s DEPEND;
+
 /* TARGET data structure for linked list of targets. */
 struct target_s
 {
         char            *tname;         /* Name of target file. */
+        unsigned int    thash;          /* hash_name() value of tname. */
         char            *tdependents;   /* Target's dependent files. */
+        DEPEND          *tdeps;         /* Expanded dependents (or NULL). */
+        time_t          ttime;          /* Target's timestamp before build. */
         LINE            *tcommands;     /* Commands to build the target. */
+        int             tshared;        /* Nonzero if tcommands is shared. */
         struct target_s *tnext;         /* Pointer to next target in list. */
 };
 typedef struct target_s TARGET;
-#endif /* BT_TARGETS */
+
+/* STATE data structure for table of targets checked during this run. */
+struct state_s
+{
+        char            *sname;         /* Name of target. */
+        int             sstate;         /* STATE_CHECKING or STATE_DONE. */
+        int             sresult;        /* Value make_target() returned. */
+        time_t          stime;          /* Timestamp make_target() returned. */
+        struct state_s  *snext;         /* Next state in hash bucket. */
+};
+typedef struct state_s STATE;
+
+/* Values for the sstate field of a state descriptor. */
+#define STATE_CHECKING  0       /* Target is being checked or built. */
+#define STATE_DONE      1       /* Target has been checked or built. */
+
+/* INFER data structure for table of inference rule chains. */
+struct infer_s
+{
+        char            *iname;         /* Name of file to be built. */
+        RULE            *irule;         /* First rule to use (or NULL). */
+        int             ilen;           /* Rules in chain (INFER_xxx). */
+        unsigned long   iseq;           /* Serial number of search. */
+        struct infer_s  *iwait;         /* Busy entry result relies on. */
+        unsigned long   iwseq;          /* Serial number of iwait. */
+        struct infer_s  *inext;         /* Next entry in hash bucket. */
+};
+typedef struct infer_s INFER;
+
+/* Special values for the ilen field of an inference descriptor. */
+#define INFER_NONE      0x7FFF  /* File can't be built by rules. */
+#define INFER_BUSY      -1      /* Chain is being searched for. */
+
+/* PHONY data structure for hash table of phony target names. */
+struct phony_s
+{
+        char            *pname;         /* Name of phony target. */
+        unsigned int    phash;          /* hash_name() value of pname. */
+        struct phony_s  *pnext;         /* Next name in hash bucket. */
+};
+typedef struct phony_s PHONY;
+
+/* RESTAT data structure for hash table of restat filenames. */
+struct restat_s
+{
+        char            *rname;         /* Filename (lowercase). */
+        unsigned int    rhash;          /* hash_name() value of rname. */
+        struct restat_s *rnext;         /* Next name in hash bucket. */
+};
+typedef struct restat_s RESTAT;
+
+/* DIGEST data structure for database of file contents digests. */
+struct digest_s
+{
+        char            *dname;         /* Name of file (lowercase). */
+        unsigned int    dhash;          /* hash_name() value of dname. */
+        int             dflags;         /* DIG_FILE, DIG_TARGET, etc. */
+        unsigned long   dtime;          /* Time/date stamp when digested. */
+        unsigned long   dsize;          /* Size of file when digested. */
+        unsigned long   dcrc;           /* Digest of file's contents. */
+        unsigned long   ddeps;          /* Digest of dependents when built. */
+        unsigned long   dout;           /* Digest of target when built. */
+        unsigned long   dcmd;           /* Digest of commands when built. */
+        unsigned long   dchanged;       /* Time contents last changed. */
+        unsigned long   dstamp;         /* Timestamp dchanged applies to. */
+        TARGET          *dtar;          /* Target checked this run. */
+        RULE            *drul;          /* Rule checked this run. */
+        char            *dsrc;          /* Rule source checked this run. */
+        struct digest_s *dnext;         /* Next entry in hash bucket. */
+};
+typedef struct digest_s DIGEST;
+
+/* Bits for the dflags field of a digest descriptor. */
+#define DIG_FILE        1       /* dtime, dsize, dcrc are valid. */
+#define DIG_TARGET      2       /* ddeps, dout are valid. */
+#define DIG_CHECKED     4       /* dtar, drul, dsrc are valid. */
+#define DIG_COMMANDS    8       /* dcmd is valid. */
+#define DIG_UNCHANGED   16      /* dchanged, dstamp are valid. */
+
+/* JOBLINK data structure for list of jobs waiting for a job. */
+struct joblink_s
+{
+        struct job_s    *ljob;          /* Job that is waiting. */
+        struct joblink_s *lnext;        /* Next link in list. */
+};
+typedef struct joblink_s JOBLINK;
+
+/* JOB data structure for linked list of queued build jobs. */
+struct job_s
+{
+        char            *jname;         /* Name of target to be built. */
+        TARGET          *jtar;          /* Target descriptor (if any). */
+        char            *jsrc;          /* Rule's source file (if any). */
+        DEPEND          *jwait;         /* Dependents to wait for. */
+        LINE            *jcmd;          /* Next command to be run. */
+        char            *jline;         /* Command that is running. */
+        int             jpid;           /* Process ID of running command. */
+        int             jstate;         /* JOB_WAITING, JOB_RUNNING, etc. */
+        int             jrestat;        /* Nonzero to check target again. */
+        time_t          jotime;         /* Target's time before commands. */
+        unsigned long   jocrc;          /* Target's digest before commands. */
+        unsigned int    jhash;          /* Hash value of lowercase name. */
+        int             jcount;         /* Unfinished jobs it waits for. */
+        JOBLINK         *jwaiters;      /* Jobs waiting for this one. */
+        struct job_s    *jhnext;        /* Next job in hash bucket. */
+        struct job_s    *jrnext;        /* Next ready or running job. */
+        struct job_s    *jnext;         /* Pointer to next job in list. */
+};
+typedef struct job_s JOB;
+
+/* CACHE data structure for index of artifact cache entries. */
+struct cache_s
+{
+        char            *cname;         /* Name of target (lowercase). */
+        unsigned long   ckey;           /* Digest of target's inputs. */
+        unsigned long   cfile;          /* Number of stored copy's file. */
+        unsigned long   cuse;           /* Sequence number of last use. */
+        unsigned long   csize;          /* Size of stored copy, in bytes. */
+        struct cache_s  *colder;        /* Entry used before this one. */
+        struct cache_s  *cnewer;        /* Entry used after this one. */
+        struct cache_s  *cnext;         /* Next entry in hash bucket. */
+};
+typedef struct cache_s CACHE;
+
+/* INCFILE data structure for list of files read by !INCLUDE. */
+struct incfile_s
+{
+        char            *iname;         /* Name of included file. */
+        LINE            *ilines;        /* Logical lines of the file. */
+        int             ionce;          /* Nonzero if file used !ONCE. */
+        struct incfile_s *inext;        /* Next file in list. */
+};
+typedef struct incfile_s INCFILE;
+
+/* ARENA data structure for memory that is all freed at once. */
+struct arena_s
+{
+        char            *aname;         /* Name shown by dump_arenas(). */
+        char            *ablock;        /* Block being filled (or NULL). */
+        unsigned int    aused;          /* Bytes used in ablock. */
+        unsigned int    asize;          /* Size of ablock, in bytes. */
+        unsigned long   abytes;         /* Bytes handed out. */
+        unsigned long   acount;         /* Number of allocations. */
+        unsigned int    ablocks;        /* Number of blocks. */
+        struct arena_s  *anext;         /* Next arena known to makemem.c. */
+};
+typedef struct arena_s ARENA;
+
+/* DENTRY data structure for one entry of a directory index. */
+struct dentry_s
+{
+        unsigned long   dtime;          /* Time/date stamp of file. */
+        unsigned long   dsize;          /* Size of file in bytes. */
+        unsigned char   dattrib;        /* DOS attributes of file. */
+};
+typedef struct dentry_s DENTRY;
+
+/* DIRIDX data structure for the index of one directory. */
+struct diridx_s
+{
+        char            *dname;         /* Drive/directory (lowercase). */
+        int             dlen;           /* Length of dname. */
+        unsigned int    dhash;          /* hash_name() value of dname. */
+        STRVEC          dnames;         /* Entry names, directory order. */
+        DENTRY          *dents;         /* Entries, same order as dnames. */
+        unsigned int    *dsorted;       /* Entry numbers sorted by name. */
+        unsigned int    dmax;           /* Entries dents/dsorted hold. */
+        unsigned int    dstale;         /* Number of stale entries. */
+        unsigned int    dprobes;        /* Lookups that went to DOS. */
+        int             dstate;         /* State of index (DIR_xxx). */
+        struct diridx_s *dnext;         /* Next directory in list. */
+};
+typedef struct diridx_s DIRIDX;
+
+/* Values for the dstate field of a directory index. */
+#define DIR_UNREAD      0       /* Directory hasn't been read yet. */
+#define DIR_READ        1       /* Entries have been read. */
+#define DIR_UNUSABLE    2       /* Directory can't be indexed. */
+
+/* Bit set in the dattrib field of an entry make may have changed. */
+#define DENT_STALE      0x80
+
+/* Values for the jstate field of a job descriptor. */
+#define JOB_WAITING     0       /* Waiting for its dependents. */
+#define JOB_RUNNING     1       /* Commands are being run. */
+#define JOB_DONE        2       /* All commands completed. */
 
 /******************************* VARIABLES **************************/
 
@@ -179,6 +477,9 @@ EXT char **mkenvp;
 /* mkname:  Pointer to program's name from argv[0]. */
 EXT char *mkname;
 
+/* maxjobs:  Maximum number of commands to run at once. */
+EXT int maxjobs;
+
 /******************************* HEADERS ****************************/
 
 /* Functions that are 'exported' from modules are declared here. */
@@ -204,45 +505,125 @@ int     mchdir(LPSTR dname);
 int     mopen_r(char *);
 int     mclose(int);
 int     mread(int, char *, int);
+int     mcreat(char *);
+int     mwrite(int, char *, int);
 int     mstat(char *fname, struct mstat_t *tstat);
+int     mexists(char *fname);
+void    init_mstat(void);
+void    flush_mstat(void);
+void    forget_mstat(char *fname);
+void    dump_mstat(void);
 char    *enumpath(int flag, char *envvar);
 void    errmsg(char *msg, char *sval, int dval);
 void    free_lines(LINE *);
-LINE    *append_line(LINE *lhead, char *s);
 LINE    *create_line(char *s);
-LINE    *dup_lines(LINE *lorg);
+void    init_list(LIST *list);
+int     add_to_list(LIST *list, char *s);
+void    flush_list(LIST *list);
+char    *grow_block(char *ptr, unsigned int used, unsigned int size);
+void    init_strvec(STRVEC *vec);
+int     add_strvec(STRVEC *vec, char *s);
+void    flush_strvec(STRVEC *vec);
 int     cindex(char *s, char c);
+unsigned int hash_name(char *s);
+
+/* From makedir.c: */
+void    init_dirs(void);
+void    flush_dirs(void);
+void    forget_dirent(char *fname);
+DIRIDX  *scan_dir(char *fspec);
+int     dir_mstat(char *fname, struct mstat_t *tstat);
+void    dump_dirs(void);
 
 /* From makein.c: */
 int     read_logical_line(int handle, char *str, int maxlen);
 int     unread_logical_line(char *str);
 int     process_makefile(char *mf);
+void    flush_includes(void);
+char    *enum_include(int index);
 
 /* From makexpnd.c: */
 int     expand_named_macros(char *src, char *dest, int maxlen);
-LINE    *expand_dependents(TARGET *tar);
-LINE    *expand_wildcard(char *fspec);
-int     expand_tarspecial(char *src, char *dest, int maxlen,
-                        char *tfile, char *sfile);
+int     expand_dependents(TARGET *tar);
+int     expand_wildcard(char *fspec, STRVEC *vec);
+CMDPART *compile_command(char *line);
 
 /* From makebld.c: */
+void    init_states(void);
+void    flush_states(void);
+int     timestamp_up_to_date(time_t t1, time_t t2);
+int     check_command(char *cmd, int result);
+int     run_command(char *cmd, int *pid);
+int     expand_command(char *tname, TARGET *tar, char *rsrc,
+                        LINE *line, char *cmd, int sig);
 int     make_target(char *tname, int level, time_t *hitime);
 
+/* From makedig.c: */
+void    init_digests(void);
+void    flush_digests(void);
+int     load_digests(char *dbname);
+int     save_digests(void);
+int     file_digest(char *fname, unsigned long *crc);
+int     check_digest(char *tname, TARGET *tar, RULE *rul, char *srcname);
+void    commit_digest(char *tname);
+int     digest_key(char *tname, unsigned long *key);
+unsigned long crc_block(unsigned long crc, char *p, unsigned n);
+unsigned long crc_long(unsigned long crc, unsigned long val);
+void    mark_unchanged(char *tname, time_t otime, time_t ntime);
+void    mark_changed(char *tname);
+time_t  last_changed(char *tname, time_t ftime);
+
+/* From makeexec.c: */
+int     spawn_command(int mode, char *line);
+
+/* From makecach.c: */
+void    init_cache(void);
+void    flush_cache(void);
+int     load_cache(char *dname, long maxkb);
+int     save_cache(void);
+int     fetch_cache(char *tname);
+void    store_cache(char *tname);
+void    report_cache(void);
+
+/* From makejob.c: */
+void    init_jobs(void);
+void    flush_jobs(void);
+int     queue_job(char *tname, TARGET *tar, RULE *rul, char *srcname);
+JOB     *find_job(char *tname);
+int     run_jobs(void);
+
 /* From maketar.c: */
 void    init_targets(void);
 void    flush_targets(void);
 void    dump_targets(void);
 int     define_target(char *line, int handle);
 TARGET  *find_target(char *tname);
+void    *target_alloc(size_t bytes);
 char    *default_target(void);
+int     save_targets(void);
+int     load_targets(void);
 
 /* From makerul.c: */
 void    init_rules(void);
 void    flush_rules(void);
 void    dump_rules(void);
 int     define_rule(char *line, int handle);
-int     check_rules(char *suf);
+RULE    **find_rules(char *dest);
+void    forget_rule_index(void);
 RULE    *lookup_rule(char *src, char *dest);
+int     rule_source(RULE *rul, char *tname, char *srcname);
+void    rule_name(RULE *rul, char *name);
+int     save_rules(void);
+int     load_rules(void);
+
+/* From makepat.c: */
+void    init_patterns(void);
+void    flush_patterns(void);
+void    dump_patterns(void);
+int     define_pattern(char *line, int handle);
+int     find_patterns(char *tname, RULE **rules);
+int     save_patterns(void);
+int     load_patterns(void);
 
 /* From makemac.c: */
 void    init_macros(void);
@@ -251,6 +632,9 @@ void    dump_macros(void);
 int     predefine_macros(void);
 int     define_macro(char *line, int handle);
 char    *find_macro(char *mname);
+char    *expand_macro(char *mname);
+int     save_macros(void);
+int     load_macros(void);
 
 /* From makemem.c: */
 int     mem_init(void);
@@ -258,6 +642,11 @@ int     mem_deinit(void);
 void    *mem_alloc(size_t bytes);
 void    mem_free(void *ptr);
 void    mem_heapmin(void);
+void    arena_init(ARENA *arena, char *aname);
+void    *arena_alloc(ARENA *arena, size_t bytes);
+char    *arena_strdup(ARENA *arena, char *s);
+void    arena_release(ARENA *arena);
+void    dump_arenas(void);
 
 /* From makeprec.c: */
 void    init_precious(void);
@@ -265,6 +654,43 @@ void    flush_precious(void);
 void    dump_precious(void);
 int     do_precious(char *line);
 int     is_precious(char *tname);
+int     save_precious(void);
+int     load_precious(void);
+
+/* From makephon.c: */
+void    init_phony(void);
+void    flush_phony(void);
+void    dump_phony(void);
+int     do_phony(char *line);
+int     is_phony(char *tname);
+int     save_phony(void);
+int     load_phony(void);
+
+/* From makerst.c: */
+void    init_restat(void);
+void    flush_restat(void);
+void    dump_restat(void);
+int     do_restat(char *line);
+int     is_restat(char *tname);
+int     begin_restat(char *tname, time_t *otime, unsigned long *ocrc);
+void    end_restat(char *tname, time_t otime, unsigned long ocrc);
+int     uses_restat(void);
+int     save_restat(void);
+int     load_restat(void);
+
+/* From makesnap.c: */
+unsigned long snapshot_key(int argc, char *argv[], char *envp[],
+                        char *mfname, char *ifname);
+int     load_snapshot(char *sname, unsigned long key);
+int     save_snapshot(char *sname, unsigned long key, unsigned int pflags);
+int     put_snap_word(unsigned val);
+int     put_snap_long(unsigned long val);
+int     put_snap_str(char *s);
+int     put_snap_lines(LINE *lptr);
+unsigned get_snap_word(void);
+unsigned long get_snap_long(void);
+char    *get_snap_str(void);
+int     get_snap_lines(LIST *list);
 
 /* From makesuf.c: */
 void    init_suffixes(void);
@@ -272,6 +698,8 @@ void    flush_suffixes(void);
 void    dump_suffixes(void);
 int     do_suffixes(char *line);
 char    *enum_suffix(int index);
+int     save_suffixes(void);
+int     load_suffixes(void);
 
 #ifdef WIN
 /* From makew.c: */
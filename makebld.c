@@ -46,177 +46,374 @@ function.
 
 /* Functions local to this file: */
 //static int    expand_smacros(char *src, char *dest, char *tfile, char *sfile);
-static int      run_command(char *cmd);
 static int      run_commands(char *tname, TARGET *tar, RULE *rul);
 static RULE     *find_rule(char *tname, char *srcname);
-static int      timestamp_up_to_date(time_t t1, time_t t2);
 static int      make_dependents(TARGET *tar, int level, time_t *hitime);
-static int      expand_dspecial(TARGET *tar, char *cmd);
+static int      is_newer(TARGET *tar, DEPEND *dep);
+static int      add_to_command(char *cmd, int *pos, char *p, int n,
+                        char *line);
+static STATE    *find_state(char *tname);
+static STATE    *add_state(char *tname);
+static INFER    *infer_rule(char *fname);
+static int      build_phony(char *tname, int level, time_t *hitime);
+static int      build_target(char *tname, int level, time_t *hitime);
 //static int    expand_special(char *tname, char *src, char *cmd);
 
 /****************************** CONSTANTS ***************************/
 
-/* Maximum number of arguments per subprocess command line. */
-#define MAXARGS         20
+/* Number of hash buckets in the target state table. */
+#define STATE_HASH_SIZE 64
+
+/* Number of hash buckets in the inference rule chain table. */
+#define INFER_HASH_SIZE 64
+
+/****************************** VARIABLES ***************************/
+
+/*
+** state_table:  Hash table of the targets that make_target() has
+** checked during this run, so that a target that is a dependent of
+** many other targets is only checked once.
+*/
+static STATE *state_table[STATE_HASH_SIZE];
+
+/*
+** infer_table:  Hash table of the files that infer_rule() has
+** looked for rule chains for, with the results, so that each
+** file's chain is only searched for once during a run.
+*/
+static INFER *infer_table[INFER_HASH_SIZE];
+
+/* Memory for the inference rule chain table. */
+static ARENA infer_arena;
+
+/* infer_seq:  Serial number of the last search infer_rule() began. */
+static unsigned long infer_seq;
 
 /*************************** LOCAL FUNCTIONS ************************/
 
 /*
-** find_rule:
-** Attempts to find a rule that can be used to build a particular
-** undescribed target file.  Also, verifies the existance of the
-** source file necessary to use the rule.
+** find_state:
+** Searches the target state table for a particular target.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      tname   Name of target file.
-**      srcname Buffer to return name of source file to go with
-**              rule in.
+**      tname   Name of target to search for.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      NULL    No rule was found that can be used to build the
-**              specified target file.
-**      other   Pointer to rule to build target file.
+**      NULL    Target hasn't been checked during this run.
+**      other   Pointer to target's state descriptor.
 */
-static RULE *
-find_rule(tname, srcname)
+static STATE *
+find_state(tname)
         char    *tname;
-        char    *srcname;
 {
-        int     sindex = 0;                     /* Index into suffixes list. */
-        char    tsuffix[MAX_SUFFIX_STR + 1];    /* Target file's suffix. */
-        char    *suffix;                        /* Pointer to source suffix. */
-        RULE    *rptr;                          /* Pointer to rule. */
-
-        /* Extract the suffix portion of the target filename. */
-        get_part_filename(4, tname, tsuffix);
-        if (tsuffix[0] == '\0')
+        STATE   *sptr;
+
+        sptr = state_table[hash_name(tname) % STATE_HASH_SIZE];
+        while (sptr != (STATE *)NULL)
+        {
+                if (strcmp(tname, sptr->sname) == 0)
+                        return sptr;
+                sptr = sptr->snext;
+        }
+
+        return (STATE *)NULL;
+}
+
+/*
+** add_state:
+** Adds a target to the target state table, marking it as
+** being checked.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to add.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Out of memory.
+**      other   Pointer to target's new state descriptor.
+*/
+static STATE *
+add_state(tname)
+        char    *tname;
+{
+        STATE   *sptr;
+        int     bucket;
+
+        /* Allocate memory for state descriptor and name. */
+        sptr = (STATE *)mem_alloc(sizeof(STATE));
+        if (sptr == (STATE *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return (STATE *)NULL;
+        }
+        sptr->sname = (char *)mem_alloc(strlen(tname) + 1);
+        if (sptr->sname == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                mem_free(sptr);
+                return (STATE *)NULL;
+        }
+        strcpy(sptr->sname, tname);
+        sptr->sstate = STATE_CHECKING;
+        sptr->sresult = 0;
+        sptr->stime = 0L;
+
+        /* Place state descriptor at head of its hash bucket. */
+        bucket = hash_name(tname) % STATE_HASH_SIZE;
+        sptr->snext = state_table[bucket];
+        state_table[bucket] = sptr;
+
+        return sptr;
+}
+
+/*
+** infer_rule:
+** Finds the shortest chain of inference rules that can build a
+** file, starting from a file that exists or is described in the
+** makefile.  For example, with ".y.c" and ".c.obj" rules, and
+** "test.y" in the current directory, "test.obj" can be built
+** from "test.c", which in turn can be built from "test.y".
+** Pattern rules are tried before ".src.dest" rules, in the
+** order find_patterns() returns them.  Chains of the same
+** length are chosen by the order the rules are tried in,
+** which for ".src.dest" rules is the order of their source
+** suffixes in the suffixes list.  The result for each
+** file is kept in infer_table, so the chains for a tree of
+** generated files are only searched once.
+**
+** A file that is being searched for is marked busy, so a chain
+** can't loop back to it.  If a file's result was found while
+** some other file was busy, it may have missed a chain through
+** that file, so iwait records the busy file the result relies
+** on.  The result is only used while that search is still
+** going on; after it ends, the file is searched for again.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to be built.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Out of memory.
+**      other   Pointer to file's inference descriptor.  If the
+**              file can't be built by rules, irule is NULL and
+**              ilen is INFER_NONE.  While the file's chain is
+**              being searched for, ilen is INFER_BUSY.
+*/
+static INFER *
+infer_rule(fname)
+        char    *fname;
+{
+        INFER   *iptr;                  /* File's descriptor. */
+        INFER   *sptr;                  /* Source's descriptor. */
+        INFER   *wptr;                  /* Busy entry source relies on. */
+        unsigned long wseq;             /* Serial number of wptr. */
+        RULE    *best;                  /* Rule with shortest chain. */
+        int     len;                    /* Length of best's chain. */
+        RULE    *pats[MAX_PATMATCH + 1]; /* Pattern rules for the file. */
+        RULE    **lists[2];             /* Pattern and suffix rules. */
+        RULE    **rptr;
+        char    *suffix;                /* File's suffix. */
+        char    srcname[MAXPATH];       /* Name of source file. */
+        int     bucket;
+        int     l;
+
+        /* See if the file was already searched for. */
+        bucket = hash_name(fname) % INFER_HASH_SIZE;
+        for (iptr = infer_table[bucket]; iptr != (INFER *)NULL;
+                iptr = iptr->inext)
+        {
+                if (strcmp(fname, iptr->iname) == 0)
+                        break;
+        }
+        if (iptr != (INFER *)NULL)
         {
                 /*
-                ** The target file has no suffix, so it can't be
-                ** matched against a rule.
+                ** Use the result unless it relies on a search
+                ** that has since ended.
                 */
-                return (RULE *)NULL;
+                if (iptr->ilen == INFER_BUSY ||
+                        iptr->iwait == (INFER *)NULL ||
+                        (iptr->iwait->ilen == INFER_BUSY &&
+                        iptr->iwait->iseq == iptr->iwseq))
+                {
+                        return iptr;
+                }
+        }
+        else
+        {
+                /* Add the file. */
+                iptr = (INFER *)arena_alloc(&infer_arena, sizeof(INFER));
+                if (iptr == (INFER *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return (INFER *)NULL;
+                }
+                iptr->iname = arena_strdup(&infer_arena, fname);
+                if (iptr->iname == (char *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return (INFER *)NULL;
+                }
+                iptr->inext = infer_table[bucket];
+                infer_table[bucket] = iptr;
         }
 
+        /* Mark the file busy so a chain can't loop back to it. */
+        iptr->irule = (RULE *)NULL;
+        iptr->ilen = INFER_BUSY;
+        iptr->iseq = ++infer_seq;
+        iptr->iwait = (INFER *)NULL;
+        iptr->iwseq = 0L;
+
+        /* Get the pattern rules, and the rules for the file's suffix. */
+        find_patterns(fname, pats);
+        lists[0] = pats;
+        suffix = strrchr(fname, '.');
+        if (suffix == (char *)NULL || strchr(suffix, '\\') != (char *)NULL)
+                lists[1] = (RULE **)NULL;
+        else
+                lists[1] = find_rules(suffix + 1);
+
         /*
-        ** Check if it's worth our time to test all the suffixes
-        ** with the rule list.
+        ** First look for a single rule whose source file exists
+        ** or is described in the makefile.
         */
-        if (!check_rules(tsuffix))
+        for (l = 0; l < 2; l++)
         {
-                /* Don't bother. */
-                return (RULE *)NULL;
+                for (rptr = lists[l]; rptr != (RULE **)NULL &&
+                        *rptr != (RULE *)NULL; rptr++)
+                {
+                        if (!rule_source(*rptr, fname, srcname))
+                                continue;
+                        if (mexists(srcname) ||
+                                find_target(srcname) != (TARGET *)NULL)
+                        {
+                                iptr->irule = *rptr;
+                                iptr->ilen = 1;
+                                return iptr;
+                        }
+                }
         }
 
         /*
-        ** Try each possible suffix for a rule until we find
-        ** one that works or run out of suffixes.
+        ** Otherwise, use the rule whose source file can be built
+        ** by the shortest chain of other rules.  Remember the most
+        ** recently started busy search that any source's result
+        ** relies on, not counting this file's own search; it is
+        ** the last of them to end.  The file stays busy until
+        ** all of its sources have been tried.
         */
-        while ((suffix = enum_suffix(sindex)) != (char *)NULL)
+        best = (RULE *)NULL;
+        len = INFER_NONE;
+        for (l = 0; l < 2; l++)
         {
-                /*
-                ** Make sure suffix isn't the same as target's
-                ** suffix before looking for a rule.
-                */
-                if (strcmp(suffix, tsuffix) != 0)
+                for (rptr = lists[l]; rptr != (RULE **)NULL &&
+                        *rptr != (RULE *)NULL; rptr++)
                 {
-                        /* Look for a rule for this suffix. */
-                        if ((rptr = lookup_rule(suffix, tsuffix)) !=
-                                (RULE *)NULL)
+                        if (!rule_source(*rptr, fname, srcname))
+                                continue;
+                        sptr = infer_rule(srcname);
+                        if (sptr == (INFER *)NULL)
+                                return (INFER *)NULL;
+                        if (sptr->ilen == INFER_BUSY)
                         {
-                                if (CHKFLAG(FLAG_DEBUG))
-                                {
-                                        /*
-                                        ** Tell the user we have a
-                                        ** rule that might work.
-                                        */
-                                        mputs(MSG_DBG_POSSIBLERULE);
-                                        mputs(".");
-                                        mputs(rptr->rsrc);
-                                        mputs(".");
-                                        mputs(rptr->rdest);
-                                        mputs("\n");
-                                }
-
-                                /*
-                                ** We have a matching rule, so see if
-                                ** there is a source file we can use
-                                ** with it.
-                                */
-
-                                /* Build name of potential source file. */
-                                get_part_filename(5, tname, srcname);
-                                strcat(srcname, ".");
-                                strcat(srcname, rptr->rsrc);
-
-                                /* Check if source file exists. */
-                                if (access(srcname, 444) == 0)
+                                wptr = sptr;
+                                wseq = sptr->iseq;
+                        }
+                        else
+                        {
+                                wptr = sptr->iwait;
+                                wseq = sptr->iwseq;
+                                if (sptr->ilen != INFER_NONE &&
+                                        sptr->ilen + 1 < len)
                                 {
-                                        /*
-                                        ** The source file exists, so
-                                        ** return the rule to the caller.
-                                        */
-                                        if (CHKFLAG(FLAG_DEBUG))
-                                        {
-                                                mputs(MSG_DBG_HAVEMATCH);
-                                                mputs(srcname);
-                                                mputs("\n");
-                                        }
-                                        return rptr;
+                                        best = *rptr;
+                                        len = sptr->ilen + 1;
                                 }
                         }
+                        if (wptr != (INFER *)NULL && wptr != iptr &&
+                                wseq > iptr->iwseq)
+                        {
+                                iptr->iwait = wptr;
+                                iptr->iwseq = wseq;
+                        }
                 }
-
-                /* Try next suffix in suffixes list. */
-                sindex++;
         }
+        iptr->irule = best;
+        iptr->ilen = len;
 
-        /* No matching rules. */
-        return (RULE *)NULL;
+        return iptr;
 }
 
 /*
-** timestamp_up_to_date:
-** Checks to see if a timestamp is up to date with respect to another
-** timestamp.  If the 'CHKFLAG(FLAG_NEEDNEWER)' flag is enabled, the first
-** timestamp must be newer than the second timestamp to be considered
-** up to date; otherwise the first timestamp must be the same as or
-** newer than the second timestamp to be considered up to date.
+** find_rule:
+** Attempts to find a rule that can be used to build a particular
+** undescribed target file.  The rule's source file either exists,
+** is described in the makefile, or can be built by a chain of
+** other rules (see infer_rule()).
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      t1      First timestamp to check.
-**      t2      Second tiemstamp to check.
+**      tname   Name of target file.
+**      srcname Buffer to return name of source file to go with
+**              rule in.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       First timestamp is up-to-date with respect to the
-**              second.
-**      0       First timestamp is not up-to-date with respect to
-**              the second.
+**      NULL    No rule was found that can be used to build the
+**              specified target file.
+**      other   Pointer to rule to build target file.
 */
-static int
-timestamp_up_to_date(t1, t2)
-        time_t  t1;
-        time_t  t2;
+static RULE *
+find_rule(tname, srcname)
+        char    *tname;
+        char    *srcname;
 {
-        if (CHKFLAG(FLAG_NEEDNEWER))
+        INFER   *iptr;          /* Target's inference descriptor. */
+        RULE    *rptr;          /* Pointer to rule. */
+        char    name[MAXPATH];  /* Name of rule. */
+
+        iptr = infer_rule(tname);
+        if (iptr == (INFER *)NULL || iptr->irule == (RULE *)NULL)
         {
-                if (t1 > t2)
-                        return 1;
+                /* No matching rules. */
+                return (RULE *)NULL;
         }
-        else
+        rptr = iptr->irule;
+
+        /* Build name of source file. */
+        rule_source(rptr, tname, srcname);
+
+        if (CHKFLAG(FLAG_DEBUG))
         {
-                if (t1 >= t2)
-                        return 1;
+                /* Tell the user which rule will be used. */
+                rule_name(rptr, name);
+                mputs(MSG_DBG_POSSIBLERULE);
+                mputs(name);
+                mputs("\n");
+                mputs(MSG_DBG_HAVEMATCH);
+                mputs(srcname);
+                if (iptr->ilen > 1)
+                {
+                        mputs(MSG_DBG_RULECHAIN);
+                        mputs(mutoa(iptr->ilen));
+                }
+                mputs("\n");
         }
-        return 0;
+
+        return rptr;
 }
 
 /*
@@ -244,15 +441,12 @@ make_dependents(tar, level, hitime)
         int     level;
         time_t  *hitime;
 {
-        LINE    *dptr;
-        LINE    *lptr;
-        time_t  tmptime;
+        DEPEND  *dptr;
 
         *hitime = 0L;
 
         /* Expand the list of dependent files. */
-        dptr = expand_dependents(tar);
-        if (dptr == (LINE *)NULL)
+        if (!expand_dependents(tar))
         {
                 /* Error expanding dependent list. */
                 return 0;
@@ -263,543 +457,299 @@ make_dependents(tar, level, hitime)
                 mputs(MSG_DBG_CHKDEPS);
                 mputs(tar->tname);
                 mputs("\n");
-                lptr = dptr;
-                while (lptr != (LINE *)NULL)
+                for (dptr = tar->tdeps; dptr->dname != (char *)NULL; dptr++)
                 {
                         mputs(MSG_DBG_DEPNAME);
-                        mputs(lptr->ldata);
+                        mputs(dptr->dname);
                         mputs("\n");
-                        lptr = lptr->lnext;
                 }
         }
 
-        /* Process each dependent file in the list. */
-        lptr = dptr;
-        while (lptr != (LINE *)NULL)
+        /*
+        ** Process each dependent file in the list, saving the
+        ** timestamp of each one for the '$?' macro.
+        */
+        for (dptr = tar->tdeps; dptr->dname != (char *)NULL; dptr++)
         {
-                if (!make_target(lptr->ldata, level + 1, &tmptime))
+                if (!make_target(dptr->dname, level + 1, &dptr->dtime))
                 {
                         /* Error making dependent file. */
-                        free_lines(dptr);
                         return 0;
                 }
-                if (tmptime > *hitime)
-                        *hitime = tmptime;
-
-                lptr = lptr->lnext;
+                if (dptr->dtime > *hitime)
+                        *hitime = dptr->dtime;
         }
 
-        free_lines(dptr);
         return 1;
 }
 
 /*
-** expand_dspecial:
-** Expands the special macros "$**" and "$?" that appear in
-** the specified command line.
+** is_newer:
+** Checks if a dependent belongs in the '$?' macro of a target,
+** using the timestamps saved by make_dependents(), so that the
+** file doesn't have to be checked again.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      tar     Pointer to target descriptor of target file.
-**      cmd     Command line to be expanded.
+**      tar     Pointer to target descriptor.
+**      dep     Pointer to one of the target's dependents.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       Successful.
-**      0       Error occurred (undefined macro, command too long).
+**      1       Dependent is out of date with respect to target.
+**      0       Dependent is not out of date.
 */
 static int
-expand_dspecial(tar, cmd)
+is_newer(tar, dep)
         TARGET  *tar;
-        char    *cmd;
+        DEPEND  *dep;
 {
-        char    *tname = tar->tname;
-        char    *tmp;
-        int     tpos = 0;
-        int     cpos = 0;
-        int     i = 0;
-        LINE    *dptr;
-        LINE    *lptr;
-
-        if (cindex(cmd, '$') < 0)
-        {
-                /* No dspecial macros to expand; quick success. */
-                return 1;
-        }
-
-        /* Allocate memory for temporary buffer. */
-        tmp = (char *)mem_alloc(MAXLLINE);
-        if (tmp == (char *)NULL)
-        {
-                /* Not enough memory. */
-                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                return 0;
-        }
-
-        if (tar->tdependents == (char *)NULL)
-        {
-                /* Target has no dependents. */
-                mem_free(tmp);
+        /*
+        ** Every dependent counts if the target didn't exist, or
+        ** is being built regardless of timestamps.
+        */
+        if (tar->ttime == 0L || CHKFLAG(FLAG_BUILD_ANYWAY | FLAG_DIGEST))
                 return 1;
-        }
-        dptr = expand_dependents(tar);
-        if (dptr == (LINE *)NULL)
-        {
-                /* Error expanding dependents list. */
-                mem_free(tmp);
-                return 0;
-        }
-
-        while (cmd[cpos] != '\0')
-        {
-                if (cmd[cpos] == '$')
-                {
-                        cpos++;
-                        if (cmd[cpos] == '?')
-                        {
-                                cpos++;
-                                lptr = dptr;
-                                while (lptr != (LINE *)NULL)
-                                {
-                                        if (tpos + strlen(lptr->ldata) + 1 >=
-                                                MAXLLINE)
-                                        {
-                                                errmsg(MSG_ERR_EXPTOOLONG,
-                                                        cmd, NOVAL);
-                                                free_lines(dptr);
-                                                mem_free(tmp);
-                                                return 0;
-                                        }
-                                        tmp[tpos] = '\0';
-                                        strcat(tmp, lptr->ldata);
-                                        strcat(tmp, " ");
-                                        tpos = strlen(tmp);
-                                        lptr = lptr->lnext;
-                                }
-                        }
-                        else if (cmd[cpos] == '*')
-                        {
-                                cpos++;
-                                if (cmd[cpos] == '*')
-                                {
-                                        cpos++;
-                                        lptr = dptr;
-                                        while (lptr != (LINE *)NULL)
-                                        {
-                                                if (tpos + strlen(lptr->ldata)
-                                                        + 1 >= MAXLLINE)
-                                                {
-                                                        errmsg(
-                                                        MSG_ERR_EXPTOOLONG,
-                                                                cmd, NOVAL);
-                                                        free_lines(dptr);
-                                                        mem_free(tmp);
-                                                        return 0;
-                                                }
-                                                tmp[tpos] = '\0';
-                                                strcat(tmp, lptr->ldata);
-                                                strcat(tmp, " ");
-                                                tpos = strlen(tmp);
-                                                lptr = lptr->lnext;
-                                        }
-                                }
-                                else
-                                {
-                                        if (tpos >= MAXLLINE - 1)
-                                        {
-                                                errmsg(MSG_ERR_EXPTOOLONG,
-                                                        cmd, NOVAL);
-                                                free_lines(dptr);
-                                                mem_free(tmp);
-                                                return 0;
-                                        }
-                                        tmp[tpos++] = '$';
-                                        tmp[tpos++] = '*';
-                                }
-                        }
-                        else
-                        {
-                                if (tpos >= MAXLLINE - 1)
-                                {
-                                        errmsg(MSG_ERR_EXPTOOLONG,
-                                                cmd, NOVAL);
-                                        free_lines(dptr);
-                                        mem_free(tmp);
-                                        return 0;
-                                }
-                                tmp[tpos++] = '$';
-                                tmp[tpos++] = cmd[cpos++];
-                        }
-                }
-                else
-                {
-                        if (tpos >= MAXLLINE)
-                        {
-                                errmsg(MSG_ERR_EXPTOOLONG,
-                                        cmd, NOVAL);
-                                free_lines(dptr);
-                                mem_free(tmp);
-                                return 0;
-                        }
-                        tmp[tpos++] = cmd[cpos++];
-                }
-        }
 
-        tmp[tpos] = '\0';
+        /* A dependent being built by a job is TIME_PENDING. */
+        return !timestamp_up_to_date(tar->ttime, dep->dtime);
+}
 
-        if (strlen(tmp) > MAXPATH)
+/*
+** add_to_command:
+** Adds text to a command line being expanded.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cmd     Buffer of MAXPATH bytes holding command line.
+**      pos     Pointer to length of command line so far.
+**      p       Text to add.
+**      n       Number of characters to add.
+**      line    Command line being expanded, for error message.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Command line would be too long.
+*/
+static int
+add_to_command(cmd, pos, p, n, line)
+        char    *cmd;
+        int     *pos;
+        char    *p;
+        int     n;
+        char    *line;
+{
+        if (*pos + n >= MAXPATH)
         {
                 /*
                 ** The expanded command line exceeds the maximum length
                 ** for a command line.
                 */
-                errmsg(MSG_ERR_CMDMACROLEN, tmp, NOVAL);
-                mem_free(tmp);
+                errmsg(MSG_ERR_CMDMACROLEN, line, NOVAL);
                 return 0;
         }
+        memcpy(&cmd[*pos], p, n);
+        *pos += n;
 
-        /* Release dependent list memory. */
-        free_lines(dptr);
-
-        /* Return expanded command line to caller. */
-        strcpy(cmd, tmp);
-
-        mem_free(tmp);
         return 1;
 }
 
 /*
-** run_command:
-** Executes a command and tests the return code.
+** run_commands:
+** Runs a list of subprocesses.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      cmd     String containing command to be executed.
+**      tname   Name of target being built.
+**      tar     Target descriptor for target being built (if any).
+**      rul     Rule descriptor for rule being used (if any).
+**
+** Either tar or rul may be NULL, but not both.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       Successful (or return code was ignored).
-**      0       Command could not be executed or return code
-**              was non-zero.
+**      1       Successful.
+**      0       Error occurred.
 */
 static int
-run_command(cmd)
-        char    *cmd;
+run_commands(tname, tar, rul)
+        char    *tname;
+        TARGET  *tar;
+        RULE    *rul;
 {
-        char    margc;
-        char    argbfr[MAXPATH];
-        char    *margv[MAXARGS];
-#ifdef WIN
-        char    stmp[MAXPATH];
-#endif /* WIN */
-        int     i;
-        int     result;
+        LINE    *lptr;
+        char    cmd[MAXPATH];
+        char    rfile[MAXPATH];
+        char    *rsrc = (char *)NULL;
+        int     restat;
+        time_t  otime;
+        unsigned long ocrc;
 
-        /* Make sure the command line isn't too long. */
-        if (strlen(cmd) > MAXPATH)
-        {
-                errmsg(MSG_ERR_CMDTOOLONG, cmd, NOVAL);
-                return 0;
-        }
+        /* See if a copy of the target can be restored instead. */
+        if (CHKFLAG(FLAG_CACHE) && fetch_cache(tname))
+                return 1;
 
-        /* Zero arguments. */
-        for (i = 0; i < MAXARGS; i++)
-        {
-                margv[i] = (char *)NULL;
-        }
+        /* Remember the target as it was, if it is to be checked again. */
+        restat = begin_restat(tname, &otime, &ocrc);
 
-        /*
-        ** If user put '!' before the command, then complain.  This is
-        ** what Microsoft NMAKE uses to reexecute the command once for
-        ** each of the target's dependent files.
-        */
-        if (cmd[0] == '!')
+        /* Assume we will use commands from target descriptor. */
+        if (tar != (TARGET *)NULL)
+                lptr = tar->tcommands;
+
+        /* Check if rule was specified. */
+        if (rul != (RULE *)NULL)
         {
-                /* We don't implement this, so complain to the user. */
-                errmsg(MSG_ERR_NOBANG, cmd, NOVAL);
-                return 0;
-        }
+                /* Build source filename for rule. */
+                rule_source(rul, tname, rfile);
 
-        /*
-        ** Copy the command string to a local buffer where we
-        ** can munge it for spawnvp().
-        */
-        if (cmd[0] == '@' || cmd[0] == '-' || cmd[0] == '!')
-                strcpy(argbfr, &cmd[1]);
-        else
-                strcpy(argbfr, &cmd[0]);
+                /* Change pointer to source from NULL to filename. */
+                rsrc = rfile;
 
-        /* Display the command unless display is disabled. */
-        if (!CHKFLAG(FLAG_NO_SHOW) && cmd[0] != '@')
-        {
-                mputs(argbfr);
-                mputs("\n");
+                /* Use commands list from rule. */
+                lptr = rul->rcommands;
         }
 
-        /*
-        ** If make is running in display only mode, then don't actually
-        ** run the command.
-        */
-        if (CHKFLAG(FLAG_NOSPAWN))
+        /* Process each command in the list. */
+        while (lptr != (LINE *)NULL)
         {
-                return 1;
-        }
-
-        /* Release unused memory to system before calling subprocess. */
-        mem_heapmin();
-
 #ifdef WIN
-        result = wrun(argbfr);
-        if (result != 0 && cmd[0] != '-')
-        {
-                if (result == -1)
-                {
-                        /* Can't execute the command.  Complain. */
-                        errmsg(MSG_ERR_CANTEXEC, argbfr, (int)errno);
-                        return 0;
-                }
-                else
+                /* Check if user aborted. */
+                if (check_abort())
+                        return 1;
+#endif /* WIN */
+
+                /* Expand the command line. */
+                if (!expand_command(tname, tar, rsrc, lptr, cmd, 0))
                 {
-                        /*
-                        ** Command had non-zero return code.
-                        ** Complain to the user.
-                        */
-                        errmsg(MSG_ERR_RETCODE, (char *)NULL, result);
+                        /* Macro expansion error. */
                         return 0;
                 }
-        }
-#else /* !WIN */
-        /*
-        ** If command contains I/O redirection, then use system() instead
-        ** of spawnvp().
-        */
-        if (cindex(argbfr, '<') >= 0 ||
-                cindex(argbfr, '>') >= 0 ||
-                cindex(argbfr, '|') >= 0)
-        {
-                /* Run command using system() to handle redirection. */
-                result = system(argbfr);
 
-                /*
-                ** If the process return code was nonzero, generate an
-                ** error, unless we were told to ignore the return code.
-                */
-                if (result != 0 && !CHKFLAG(FLAG_IGNORE) && cmd[0] != '-')
+                /* The command may change the target file. */
+                forget_mstat(tname);
+
+                /* Run the command. */
+                if (!run_command(cmd, (int *)NULL))
                 {
-                        if (result == -1)
-                        {
-                                /* Can't execute the command.  Complain. */
-                                errmsg(MSG_ERR_CANTEXEC, margv[0], (int)errno);
-                                return 0;
-                        }
-                        else
+                        /* Couldn't run the command. */
+                        if (!is_precious(tname) && !is_phony(tname))
                         {
                                 /*
-                                ** Command had non-zero return code.
-                                ** Complain to the user.
+                                ** Remove the potentially
+                                ** incorrect target file.
                                 */
-                                errmsg(MSG_ERR_RETCODE, (char *)NULL, result);
-                                return 0;
+                                unlink(tname);
                         }
-                }
-
-                return 1;
-        }
-
-        /* Split the command into individual arguments for spawnvp(). */
-        i = 0;
-        margv[0] = &argbfr[0];
-        margc = 0;
-        while (argbfr[i] != '\0')
-        {
-                margc++;
-                while (argbfr[i] != ' ' &&
-                        argbfr[i] != '\t' &&
-                        argbfr[i] != '\0')
-                {
-                        i++;
-                }
-                if (argbfr[i] == '\0')
-                        break;
-                argbfr[i++] = '\0';
-
-                while (argbfr[i] == ' ' ||
-                        argbfr[i] == '\t')
-                {
-                        i++;
-                }
-                margv[margc] = &argbfr[i];
-
-                if (margc >= MAXARGS)
-                {
-                        /* Too many arguments in command.  Complain. */
-                        errmsg(MSG_ERR_MAXARGS, cmd, MAXARGS);
                         return 0;
                 }
-        }
 
-        /* Try to run the command by spawning. */
-        result = spawnvp(P_WAIT, margv[0], margv);
-        if (result == -1)
-        {
-                /* Couldn't spawn directly, so try it as a DOS command. */
-                for (i = margc - 1; i >= 0; i--)
-                {
-                        margv[i + 2] = margv[i];
-                }
-                margv[0] = "command.com";
-                margv[1] = "/c";
-                result = spawnvp(P_WAIT, margv[0], margv);
-        }
-        if (result != 0)
-        {
-                /*
-                ** If the process return code was nonzero, generate an
-                ** error, unless we were told to ignore the return code.
-                */
-                if (!CHKFLAG(FLAG_IGNORE) && cmd[0] != '-')
-                {
-                        if (result == -1)
-                        {
-                                /* Couldn't execute the command.  Complain. */
-                                errmsg(MSG_ERR_CANTEXEC, margv[0], errno);
-                                return 0;
-                        }
-                        else
-                        {
-                                /*
-                                ** Command had non-zero return code.
-                                ** Complain to the user.
-                                */
-                                errmsg(MSG_ERR_RETCODE, (char *)NULL, result);
-                                return 0;
-                        }
-                }
+                /* Step to next command in list. */
+                lptr = lptr->lnext;
         }
-#endif /* WIN */
+
+        /* Record whether the target's contents changed. */
+        if (restat)
+                end_restat(tname, otime, ocrc);
 
         return 1;
 }
 
 /*
-** run_commands:
-** Runs a list of subprocesses.
+** build_phony:
+** Does the work of make_target() for a phony target (see
+** makephon.c).  A phony target is never looked for on disk,
+** and no rules are tried on it.  Its dependents are made, and
+** then its commands (if any) are always run.  A phony target
+** that has commands, or has no dependents, passes on the
+** timestamp TIME_PENDING, so the targets that depend on it are
+** always rebuilt.  A target with dependents but no commands
+** only groups other targets, and passes on the timestamp of
+** its newest dependent.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      tname   Name of target being built.
-**      tar     Target descriptor for target being built (if any).
-**      rul     Rule descriptor for rule being used (if any).
-**
-** Either tar or rul may be NULL, but not both.
+**      tname   Name of target to be made.
+**      level   Nesting level of recursion (0 for first call).
+**      hitime  Pointer to time value to receive timestamp of
+**              target.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
+**      2       Target has nothing to be done.
 **      1       Successful.
 **      0       Error occurred.
 */
 static int
-run_commands(tname, tar, rul)
+build_phony(tname, level, hitime)
         char    *tname;
-        TARGET  *tar;
-        RULE    *rul;
+        int     level;
+        time_t  *hitime;
 {
-        LINE    *lptr;
-        char    cmd[MAXPATH];
-        char    rfile[MAXPATH];
-        char    *rsrc = (char *)NULL;
-
-        /* Assume we will use commands from target descriptor. */
-        if (tar != (TARGET *)NULL)
-                lptr = tar->tcommands;
+        TARGET  *tar;           /* Pointer to target's descriptor. */
 
-        /* Check if rule was specified. */
-        if (rul != (RULE *)NULL)
+        if (CHKFLAG(FLAG_DEBUG))
         {
-                /* Build source filename for rule. */
-                get_part_filename(5, tname, rfile);
-                strcat(rfile, ".");
-                strcat(rfile, rul->rsrc);
-
-                /* Change pointer to source from NULL to filename. */
-                rsrc = rfile;
-
-                /* Use commands list from rule. */
-                lptr = rul->rcommands;
+                /* Tell the user the target isn't a file. */
+                mputs(MSG_DBG_PHONY);
+                mputs(tname);
+                mputs("\n");
         }
 
-        /* Process each command in the list. */
-        while (lptr != (LINE *)NULL)
-        {
-#ifdef WIN
-                /* Check if user aborted. */
-                if (check_abort())
-                        return 1;
-#endif /* WIN */
-
-                /* Make sure command isn't too long. */
-                if (strlen(lptr->ldata) > MAXPATH)
-                {
-                        /*
-                        ** The command line exceeds the maximum length
-                        ** for a command line.
-                        */
-                        errmsg(MSG_ERR_CMDTOOLONG, lptr->ldata, NOVAL);
-                        return 0;
-                }
+        /* A phony target that isn't described is always out of date. */
+        *hitime = TIME_PENDING;
+        tar = find_target(tname);
+        if (tar == (TARGET *)NULL)
+                return 2;
+        tar->ttime = 0L;
 
-                /* Expand any special macros. */
-                if (!expand_tarspecial(lptr->ldata, cmd, MAXPATH, tname, rsrc))
+        /* Make sure the target's dependents are up to date. */
+        if (tar->tdependents != (char *)NULL)
+        {
+                if (!make_dependents(tar, level, hitime))
                 {
-                        /* Macro expansion error. */
+                        /* Error making dependents. */
                         return 0;
                 }
 
-                /* Expand any dspecial macros. */
-                if (tar != (TARGET *)NULL)
-                {
-                        if (!expand_dspecial(tar, cmd))
-                        {
-                                /* Macro expansion error. */
-                                return 0;
-                        }
-                }
+                /* A target that only groups others passes on their time. */
+                if (tar->tcommands == (LINE *)NULL)
+                        return 1;
+        }
 
-                /* Run the command. */
-                if (!run_command(cmd))
-                {
-                        /* Couldn't run the command. */
-                        if (!is_precious(tname))
-                        {
-                                /*
-                                ** Remove the potentially
-                                ** incorrect target file.
-                                */
-                                unlink(tname);
-                        }
-                        return 0;
-                }
+        /* Otherwise the target is always out of date. */
+        *hitime = TIME_PENDING;
+        if (tar->tcommands == (LINE *)NULL || CHKFLAG(FLAG_TOUCH))
+                return 1;
 
-                /* Step to next command in list. */
-                lptr = lptr->lnext;
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                /* Tell the user we're running the target's commands. */
+                mputs(MSG_DBG_BUILDING);
+                mputs(tname);
+                mputs("\n");
+        }
+        if (maxjobs > 1)
+        {
+                /* Let the job queue run the commands later. */
+                return queue_job(tname, tar, (RULE *)NULL, (char *)NULL);
         }
 
-        return 1;
+        return run_commands(tname, tar, (RULE *)NULL);
 }
 
-/****************************** FUNCTIONS ***************************/
-
 /*
-** make_target:
-** Makes the specified target file up to date, including building
-** of the target's dependent files and inferring build commands
-** when necessary.
+** build_target:
+** Does the work of make_target() for a target that hasn't been
+** checked yet during this run.
 **
 ** Parameters:
 **      Name    Description
@@ -813,11 +763,14 @@ run_commands(tname, tar, rul)
 **      Value   Meaning
 **      -----   -------
 **      2       Specified target was already up to date.
-**      1       Successful, target is now up to date.
+**      1       Successful, target is now up to date (or, when
+**              running multiple jobs, has been queued to be made
+**              up to date, in which case '*hitime' is set to
+**              TIME_PENDING).
 **      0       Error occurred, couldn't make file up to date.
 */
-int
-make_target(tname, level, hitime)
+static int
+build_target(tname, level, hitime)
         char    *tname;
         int     level;
         time_t  *hitime;
@@ -829,8 +782,9 @@ make_target(tname, level, hitime)
         int     i;              /* Temporary integer/loop index. */
         int     pos;            /* Temporary index into string. */
         int     exists = 0;     /* Flag, nonzero if target file exists. */
+        int     uptodate;       /* Flag, nonzero if target is up to date. */
         struct mstat_t tstat;   /* File statistics for target file. */
-        struct mstat_t dstat;   /* File statistics for dependent file. */
+        time_t  stime;          /* Timestamp of inferred dependent. */
 
 #ifdef WIN
         /* Check if user aborted. */
@@ -846,9 +800,13 @@ make_target(tname, level, hitime)
                 mputs("\n");
         }
 
+        /* A phony target isn't a file, so don't look for one. */
+        if (is_phony(tname))
+                return build_phony(tname, level, hitime);
+
         /* See if target file exists, and if it does, get its timestamp. */
         *hitime = 0L;
-        if (access(tname, 444) == 0)
+        if (mexists(tname))
         {
                 if (mstat(tname, &tstat) != 0)
                 {
@@ -862,6 +820,8 @@ make_target(tname, level, hitime)
 
         /* Find the descriptor for the specified target. */
         tar = find_target(tname);
+        if (tar != (TARGET *)NULL)
+                tar->ttime = *hitime;
 
         /* Do the right thing depending on if the target was found. */
         if (tar == (TARGET *)NULL)
@@ -875,47 +835,11 @@ make_target(tname, level, hitime)
                 ** target is "test.obj", and we have a ".c.obj" rule,
                 ** and there happens to be a file called "test.c"
                 ** in the current directory, we would use the rule
-                ** to build "test.obj" from "test.c".
+                ** to build "test.obj" from "test.c".  A pattern rule
+                ** such as "obj\%.obj: src\%.c" works the same way,
+                ** but can name other directories.
                 */
 
-                /* Get the extension portion of the targetname. */
-                i = 0;
-                pos = -1;
-                while(tname[i] != '\0' && tname[i] != '\\')
-                {
-                        if (tname[i] == '.')
-                                pos = i + 1;
-                        i++;
-                }
-                if (pos == -1 || tname[pos] == '\0')
-                {
-                        /*
-                        ** Target has no extension, so we can't use a
-                        ** rule on it.  If the target already exists,
-                        ** then all is well, otherwise we're stuck.
-                        */
-                        if (exists)
-                        {
-                                /* The target already exists; good. */
-                                if (CHKFLAG(FLAG_DEBUG))
-                                {
-                                        /*
-                                        ** Undescribed target exists,
-                                        ** so tell the user.
-                                        */
-                                        mputs(MSG_DBG_UTEXISTS);
-                                        mputs(tname);
-                                        mputs("\n");
-                                }
-                                *hitime = tstat.st_mtime;
-                                return 1;
-                        }
-
-                        /* Don't know how to make the specified target. */
-                        errmsg(MSG_ERR_CANTMAKE, tname, NOVAL);
-                        return 0;
-                }
-
                 /* Search for a rule we can use. */
                 rul = find_rule(tname, cmd);
 
@@ -953,17 +877,28 @@ make_target(tname, level, hitime)
                 ** then don't build it.
                 */
 
-                /* Get timestamp of inferred dependent file. */
-                if (mstat(cmd, &dstat) != 0)
+                /*
+                ** Make the inferred dependent file, which may itself
+                ** be built by a rule, and get its timestamp.
+                */
+                if (!make_target(cmd, level + 1, &stime))
                 {
-                        /* Couldn't access the file.  Complain. */
-                        errmsg(MSG_ERR_FACCESS, cmd, NOVAL);
+                        /* Error making inferred dependent. */
                         return 0;
                 }
 
                 /* Check target's timestamp against inferred depedent. */
-                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists &&
-                        timestamp_up_to_date(tstat.st_mtime, dstat.st_mtime))
+                if (CHKFLAG(FLAG_DIGEST))
+                        uptodate = stime != TIME_PENDING;
+                else
+                        uptodate = timestamp_up_to_date(tstat.st_mtime,
+                                stime);
+                if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) &&
+                        !check_digest(tname, (TARGET *)NULL, rul, cmd))
+                {
+                        uptodate = 0;
+                }
+                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists && uptodate)
                 {
                         /*
                         ** Target file is newer.  Don't build it.
@@ -1029,14 +964,20 @@ make_target(tname, level, hitime)
                         ** The rule doesn't have any commands associated
                         ** with it.  Complain to the user.
                         */
-                        cmd[0] = '.';
-                        cmd[1] = '\0';
-                        strcat(cmd, rul->rsrc);
-                        strcat(cmd, ".");
-                        strcat(cmd, rul->rdest);
+                        rule_name(rul, cmd);
                         errmsg(MSG_ERR_EMPTYRULE, cmd, NOVAL);
                         return 0;
                 }
+                if (maxjobs > 1)
+                {
+                        /* Let the job queue run the commands later. */
+                        if (!queue_job(tname, (TARGET *)NULL, rul, cmd))
+                        {
+                                return 0;
+                        }
+                        *hitime = TIME_PENDING;
+                        return 1;
+                }
                 if (!run_commands(tname, (TARGET *)NULL, rul))
                 {
                         return 0;
@@ -1080,8 +1021,17 @@ make_target(tname, level, hitime)
                 ** We have commands to build the target.
                 ** See if target file is already up to date.
                 */
-                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists &&
-                        timestamp_up_to_date(tstat.st_mtime, *hitime))
+                if (CHKFLAG(FLAG_DIGEST))
+                        uptodate = *hitime != TIME_PENDING;
+                else
+                        uptodate = timestamp_up_to_date(tstat.st_mtime,
+                                *hitime);
+                if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) &&
+                        !check_digest(tname, tar, (RULE *)NULL, (char *)NULL))
+                {
+                        uptodate = 0;
+                }
+                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists && uptodate)
                 {
                         /*
                         ** Target file is newer.  Don't build it.
@@ -1135,6 +1085,16 @@ make_target(tname, level, hitime)
                 ** There are commands in the target's command
                 ** list.  Use them to build the targetfile.
                 */
+                if (maxjobs > 1)
+                {
+                        /* Let the job queue run the commands later. */
+                        if (!queue_job(tname, tar, (RULE *)NULL, (char *)NULL))
+                        {
+                                return 0;
+                        }
+                        *hitime = TIME_PENDING;
+                        return 1;
+                }
                 if (!run_commands(tname, tar, (RULE *)NULL))
                 {
                         return 0;
@@ -1161,6 +1121,9 @@ make_target(tname, level, hitime)
                 ** to build "test.obj" from "test.c".
                 */
 
+                /* Search for a rule we can use. */
+                rul = find_rule(tname, cmd);
+
                 /* Get the extension portion of the targetname. */
                 i = 0;
                 pos = -1;
@@ -1170,11 +1133,11 @@ make_target(tname, level, hitime)
                                 pos = i + 1;
                         i++;
                 }
-                if (pos == -1 || tname[pos] == '\0')
+                if (rul == (RULE *)NULL && (pos == -1 || tname[pos] == '\0'))
                 {
                         /*
-                        ** Target has no extension, so we can't use a
-                        ** rule on it.  If the target already exists,
+                        ** Target has no extension, and no pattern rule
+                        ** fits it.  If the target already exists,
                         ** then all is well.  If the target had dependents,
                         ** then all is well.  Otherwise, we're stuck.
                         */
@@ -1216,9 +1179,6 @@ make_target(tname, level, hitime)
                         return 0;
                 }
 
-                /* Search for a rule we can use. */
-                rul = find_rule(tname, cmd);
-
                 if (rul == (RULE *)NULL)
                 {
                         /*
@@ -1255,18 +1215,34 @@ make_target(tname, level, hitime)
                 ** are newer.
                 */
 
-                /* Get timestamp of inferred dependent file. */
-                if (mstat(cmd, &dstat) != 0)
+                /*
+                ** Make the inferred dependent file, which may itself
+                ** be built by a rule, and get its timestamp.
+                */
+                if (!make_target(cmd, level + 1, &stime))
                 {
-                        /* Error accessing file. */
-                        errmsg(MSG_ERR_FACCESS, cmd, NOVAL);
+                        /* Error making inferred dependent. */
                         return 0;
                 }
 
                 /* Check target's timestamp against inferred depedent. */
-                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists &&
-                        timestamp_up_to_date(tstat.st_mtime, dstat.st_mtime) &&
-                        timestamp_up_to_date(tstat.st_mtime, *hitime))
+                if (CHKFLAG(FLAG_DIGEST))
+                {
+                        uptodate = *hitime != TIME_PENDING &&
+                                stime != TIME_PENDING;
+                }
+                else
+                {
+                        uptodate = timestamp_up_to_date(tstat.st_mtime,
+                                        stime) &&
+                                timestamp_up_to_date(tstat.st_mtime, *hitime);
+                }
+                if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) &&
+                        !check_digest(tname, tar, rul, cmd))
+                {
+                        uptodate = 0;
+                }
+                if (!CHKFLAG(FLAG_BUILD_ANYWAY) && exists && uptodate)
                 {
                         /*
                         ** Target file is newer.  Don't build it.
@@ -1330,14 +1306,20 @@ make_target(tname, level, hitime)
                         ** The rule doesn't have any commands associated
                         ** with it.  Complain to the user.
                         */
-                        cmd[0] = '.';
-                        cmd[1] = '\0';
-                        strcat(cmd, rul->rsrc);
-                        strcat(cmd, ".");
-                        strcat(cmd, rul->rdest);
+                        rule_name(rul, cmd);
                         errmsg(MSG_ERR_EMPTYRULE, cmd, NOVAL);
                         return 0;
                 }
+                if (maxjobs > 1)
+                {
+                        /* Let the job queue run the commands later. */
+                        if (!queue_job(tname, tar, rul, cmd))
+                        {
+                                return 0;
+                        }
+                        *hitime = TIME_PENDING;
+                        return 1;
+                }
                 if (!run_commands(tname, tar, rul))
                 {
                         return 0;
@@ -1351,3 +1333,519 @@ make_target(tname, level, hitime)
         return 1;
 }
 
+/****************************** FUNCTIONS ***************************/
+
+/*
+** timestamp_up_to_date:
+** Checks to see if a timestamp is up to date with respect to another
+** timestamp.  If the 'CHKFLAG(FLAG_NEEDNEWER)' flag is enabled, the first
+** timestamp must be newer than the second timestamp to be considered
+** up to date; otherwise the first timestamp must be the same as or
+** newer than the second timestamp to be considered up to date.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      t1      First timestamp to check.
+**      t2      Second tiemstamp to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       First timestamp is up-to-date with respect to the
+**              second.
+**      0       First timestamp is not up-to-date with respect to
+**              the second.
+*/
+int
+timestamp_up_to_date(t1, t2)
+        time_t  t1;
+        time_t  t2;
+{
+        if (CHKFLAG(FLAG_NEEDNEWER))
+        {
+                if (t1 > t2)
+                        return 1;
+        }
+        else
+        {
+                if (t1 >= t2)
+                        return 1;
+        }
+        return 0;
+}
+
+/*
+** check_command:
+** Tests the return code of a command that has finished running,
+** complaining to the user if the return code indicates failure.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cmd     String containing the command that was executed,
+**              including any '@' or '-' prefix.
+**      result  Return code of the command, or -1 if the command
+**              could not be executed.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful (or return code was ignored).
+**      0       Command could not be executed or return code
+**              was non-zero.
+*/
+int
+check_command(cmd, result)
+        char    *cmd;
+        int     result;
+{
+        /*
+        ** If the process return code was nonzero, generate an
+        ** error, unless we were told to ignore the return code.
+        */
+        if (result != 0 && !CHKFLAG(FLAG_IGNORE) && cmd[0] != '-')
+        {
+                if (result == -1)
+                {
+                        /* Couldn't execute the command.  Complain. */
+                        errmsg(MSG_ERR_CANTEXEC, cmd, (int)errno);
+                        return 0;
+                }
+                else
+                {
+                        /*
+                        ** Command had non-zero return code.
+                        ** Complain to the user.
+                        */
+                        errmsg(MSG_ERR_RETCODE, (char *)NULL, result);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** run_command:
+** Executes a command and tests the return code.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cmd     String containing command to be executed.
+**      pid     Pointer to integer to receive the process ID
+**              of the command if it is started without waiting
+**              for it to finish, or NULL to always wait for the
+**              command.  If the command completes before this
+**              function returns, zero is placed here.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful (or return code was ignored).
+**      0       Command could not be executed or return code
+**              was non-zero.
+**
+** When a nonzero process ID is returned via 'pid', the caller
+** is responsible for waiting for the process and passing its
+** return code to check_command().
+*/
+int
+run_command(cmd, pid)
+        char    *cmd;
+        int     *pid;
+{
+        char    argbfr[MAXPATH];
+        int     result;
+
+        if (pid != (int *)NULL)
+                *pid = 0;
+
+        /* Make sure the command line isn't too long. */
+        if (strlen(cmd) > MAXPATH)
+        {
+                errmsg(MSG_ERR_CMDTOOLONG, cmd, NOVAL);
+                return 0;
+        }
+
+        /*
+        ** If user put '!' before the command, then complain.  This is
+        ** what Microsoft NMAKE uses to reexecute the command once for
+        ** each of the target's dependent files.
+        */
+        if (cmd[0] == '!')
+        {
+                /* We don't implement this, so complain to the user. */
+                errmsg(MSG_ERR_NOBANG, cmd, NOVAL);
+                return 0;
+        }
+
+        /*
+        ** Copy the command string to a local buffer without
+        ** its prefix character.
+        */
+        if (cmd[0] == '@' || cmd[0] == '-' || cmd[0] == '!')
+                strcpy(argbfr, &cmd[1]);
+        else
+                strcpy(argbfr, &cmd[0]);
+
+        /* Display the command unless display is disabled. */
+        if (!CHKFLAG(FLAG_NO_SHOW) && cmd[0] != '@')
+        {
+                mputs(argbfr);
+                mputs("\n");
+        }
+
+        /*
+        ** If make is running in display only mode, then don't actually
+        ** run the command.
+        */
+        if (CHKFLAG(FLAG_NOSPAWN))
+        {
+                return 1;
+        }
+
+        /* Release unused memory to system before calling subprocess. */
+        mem_heapmin();
+
+#ifdef WIN
+        /*
+        ** Commands are always run to completion under Windows,
+        ** since wrun() waits for the task to exit.
+        */
+        result = wrun(argbfr);
+        if (result != 0 && cmd[0] != '-')
+        {
+                if (result == -1)
+                {
+                        /* Can't execute the command.  Complain. */
+                        errmsg(MSG_ERR_CANTEXEC, argbfr, (int)errno);
+                        return 0;
+                }
+                else
+                {
+                        /*
+                        ** Command had non-zero return code.
+                        ** Complain to the user.
+                        */
+                        errmsg(MSG_ERR_RETCODE, (char *)NULL, result);
+                        return 0;
+                }
+        }
+#else /* !WIN */
+        /*
+        ** If the caller can wait for the command later, try to start
+        ** it without waiting.  P_NOWAIT is only supported in OS/2
+        ** protected mode; under MS-DOS spawnvp() fails with EINVAL,
+        ** in which case we fall back to running the command to
+        ** completion right here.
+        */
+        if (pid != (int *)NULL)
+        {
+                result = spawn_command(P_NOWAIT, argbfr);
+                if (result != -1)
+                {
+                        /* Command is running; caller will check it. */
+                        *pid = result;
+                        return 1;
+                }
+        }
+
+        /* Run the command. */
+        result = spawn_command(P_WAIT, argbfr);
+        if (!check_command(cmd, result))
+                return 0;
+#endif /* WIN */
+
+        return 1;
+}
+
+/*
+** expand_command:
+** Expands the special macros in one command line from a target's
+** or rule's command list, producing the command line to be run.
+** The command line is compiled by compile_command() the first
+** time it is used, and the compiled form is kept with the line.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target being built.
+**      tar     Target descriptor for target being built (if any).
+**      rsrc    Name of rule's source file (NULL if no rule).
+**      line    Command line from the command list.
+**      cmd     Buffer of at least MAXPATH bytes to receive the
+**              expanded command line.
+**      sig     Nonzero if the command line is being expanded for
+**              a command signature, in which case '$?' expands to
+**              every dependent, so the signature doesn't depend
+**              on which dependents happened to be out of date.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+expand_command(tname, tar, rsrc, line, cmd, sig)
+        char    *tname;
+        TARGET  *tar;
+        char    *rsrc;
+        LINE    *line;
+        char    *cmd;
+        int     sig;
+{
+        CMDPART *part;          /* Piece of compiled command line. */
+        DEPEND  *dptr;          /* Expanded list of dependents. */
+        int     pos = 0;        /* Length of expanded command so far. */
+        int     ok = 1;
+        int     i;
+
+        /* Make sure command isn't too long. */
+        if (strlen(line->ldata) > MAXPATH)
+        {
+                /*
+                ** The command line exceeds the maximum length
+                ** for a command line.
+                */
+                errmsg(MSG_ERR_CMDTOOLONG, line->ldata, NOVAL);
+                return 0;
+        }
+
+        /* Compile the command line the first time it's used. */
+        if (line->lcmd == (CMDPART *)NULL)
+        {
+                line->lcmd = compile_command(line->ldata);
+                if (line->lcmd == (CMDPART *)NULL)
+                        return 0;
+        }
+
+        /* Put the pieces together. */
+        for (part = line->lcmd; ok && part->ckind != CMD_END; part++)
+        {
+                switch (part->ckind)
+                {
+                        case CMD_TEXT:
+                                ok = add_to_command(cmd, &pos, part->ctext,
+                                        part->clen, line->ldata);
+                                break;
+
+                        case CMD_TARGET:
+                                ok = add_to_command(cmd, &pos, tname,
+                                        strlen(tname), line->ldata);
+                                break;
+
+                        case CMD_BASE:
+                                /* Find end of basename. */
+                                i = strlen(tname);
+                                while (i > 0 && tname[i] != '.' &&
+                                        tname[i] != '\\')
+                                {
+                                        i--;
+                                }
+                                if (i == 0 || tname[i] == '\\')
+                                        i = strlen(tname);
+                                ok = add_to_command(cmd, &pos, tname, i,
+                                        line->ldata);
+                                break;
+
+                        case CMD_SOURCE:
+                                if (rsrc == (char *)NULL || rsrc[0] == '\0')
+                                {
+                                        /* We're not in a rule, so complain. */
+                                        errmsg(MSG_ERR_LTNORULE, line->ldata,
+                                                NOVAL);
+                                        ok = 0;
+                                        break;
+                                }
+                                ok = add_to_command(cmd, &pos, rsrc,
+                                        strlen(rsrc), line->ldata);
+                                break;
+
+                        case CMD_NEWER:
+                        case CMD_ALLDEPS:
+                                if (tar == (TARGET *)NULL ||
+                                        tar->tdependents == (char *)NULL)
+                                {
+                                        /* No dependents; leave it alone. */
+                                        ok = add_to_command(cmd, &pos,
+                                                part->ckind == CMD_NEWER ?
+                                                "$?" : "$**",
+                                                part->ckind == CMD_NEWER ?
+                                                2 : 3, line->ldata);
+                                        break;
+                                }
+                                if (!expand_dependents(tar))
+                                {
+                                        /* Error expanding list. */
+                                        ok = 0;
+                                        break;
+                                }
+                                for (dptr = tar->tdeps;
+                                        ok && dptr->dname != (char *)NULL;
+                                        dptr++)
+                                {
+                                        if (part->ckind == CMD_NEWER &&
+                                                !sig && !is_newer(tar, dptr))
+                                        {
+                                                continue;
+                                        }
+                                        ok = add_to_command(cmd, &pos,
+                                                dptr->dname,
+                                                strlen(dptr->dname),
+                                                line->ldata) &&
+                                                add_to_command(cmd, &pos,
+                                                " ", 1, line->ldata);
+                                }
+                                break;
+                }
+        }
+        cmd[pos] = '\0';
+
+        return ok;
+}
+
+/*
+** init_states:
+** Initializes the target state table.  This function must be
+** called before make_target() is used.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_states(void)
+{
+        int     i;
+
+        for (i = 0; i < STATE_HASH_SIZE; i++)
+                state_table[i] = (STATE *)NULL;
+        for (i = 0; i < INFER_HASH_SIZE; i++)
+                infer_table[i] = (INFER *)NULL;
+        arena_init(&infer_arena, "rule chains");
+        infer_seq = 0L;
+}
+
+/*
+** flush_states:
+** Empties and frees the target state table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_states(void)
+{
+        STATE   *sptr;
+        STATE   *sptr2;
+        int     i;
+
+        for (i = 0; i < STATE_HASH_SIZE; i++)
+        {
+                sptr = state_table[i];
+                while (sptr != (STATE *)NULL)
+                {
+                        sptr2 = sptr->snext;
+                        mem_free(sptr->sname);
+                        mem_free(sptr);
+                        sptr = sptr2;
+                }
+                state_table[i] = (STATE *)NULL;
+        }
+
+        /* Free the inference rule chains all at once. */
+        for (i = 0; i < INFER_HASH_SIZE; i++)
+                infer_table[i] = (INFER *)NULL;
+        arena_release(&infer_arena);
+}
+
+/*
+** make_target:
+** Makes the specified target file up to date, including building
+** of the target's dependent files and inferring build commands
+** when necessary.  Each target is only checked once per run; later
+** requests for the same target return the results of the first.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target file to build.
+**      level   Recursion level of call.
+**      hitime  Pointer to time_t value to receive
+**              timestamp of newest dependent file.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      2       Specified target was already up to date.
+**      1       Successful, target is now up to date (or, when
+**              running multiple jobs, has been queued to be made
+**              up to date, in which case '*hitime' is set to
+**              TIME_PENDING).
+**      0       Error occurred, couldn't make file up to date.
+*/
+int
+make_target(tname, level, hitime)
+        char    *tname;
+        int     level;
+        time_t  *hitime;
+{
+        STATE   *sptr;
+
+        /* See if the target has already been checked. */
+        sptr = find_state(tname);
+        if (sptr != (STATE *)NULL)
+        {
+                if (sptr->sstate == STATE_CHECKING)
+                {
+                        /* Target depends on itself.  Complain. */
+                        errmsg(MSG_ERR_CIRCULAR, tname, NOVAL);
+                        return 0;
+                }
+                if (CHKFLAG(FLAG_DEBUG))
+                {
+                        /* Tell the user the target was already checked. */
+                        mputs(MSG_DBG_ALREADYCHECKED);
+                        mputs(tname);
+                        mputs("\n");
+                }
+                *hitime = sptr->stime;
+                return sptr->sresult;
+        }
+
+        /* Remember that the target is being checked. */
+        sptr = add_state(tname);
+        if (sptr == (STATE *)NULL)
+                return 0;
+
+        /* Check and build the target, and remember the results. */
+        sptr->sresult = build_target(tname, level, hitime);
+        if (sptr->sresult != 0 && *hitime != TIME_PENDING &&
+                is_restat(tname))
+        {
+                /* Pass on the time the contents last changed. */
+                *hitime = last_changed(tname, *hitime);
+        }
+        sptr->stime = *hitime;
+        sptr->sstate = STATE_DONE;
+
+        /* Record the contents of a target that was just built. */
+        if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) &&
+                !CHKFLAG(FLAG_NOSPAWN) &&
+                sptr->sresult == 1 && *hitime != TIME_PENDING)
+        {
+                commit_digest(tname);
+                if (CHKFLAG(FLAG_CACHE))
+                        store_cache(tname);
+        }
+
+        return sptr->sresult;
+}
@@ -0,0 +1,953 @@
+/*
+======================================================================
+makecach.c
+Artifact cache routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+When the macro MAKECACHE names a directory (in the makefile, on the
+command line, or in the environment), make keeps a copy of each
+target it builds in that directory.  Each copy is filed under a
+key, which is the digest of the target's name, its commands (after
+all macros in them have been expanded), and the names and contents
+of its dependents, including the source file of the rule used to
+build it.  The key is computed by digest_key() in "makedig.c".
+
+Before running the commands for a target, fetch_cache() looks for
+a copy with the same key.  If one is found, it is copied into place
+instead of running the commands.  After a target has been built,
+store_cache() saves a copy of it.  Since MS-DOS has no links, the
+copies are always real copies of the files.
+
+The total size of the copies is limited to MAKECACHESIZE kilobytes
+(4096 if the macro isn't defined).  When the limit is exceeded, the
+least recently used copies are removed until the cache fits again.
+The entries are kept in a list in the order they were last used,
+so the copy to remove is always the first one in the list.
+
+The cache directory holds an index file, 'cache.idx', which is read
+by load_cache() and written by save_cache().  Each line in the file
+describes one stored copy, and the lines are written in the order
+the copies were last used:
+
+        <key> <file> <last use> <size> <target name>
+
+The copy itself is kept in the file '<file>.mc', with the file
+number written as eight hexadecimal digits.  Each stored copy gets
+a file number of its own, so two targets whose keys happen to be
+the same never share a file.  The file starts with a line holding
+the key and the target name, which fetch_cache() checks before
+restoring the copy.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static CACHE    *find_cache(char *tname, unsigned long key);
+static CACHE    *add_cache(char *tname, unsigned long key);
+static void     use_cache(CACHE *cptr, unsigned long use);
+static void     remove_cache(CACHE *cptr);
+static void     cache_filename(unsigned long fnum, char *fname);
+static void     cache_header(CACHE *cptr, char *head);
+static int      copy_file(char *src, char *dest, char *head, int check,
+                        unsigned long *size);
+static void     evict_cache(void);
+static void     parse_cache(char *line);
+static int      put_cache(int fh, char *s);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the cache index. */
+#define CACHE_HASH_SIZE 64
+
+/* Size of buffer for copying files and the index. */
+#define CACHE_IOSIZE    1024
+
+/* Default limit on size of cache, in kilobytes. */
+#define CACHE_DEFSIZE   4096L
+
+/* Name of index file in the cache directory. */
+#define CACHE_INDEX     "cache.idx"
+
+/****************************** VARIABLES ***************************/
+
+/* cache_table:  Hash table of cache entries, by key. */
+static CACHE *cache_table[CACHE_HASH_SIZE];
+
+/* cache_dir:  Name of cache directory. */
+static char cache_dir[MAXPATH];
+
+/* cache_max:  Limit on total size of stored copies, in bytes. */
+static unsigned long cache_max;
+
+/* cache_total:  Total size of stored copies, in bytes. */
+static unsigned long cache_total;
+
+/* cache_oldest, cache_newest:  Entries in order of last use. */
+static CACHE *cache_oldest;
+static CACHE *cache_newest;
+
+/* cache_seq:  Sequence number for the next use of an entry. */
+static unsigned long cache_seq;
+
+/* cache_fnum:  Number for the next stored copy's file. */
+static unsigned long cache_fnum;
+
+/* cache_loaded:  Flag, nonzero if index has been read. */
+static int cache_loaded;
+
+/* cache_dirty:  Flag, nonzero if index must be written. */
+static int cache_dirty;
+
+/* cache_hits:  Number of targets restored from the cache. */
+static unsigned long cache_hits;
+
+/* cache_misses:  Number of targets not found in the cache. */
+static unsigned long cache_misses;
+
+/* cache_iobfr:  Buffer for copying files and the index. */
+static char cache_iobfr[CACHE_IOSIZE];
+
+/* cache_iopos:  Number of bytes waiting in cache_iobfr to be written. */
+static int cache_iopos;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** find_cache:
+** Searches the cache index for a stored copy of a target.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target (lowercase).
+**      key     Key of target.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    No copy of target is stored.
+**      other   Pointer to cache entry for target.
+*/
+static CACHE *
+find_cache(tname, key)
+        char            *tname;
+        unsigned long   key;
+{
+        CACHE   *cptr;
+
+        cptr = cache_table[(int)(key % CACHE_HASH_SIZE)];
+        while (cptr != (CACHE *)NULL)
+        {
+                if (cptr->ckey == key && strcmp(cptr->cname, tname) == 0)
+                        return cptr;
+                cptr = cptr->cnext;
+        }
+
+        return (CACHE *)NULL;
+}
+
+/*
+** add_cache:
+** Adds an entry to the cache index.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target (lowercase).
+**      key     Key of target.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Out of memory.
+**      other   Pointer to new cache entry.
+*/
+static CACHE *
+add_cache(tname, key)
+        char            *tname;
+        unsigned long   key;
+{
+        CACHE   *cptr;
+        int     bucket;
+
+        cptr = (CACHE *)mem_alloc(sizeof(CACHE));
+        if (cptr == (CACHE *)NULL)
+                return (CACHE *)NULL;
+        cptr->cname = (char *)mem_alloc(strlen(tname) + 1);
+        if (cptr->cname == (char *)NULL)
+        {
+                mem_free(cptr);
+                return (CACHE *)NULL;
+        }
+        strcpy(cptr->cname, tname);
+        cptr->ckey = key;
+        cptr->cfile = 0L;
+        cptr->cuse = 0L;
+        cptr->csize = 0L;
+        cptr->colder = (CACHE *)NULL;
+        cptr->cnewer = (CACHE *)NULL;
+
+        bucket = (int)(key % CACHE_HASH_SIZE);
+        cptr->cnext = cache_table[bucket];
+        cache_table[bucket] = cptr;
+
+        return cptr;
+}
+
+/*
+** use_cache:
+** Sets the sequence number of an entry's last use, and moves
+** the entry to its place in the list of entries in order of
+** last use.  Entries are normally used in order, so the place
+** is found by searching back from the newest entry.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cptr    Pointer to cache entry.
+**      use     Sequence number of last use.
+**
+** Returns:
+**      NONE
+*/
+static void
+use_cache(cptr, use)
+        CACHE           *cptr;
+        unsigned long   use;
+{
+        CACHE   *older;
+
+        /* Take the entry out of the list, if it is in it. */
+        if (cptr->colder != (CACHE *)NULL)
+                cptr->colder->cnewer = cptr->cnewer;
+        else if (cache_oldest == cptr)
+                cache_oldest = cptr->cnewer;
+        if (cptr->cnewer != (CACHE *)NULL)
+                cptr->cnewer->colder = cptr->colder;
+        else if (cache_newest == cptr)
+                cache_newest = cptr->colder;
+
+        /* Put it back after the last entry used before it. */
+        cptr->cuse = use;
+        older = cache_newest;
+        while (older != (CACHE *)NULL && older->cuse > use)
+                older = older->colder;
+        cptr->colder = older;
+        if (older != (CACHE *)NULL)
+        {
+                cptr->cnewer = older->cnewer;
+                older->cnewer = cptr;
+        }
+        else
+        {
+                cptr->cnewer = cache_oldest;
+                cache_oldest = cptr;
+        }
+        if (cptr->cnewer != (CACHE *)NULL)
+                cptr->cnewer->colder = cptr;
+        else
+                cache_newest = cptr;
+}
+
+/*
+** remove_cache:
+** Removes an entry from the cache index and deletes its stored copy.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cptr    Pointer to cache entry.
+**
+** Returns:
+**      NONE
+*/
+static void
+remove_cache(cptr)
+        CACHE   *cptr;
+{
+        CACHE   **link;
+        char    fname[MAXPATH];
+
+        cache_filename(cptr->cfile, fname);
+        unlink(fname);
+
+        link = &cache_table[(int)(cptr->ckey % CACHE_HASH_SIZE)];
+        while (*link != cptr)
+                link = &(*link)->cnext;
+        *link = cptr->cnext;
+
+        if (cptr->colder != (CACHE *)NULL)
+                cptr->colder->cnewer = cptr->cnewer;
+        else if (cache_oldest == cptr)
+                cache_oldest = cptr->cnewer;
+        if (cptr->cnewer != (CACHE *)NULL)
+                cptr->cnewer->colder = cptr->colder;
+        else if (cache_newest == cptr)
+                cache_newest = cptr->colder;
+
+        cache_total -= cptr->csize;
+        cache_dirty = 1;
+        mem_free(cptr->cname);
+        mem_free(cptr);
+}
+
+/*
+** cache_filename:
+** Builds the name of the file that holds a stored copy.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fnum    File number of stored copy.
+**      fname   Buffer to receive filename.
+**
+** Returns:
+**      NONE
+*/
+static void
+cache_filename(fnum, fname)
+        unsigned long   fnum;
+        char            *fname;
+{
+        char    *p;
+        int     i;
+
+        strcpy(fname, cache_dir);
+        p = &fname[strlen(fname)];
+        if (p > fname && p[-1] != '\\' && p[-1] != ':')
+                *p++ = '\\';
+        for (i = 28; i >= 0; i -= 4)
+                *p++ = "0123456789abcdef"[(int)((fnum >> i) & 0xF)];
+        strcpy(p, ".mc");
+}
+
+/*
+** cache_header:
+** Builds the line at the start of a stored copy's file, which
+** holds the entry's key and target name.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      cptr    Pointer to cache entry.
+**      head    Buffer to receive line, at least MAXPATH + 12
+**              characters long.
+**
+** Returns:
+**      NONE
+*/
+static void
+cache_header(cptr, head)
+        CACHE   *cptr;
+        char    *head;
+{
+        strcpy(head, multoa(cptr->ckey));
+        strcat(head, " ");
+        strcat(head, cptr->cname);
+        strcat(head, "\n");
+}
+
+/*
+** copy_file:
+** Copies a file, with a header line added to the start of the
+** copy or removed from the start of the original.  If the copy
+** can't be completed, the partial destination file is removed.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      src     Name of file to copy.
+**      dest    Name of file to create.
+**      head    Header line.
+**      check   Nonzero if the source file must start with the
+**              header line, which isn't copied; zero if the
+**              header line is written to the start of the copy.
+**      size    Pointer to value to receive size of file, not
+**              counting the header line.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred, or the source file didn't
+**              start with the header line.
+*/
+static int
+copy_file(src, dest, head, check, size)
+        char            *src;
+        char            *dest;
+        char            *head;
+        int             check;
+        unsigned long   *size;
+{
+        int     fsrc;
+        int     fdest;
+        int     count = 0;
+        int     hlen;
+        int     ok = 1;
+
+        fsrc = mopen_r(src);
+        if (fsrc == -1)
+                return 0;
+
+        /* Check the header before touching the destination. */
+        hlen = strlen(head);
+        if (check && (mread(fsrc, cache_iobfr, hlen) != hlen ||
+                memcmp(cache_iobfr, head, hlen) != 0))
+        {
+                mclose(fsrc);
+                return 0;
+        }
+
+        fdest = mcreat(dest);
+        if (fdest == -1)
+        {
+                mclose(fsrc);
+                return 0;
+        }
+        if (!check && mwrite(fdest, head, hlen) != hlen)
+                ok = 0;
+
+        *size = 0L;
+        while (ok && (count = mread(fsrc, cache_iobfr, CACHE_IOSIZE)) > 0)
+        {
+                if (mwrite(fdest, cache_iobfr, count) != count)
+                {
+                        ok = 0;
+                        break;
+                }
+                *size += (unsigned long)count;
+        }
+        if (count == -1)
+                ok = 0;
+
+        mclose(fsrc);
+        if (mclose(fdest) == -1)
+                ok = 0;
+        if (!ok)
+                unlink(dest);
+
+        return ok;
+}
+
+/*
+** evict_cache:
+** Removes the least recently used stored copies until the
+** cache is no larger than its size limit.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+static void
+evict_cache(void)
+{
+        while (cache_total > cache_max && cache_oldest != (CACHE *)NULL)
+        {
+                if (CHKFLAG(FLAG_DEBUG))
+                {
+                        mputs(MSG_DBG_CACHEEVICT);
+                        mputs(cache_oldest->cname);
+                        mputs("\n");
+                }
+                remove_cache(cache_oldest);
+        }
+}
+
+/*
+** parse_cache:
+** Parses one line from the cache index file into the cache
+** index.  Lines that can't be parsed are ignored.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    Line from index file.
+**
+** Returns:
+**      NONE
+*/
+static void
+parse_cache(line)
+        char    *line;
+{
+        unsigned long   val[4];
+        int             i;
+        char            *p;
+        CACHE           *cptr;
+
+        /* Get numeric fields. */
+        p = line;
+        for (i = 0; i < 4; i++)
+        {
+                if (i > 0 && *p != ' ')
+                        return;
+                val[i] = strtoul(p, &p, 10);
+        }
+
+        /* Rest of line, after one space, is the target name. */
+        if (*p++ != ' ' || *p == '\0')
+                return;
+        if (find_cache(p, val[0]) != (CACHE *)NULL)
+                return;
+        cptr = add_cache(p, val[0]);
+        if (cptr == (CACHE *)NULL)
+                return;
+
+        cptr->cfile = val[1];
+        cptr->csize = val[3];
+        use_cache(cptr, val[2]);
+        cache_total += val[3];
+        if (val[1] >= cache_fnum)
+                cache_fnum = val[1] + 1L;
+        if (val[2] >= cache_seq)
+                cache_seq = val[2] + 1L;
+}
+
+/*
+** put_cache:
+** Adds a string to the output buffer for the cache index
+** file, writing the buffer to the file when it becomes full.
+** Passing NULL for the string writes out whatever is left in
+** the buffer.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fh      Handle of index file.
+**      s       String to write, or NULL.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+put_cache(fh, s)
+        int     fh;
+        char    *s;
+{
+        while (s == (char *)NULL || *s != '\0')
+        {
+                if (s == (char *)NULL || cache_iopos >= CACHE_IOSIZE)
+                {
+                        if (mwrite(fh, cache_iobfr, cache_iopos) !=
+                                cache_iopos)
+                        {
+                                return 0;
+                        }
+                        cache_iopos = 0;
+                        if (s == (char *)NULL)
+                                break;
+                }
+                cache_iobfr[cache_iopos++] = *s++;
+        }
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_cache:
+** Initializes the cache index.  This function must be called
+** before any of the other functions in this module.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_cache(void)
+{
+        int     i;
+
+        for (i = 0; i < CACHE_HASH_SIZE; i++)
+                cache_table[i] = (CACHE *)NULL;
+        cache_oldest = (CACHE *)NULL;
+        cache_newest = (CACHE *)NULL;
+        cache_dir[0] = '\0';
+        cache_max = CACHE_DEFSIZE * 1024L;
+        cache_total = 0L;
+        cache_seq = 1L;
+        cache_fnum = 1L;
+        cache_loaded = 0;
+        cache_dirty = 0;
+        cache_hits = 0L;
+        cache_misses = 0L;
+}
+
+/*
+** flush_cache:
+** Empties and frees the cache index.  Any changes should be
+** saved with save_cache() first.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_cache(void)
+{
+        CACHE   *cptr;
+        CACHE   *cptr2;
+        int     i;
+
+        for (i = 0; i < CACHE_HASH_SIZE; i++)
+        {
+                cptr = cache_table[i];
+                while (cptr != (CACHE *)NULL)
+                {
+                        cptr2 = cptr->cnext;
+                        mem_free(cptr->cname);
+                        mem_free(cptr);
+                        cptr = cptr2;
+                }
+        }
+
+        init_cache();
+}
+
+/*
+** load_cache:
+** Reads the index of a cache directory.  It is not an error
+** for the index not to exist yet.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dname   Name of cache directory.
+**      maxkb   Limit on size of cache, in kilobytes (0 for default).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+load_cache(dname, maxkb)
+        char    *dname;
+        long    maxkb;
+{
+        char    line[MAXPATH + 40];
+        char    iname[MAXPATH];
+        int     lpos = 0;
+        int     fh;
+        int     count;
+        int     i;
+
+        strncpy(cache_dir, dname, MAXPATH - 14);
+        cache_dir[MAXPATH - 14] = '\0';
+        if (maxkb > 0L)
+                cache_max = (unsigned long)maxkb * 1024L;
+        cache_loaded = 1;
+
+        strcpy(iname, cache_dir);
+        if (iname[0] != '\0' && iname[strlen(iname) - 1] != '\\' &&
+                iname[strlen(iname) - 1] != ':')
+        {
+                strcat(iname, "\\");
+        }
+        strcat(iname, CACHE_INDEX);
+
+        fh = mopen_r(iname);
+        if (fh == -1)
+        {
+                /* No index yet; the cache is empty. */
+                return 1;
+        }
+
+        /* Read the file, splitting it into lines. */
+        while ((count = mread(fh, cache_iobfr, CACHE_IOSIZE)) > 0)
+        {
+                for (i = 0; i < count; i++)
+                {
+                        if (cache_iobfr[i] == '\n')
+                        {
+                                line[lpos] = '\0';
+                                parse_cache(line);
+                                lpos = 0;
+                        }
+                        else if (cache_iobfr[i] != '\r' &&
+                                lpos < sizeof(line) - 1)
+                        {
+                                line[lpos++] = cache_iobfr[i];
+                        }
+                }
+        }
+        mclose(fh);
+
+        if (count == -1)
+        {
+                /* Error reading the file. */
+                errmsg(MSG_ERR_IOREAD, iname, NOVAL);
+                return 0;
+        }
+
+        return 1;
+}
+
+/*
+** save_cache:
+** Writes the cache index to the cache directory, if the index
+** was loaded and anything in it has changed.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_cache(void)
+{
+        CACHE   *cptr;
+        char    iname[MAXPATH];
+        int     fh;
+        int     ok = 1;
+
+        if (!cache_loaded || !cache_dirty)
+                return 1;
+
+        strcpy(iname, cache_dir);
+        if (iname[0] != '\0' && iname[strlen(iname) - 1] != '\\' &&
+                iname[strlen(iname) - 1] != ':')
+        {
+                strcat(iname, "\\");
+        }
+        strcat(iname, CACHE_INDEX);
+
+        fh = mcreat(iname);
+        if (fh == -1)
+        {
+                errmsg(MSG_ERR_CANTCREATE, iname, NOVAL);
+                return 0;
+        }
+
+        /* Write the entries oldest first, so they load in order. */
+        cache_iopos = 0;
+        cptr = cache_oldest;
+        while (ok && cptr != (CACHE *)NULL)
+        {
+                ok = put_cache(fh, multoa(cptr->ckey)) &&
+                        put_cache(fh, " ") &&
+                        put_cache(fh, multoa(cptr->cfile)) &&
+                        put_cache(fh, " ") &&
+                        put_cache(fh, multoa(cptr->cuse)) &&
+                        put_cache(fh, " ") &&
+                        put_cache(fh, multoa(cptr->csize)) &&
+                        put_cache(fh, " ") &&
+                        put_cache(fh, cptr->cname) &&
+                        put_cache(fh, "\n");
+                cptr = cptr->cnewer;
+        }
+        if (ok)
+                ok = put_cache(fh, (char *)NULL);
+
+        if (mclose(fh) == -1)
+                ok = 0;
+        if (!ok)
+        {
+                errmsg(MSG_ERR_IOWRITE, iname, NOVAL);
+                return 0;
+        }
+
+        cache_dirty = 0;
+        return 1;
+}
+
+/*
+** fetch_cache:
+** Looks for a stored copy of a target that is about to be built,
+** and if one is found, copies it into place.  check_digest() must
+** have been called for the target first.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Target was restored from the cache.
+**      0       Target must be built.
+*/
+int
+fetch_cache(tname)
+        char    *tname;
+{
+        CACHE           *cptr;
+        unsigned long   key;
+        unsigned long   size;
+        char            lname[MAXPATH];
+        char            fname[MAXPATH];
+        char            head[MAXPATH + 12];
+
+        if (!cache_loaded || CHKFLAG(FLAG_NOSPAWN | FLAG_TOUCH))
+                return 0;
+        if (!digest_key(tname, &key))
+                return 0;
+
+        strncpy(lname, tname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+        cptr = find_cache(lname, key);
+        if (cptr == (CACHE *)NULL)
+        {
+                cache_misses++;
+                return 0;
+        }
+
+        /*
+        ** Copy the stored file over the target, if it is really
+        ** the copy of this target with this key.
+        */
+        cache_filename(cptr->cfile, fname);
+        cache_header(cptr, head);
+        forget_mstat(tname);
+        if (!copy_file(fname, tname, head, 1, &size))
+        {
+                /* The stored copy is gone or damaged; forget it. */
+                remove_cache(cptr);
+                cache_misses++;
+                return 0;
+        }
+
+        use_cache(cptr, cache_seq++);
+        cache_dirty = 1;
+        cache_hits++;
+        if (!CHKFLAG(FLAG_NO_SHOW))
+        {
+                mputs(MSG_CACHERESTORED);
+                mputs("'");
+                mputs(tname);
+                mputs("'\n");
+        }
+
+        return 1;
+}
+
+/*
+** store_cache:
+** Saves a copy of a target that was just built.  If the
+** cache already holds a copy of the target with the same
+** key, the copy is only marked as recently used.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**
+** Returns:
+**      NONE
+*/
+void
+store_cache(tname)
+        char    *tname;
+{
+        CACHE           *cptr;
+        unsigned long   key;
+        unsigned long   size;
+        char            lname[MAXPATH];
+        char            fname[MAXPATH];
+        char            head[MAXPATH + 12];
+
+        if (!cache_loaded || CHKFLAG(FLAG_NOSPAWN | FLAG_TOUCH))
+                return;
+        if (!digest_key(tname, &key))
+                return;
+
+        strncpy(lname, tname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+        cptr = find_cache(lname, key);
+        if (cptr == (CACHE *)NULL)
+        {
+                /* Copy the target into a new file in the cache. */
+                cptr = add_cache(lname, key);
+                if (cptr == (CACHE *)NULL)
+                        return;
+                cptr->cfile = cache_fnum++;
+                cache_filename(cptr->cfile, fname);
+                cache_header(cptr, head);
+                if (!copy_file(tname, fname, head, 0, &size))
+                {
+                        remove_cache(cptr);
+                        return;
+                }
+                cptr->csize = size;
+                cache_total += size;
+                if (CHKFLAG(FLAG_DEBUG))
+                {
+                        mputs(MSG_DBG_CACHESTORE);
+                        mputs(tname);
+                        mputs("\n");
+                }
+        }
+
+        use_cache(cptr, cache_seq++);
+        cache_dirty = 1;
+        evict_cache();
+}
+
+/*
+** report_cache:
+** Tells the user how many targets were restored from the cache.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+report_cache(void)
+{
+        if (cache_hits == 0L && cache_misses == 0L)
+                return;
+
+        mputs(MSG_CACHEHITS);
+        mputs(multoa(cache_hits));
+        mputs(MSG_CACHEMISSES);
+        mputs(multoa(cache_misses));
+        mputs("\n");
+}
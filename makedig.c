@@ -0,0 +1,1099 @@
+/*
+======================================================================
+makedig.c
+Contents digest database routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+When the '-h' option is given, make decides whether a target is
+up to date by comparing the contents of its dependent files with
+their contents when the target was last built, instead of comparing
+timestamps.  This way, restoring an old copy of a file or rebuilding
+a file that comes out the same doesn't cause everything that depends
+on it to be rebuilt.
+
+The digest of a file's contents is a 32-bit CRC.  The digest of a
+file is remembered along with the file's timestamp and size, and
+the file is only read again when its timestamp or size changes.
+
+For each target, the database holds a digest of the names and
+digests of all of its dependents, and the digest of the target file
+itself, as they were after the target was last built successfully.
+check_digest() is called by make_target() when checking a target,
+and commit_digest() is called after the target has been built.
+
+When the '-g' option is given, the database also holds a digest of
+each target's commands, after all macros in them have been expanded,
+as they were when the target was last built.  A target whose
+commands have changed since then, such as after a change to the
+compiler flags, is rebuilt even if it is newer than its dependents.
+
+When a ".RESTAT" target's commands leave its contents the same
+("makerst.c"), mark_unchanged() records the time its contents last
+really changed, along with the timestamp the file has now.  As long
+as the file keeps that timestamp, last_changed() gives the older
+time to the targets that depend on it, so they aren't rebuilt.
+
+The database is kept in the file 'make.dig' in the same directory
+as the makefile, and is read by load_digests() and written by
+save_digests().  Each line in the file describes one file:
+
+        F <digest> <timestamp> <size> <filename>
+        T <dependents digest> <target digest> <filename>
+        C <commands digest> <filename>
+        U <time changed> <timestamp> <filename>
+
+digest_key() combines the digests of a target's commands and
+dependents into the key used by the artifact cache ("makecach.c").
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static void             crc_init(void);
+static DIGEST           *find_digest(char *fname, int create);
+static int              deps_digest(DIGEST *dig, unsigned long *crc);
+static int              cmds_digest(DIGEST *dig, unsigned long *crc);
+static void             parse_digest(char *line);
+static int              put_digest(int fh, char *s);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the digest table. */
+#define DIGEST_HASH_SIZE 64
+
+/* Size of buffer for reading and writing files. */
+#define DIGEST_IOSIZE   512
+
+/* Polynomial for CRC-32 digests. */
+#define CRC_POLY        0xEDB88320L
+
+/****************************** VARIABLES ***************************/
+
+/* crc_table:  Table for computing CRC-32 a byte at a time. */
+static unsigned long crc_table[256];
+
+/* crc_ready:  Flag, nonzero once crc_table has been filled in. */
+static int crc_ready;
+
+/* digest_table:  Hash table of digest descriptors. */
+static DIGEST *digest_table[DIGEST_HASH_SIZE];
+
+/* digest_dbname:  Name of digest database file. */
+static char digest_dbname[MAXPATH];
+
+/* digest_loaded:  Flag, nonzero if database has been read. */
+static int digest_loaded;
+
+/* digest_dirty:  Flag, nonzero if database must be written. */
+static int digest_dirty;
+
+/* digest_iobfr:  Buffer for reading files and the database. */
+static char digest_iobfr[DIGEST_IOSIZE];
+
+/* digest_iopos:  Number of bytes waiting in digest_iobfr to be written. */
+static int digest_iopos;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** crc_init:
+** Fills in the table used for computing CRC-32 digests.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+static void
+crc_init(void)
+{
+        unsigned long   c;
+        int             i;
+        int             j;
+
+        for (i = 0; i < 256; i++)
+        {
+                c = (unsigned long)i;
+                for (j = 0; j < 8; j++)
+                {
+                        if (c & 1L)
+                                c = (c >> 1) ^ CRC_POLY;
+                        else
+                                c >>= 1;
+                }
+                crc_table[i] = c;
+        }
+        crc_ready = 1;
+}
+
+/*
+** find_digest:
+** Searches the digest table for a file, optionally adding
+** a new entry for it if it isn't there.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to search for.
+**      create  Nonzero to add an entry if not found.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    File not found (or out of memory).
+**      other   Pointer to file's digest descriptor.
+*/
+static DIGEST *
+find_digest(fname, create)
+        char    *fname;
+        int     create;
+{
+        DIGEST          *dig;
+        char            lname[MAXPATH];
+        unsigned int    hash;
+        int             bucket;
+
+        /* DOS filenames aren't case sensitive. */
+        strncpy(lname, fname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+        hash = hash_name(lname);
+        bucket = hash % DIGEST_HASH_SIZE;
+
+        dig = digest_table[bucket];
+        while (dig != (DIGEST *)NULL)
+        {
+                if (dig->dhash == hash && strcmp(lname, dig->dname) == 0)
+                        return dig;
+                dig = dig->dnext;
+        }
+        if (!create)
+                return (DIGEST *)NULL;
+
+        /* Make a new entry for the file. */
+        dig = (DIGEST *)mem_alloc(sizeof(DIGEST));
+        if (dig == (DIGEST *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return (DIGEST *)NULL;
+        }
+        dig->dname = (char *)mem_alloc(strlen(lname) + 1);
+        if (dig->dname == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                mem_free(dig);
+                return (DIGEST *)NULL;
+        }
+        strcpy(dig->dname, lname);
+        dig->dhash = hash;
+        dig->dflags = 0;
+        dig->dtime = 0L;
+        dig->dsize = 0L;
+        dig->dcrc = 0L;
+        dig->ddeps = 0L;
+        dig->dout = 0L;
+        dig->dcmd = 0L;
+        dig->dchanged = 0L;
+        dig->dstamp = 0L;
+        dig->dtar = (TARGET *)NULL;
+        dig->drul = (RULE *)NULL;
+        dig->dsrc = (char *)NULL;
+
+        /* Add the entry to its hash bucket. */
+        dig->dnext = digest_table[bucket];
+        digest_table[bucket] = dig;
+
+        return dig;
+}
+
+/*
+** deps_digest:
+** Computes the digest of a target's dependents, as recorded by
+** the last call to check_digest() for the target.  The digest
+** covers the names of the dependents as well as their contents,
+** so that adding or removing a dependent also changes it.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dig     Pointer to target's digest descriptor.
+**      crc     Pointer to value to receive the digest.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+deps_digest(dig, crc)
+        DIGEST          *dig;
+        unsigned long   *crc;
+{
+        DEPEND          *dptr;
+        unsigned long   c = 0xFFFFFFFFL;
+        unsigned long   d;
+
+        /* Add each dependent's name and contents to digest. */
+        if (dig->dtar != (TARGET *)NULL &&
+                dig->dtar->tdependents != (char *)NULL)
+        {
+                if (!expand_dependents(dig->dtar))
+                        return 0;
+                for (dptr = dig->dtar->tdeps; dptr->dname != (char *)NULL;
+                        dptr++)
+                {
+                        c = crc_block(c, dptr->dname,
+                                strlen(dptr->dname) + 1);
+
+                        /* A dependent that isn't a file adds its name. */
+                        if (!file_digest(dptr->dname, &d))
+                                d = 0L;
+                        c = crc_long(c, d);
+                }
+        }
+
+        /* Add the inference rule's source file. */
+        if (dig->dsrc != (char *)NULL)
+        {
+                c = crc_block(c, dig->dsrc, strlen(dig->dsrc) + 1);
+                if (!file_digest(dig->dsrc, &d))
+                        d = 0L;
+                c = crc_long(c, d);
+        }
+
+        *crc = c;
+        return 1;
+}
+
+/*
+** cmds_digest:
+** Computes the digest of a target's commands, as recorded by the
+** last call to check_digest() for the target.  Each command is
+** expanded the same way as when it is run.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dig     Pointer to target's digest descriptor.
+**      crc     Pointer to value to receive the digest.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+cmds_digest(dig, crc)
+        DIGEST          *dig;
+        unsigned long   *crc;
+{
+        LINE            *lptr = (LINE *)NULL;
+        unsigned long   c = 0xFFFFFFFFL;
+        char            cmd[MAXPATH];
+
+        /* Use the same commands that run_commands() would use. */
+        if (dig->drul != (RULE *)NULL)
+                lptr = dig->drul->rcommands;
+        else if (dig->dtar != (TARGET *)NULL)
+                lptr = dig->dtar->tcommands;
+
+        while (lptr != (LINE *)NULL)
+        {
+                if (!expand_command(dig->dname, dig->dtar, dig->dsrc,
+                        lptr, cmd, 1))
+                {
+                        return 0;
+                }
+                c = crc_block(c, cmd, strlen(cmd) + 1);
+                lptr = lptr->lnext;
+        }
+
+        *crc = c;
+        return 1;
+}
+
+/*
+** parse_digest:
+** Parses one line from the digest database file into the
+** digest table.  Lines that can't be parsed are ignored;
+** the files they describe will just be digested again.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    Line from database file.
+**
+** Returns:
+**      NONE
+*/
+static void
+parse_digest(line)
+        char    *line;
+{
+        unsigned long   val[3];
+        int             nvals;
+        int             i;
+        char            *p;
+        DIGEST          *dig;
+
+        /* Get record type. */
+        if (line[0] == 'F')
+                nvals = 3;
+        else if (line[0] == 'T')
+                nvals = 2;
+        else if (line[0] == 'C')
+                nvals = 1;
+        else if (line[0] == 'U')
+                nvals = 2;
+        else
+                return;
+
+        /* Get numeric fields. */
+        p = &line[1];
+        for (i = 0; i < nvals; i++)
+        {
+                if (*p != ' ')
+                        return;
+                val[i] = strtoul(p, &p, 10);
+        }
+
+        /* Rest of line, after one space, is the filename. */
+        if (*p++ != ' ' || *p == '\0')
+                return;
+        dig = find_digest(p, 1);
+        if (dig == (DIGEST *)NULL)
+                return;
+
+        if (line[0] == 'F')
+        {
+                dig->dcrc = val[0];
+                dig->dtime = val[1];
+                dig->dsize = val[2];
+                dig->dflags |= DIG_FILE;
+        }
+        else if (line[0] == 'T')
+        {
+                dig->ddeps = val[0];
+                dig->dout = val[1];
+                dig->dflags |= DIG_TARGET;
+        }
+        else if (line[0] == 'C')
+        {
+                dig->dcmd = val[0];
+                dig->dflags |= DIG_COMMANDS;
+        }
+        else
+        {
+                dig->dchanged = val[0];
+                dig->dstamp = val[1];
+                dig->dflags |= DIG_UNCHANGED;
+        }
+}
+
+/*
+** put_digest:
+** Adds a string to the output buffer for the digest database
+** file, writing the buffer to the file when it becomes full.
+** Passing NULL for the string writes out whatever is left in
+** the buffer.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fh      Handle of database file.
+**      s       String to write, or NULL.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+put_digest(fh, s)
+        int     fh;
+        char    *s;
+{
+        while (s == (char *)NULL || *s != '\0')
+        {
+                if (s == (char *)NULL || digest_iopos >= DIGEST_IOSIZE)
+                {
+                        if (mwrite(fh, digest_iobfr, digest_iopos) !=
+                                digest_iopos)
+                        {
+                                return 0;
+                        }
+                        digest_iopos = 0;
+                        if (s == (char *)NULL)
+                                break;
+                }
+                digest_iobfr[digest_iopos++] = *s++;
+        }
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** crc_block:
+** Adds a block of bytes to a CRC-32 digest.  A new digest
+** starts with the value 0xFFFFFFFF.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      crc     Digest so far.
+**      p       Pointer to bytes to add.
+**      n       Number of bytes to add.
+**
+** Returns:
+**      New value of digest.
+*/
+unsigned long
+crc_block(crc, p, n)
+        unsigned long   crc;
+        char            *p;
+        unsigned        n;
+{
+        if (!crc_ready)
+                crc_init();
+
+        while (n-- > 0)
+        {
+                crc = crc_table[(int)((crc ^ (unsigned char)*p++) & 0xFF)] ^
+                        (crc >> 8);
+        }
+
+        return crc;
+}
+
+/*
+** crc_long:
+** Adds the bytes of a long value to a CRC-32 digest, lowest
+** byte first.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      crc     Digest so far.
+**      val     Value to add.
+**
+** Returns:
+**      New value of digest.
+*/
+unsigned long
+crc_long(crc, val)
+        unsigned long   crc;
+        unsigned long   val;
+{
+        char    b[4];
+
+        b[0] = (char)(val & 0xFF);
+        b[1] = (char)((val >> 8) & 0xFF);
+        b[2] = (char)((val >> 16) & 0xFF);
+        b[3] = (char)((val >> 24) & 0xFF);
+
+        return crc_block(crc, b, 4);
+}
+
+/*
+** init_digests:
+** Initializes the digest table.  This function must be called
+** before any of the other functions in this module.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_digests(void)
+{
+        int     i;
+
+        for (i = 0; i < DIGEST_HASH_SIZE; i++)
+                digest_table[i] = (DIGEST *)NULL;
+        digest_dbname[0] = '\0';
+        digest_loaded = 0;
+        digest_dirty = 0;
+}
+
+/*
+** flush_digests:
+** Empties and frees the digest table.  Any changes should be
+** saved with save_digests() first.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_digests(void)
+{
+        DIGEST  *dig;
+        DIGEST  *dig2;
+        int     i;
+
+        for (i = 0; i < DIGEST_HASH_SIZE; i++)
+        {
+                dig = digest_table[i];
+                while (dig != (DIGEST *)NULL)
+                {
+                        dig2 = dig->dnext;
+                        mem_free(dig->dname);
+                        if (dig->dsrc != (char *)NULL)
+                                mem_free(dig->dsrc);
+                        mem_free(dig);
+                        dig = dig2;
+                }
+        }
+
+        init_digests();
+}
+
+/*
+** load_digests:
+** Reads the digest database file into the digest table.  It is
+** not an error for the file not to exist yet.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dbname  Name of digest database file.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+load_digests(dbname)
+        char    *dbname;
+{
+        char    line[MAXPATH + 40];
+        int     lpos = 0;
+        int     fh;
+        int     count;
+        int     i;
+
+        strcpy(digest_dbname, dbname);
+        digest_loaded = 1;
+
+        fh = mopen_r(dbname);
+        if (fh == -1)
+        {
+                /* No database yet; every target will be built. */
+                return 1;
+        }
+
+        /* Read the file, splitting it into lines. */
+        while ((count = mread(fh, digest_iobfr, DIGEST_IOSIZE)) > 0)
+        {
+                for (i = 0; i < count; i++)
+                {
+                        if (digest_iobfr[i] == '\n')
+                        {
+                                line[lpos] = '\0';
+                                parse_digest(line);
+                                lpos = 0;
+                        }
+                        else if (digest_iobfr[i] != '\r' &&
+                                lpos < sizeof(line) - 1)
+                        {
+                                line[lpos++] = digest_iobfr[i];
+                        }
+                }
+        }
+        mclose(fh);
+
+        if (count == -1)
+        {
+                /* Error reading the file. */
+                errmsg(MSG_ERR_IOREAD, dbname, NOVAL);
+                return 0;
+        }
+
+        return 1;
+}
+
+/*
+** save_digests:
+** Writes the digest table to the digest database file, if the
+** database was loaded and anything in it has changed.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_digests(void)
+{
+        DIGEST  *dig;
+        int     fh;
+        int     i;
+        int     ok = 1;
+
+        if (!digest_loaded || !digest_dirty)
+                return 1;
+
+        fh = mcreat(digest_dbname);
+        if (fh == -1)
+        {
+                errmsg(MSG_ERR_CANTCREATE, digest_dbname, NOVAL);
+                return 0;
+        }
+
+        digest_iopos = 0;
+        for (i = 0; ok && i < DIGEST_HASH_SIZE; i++)
+        {
+                dig = digest_table[i];
+                while (ok && dig != (DIGEST *)NULL)
+                {
+                        if (dig->dflags & DIG_FILE)
+                        {
+                                ok = put_digest(fh, "F ") &&
+                                        put_digest(fh, multoa(dig->dcrc)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, multoa(dig->dtime)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, multoa(dig->dsize)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, dig->dname) &&
+                                        put_digest(fh, "\n");
+                        }
+                        if (ok && (dig->dflags & DIG_TARGET))
+                        {
+                                ok = put_digest(fh, "T ") &&
+                                        put_digest(fh, multoa(dig->ddeps)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, multoa(dig->dout)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, dig->dname) &&
+                                        put_digest(fh, "\n");
+                        }
+                        if (ok && (dig->dflags & DIG_COMMANDS))
+                        {
+                                ok = put_digest(fh, "C ") &&
+                                        put_digest(fh, multoa(dig->dcmd)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, dig->dname) &&
+                                        put_digest(fh, "\n");
+                        }
+                        if (ok && (dig->dflags & DIG_UNCHANGED))
+                        {
+                                ok = put_digest(fh, "U ") &&
+                                        put_digest(fh,
+                                                multoa(dig->dchanged)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, multoa(dig->dstamp)) &&
+                                        put_digest(fh, " ") &&
+                                        put_digest(fh, dig->dname) &&
+                                        put_digest(fh, "\n");
+                        }
+                        dig = dig->dnext;
+                }
+        }
+        if (ok)
+                ok = put_digest(fh, (char *)NULL);
+
+        if (mclose(fh) == -1)
+                ok = 0;
+        if (!ok)
+        {
+                errmsg(MSG_ERR_IOWRITE, digest_dbname, NOVAL);
+                return 0;
+        }
+
+        digest_dirty = 0;
+        return 1;
+}
+
+/*
+** file_digest:
+** Gets the digest of a file's contents.  The file is only read
+** if its timestamp or size has changed since it was last read.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file.
+**      crc     Pointer to value to receive the digest.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       File couldn't be read.
+*/
+int
+file_digest(fname, crc)
+        char            *fname;
+        unsigned long   *crc;
+{
+        struct mstat_t  fstat;
+        DIGEST          *dig;
+        unsigned long   c;
+        int             fh;
+        int             count;
+
+        /* Get file's timestamp and size. */
+        if (mstat(fname, &fstat) != 0)
+                return 0;
+
+        /* See if the file has been digested since it last changed. */
+        dig = find_digest(fname, 1);
+        if (dig == (DIGEST *)NULL)
+                return 0;
+        if ((dig->dflags & DIG_FILE) &&
+                dig->dtime == fstat.st_mtime &&
+                dig->dsize == fstat.st_size)
+        {
+                *crc = dig->dcrc;
+                return 1;
+        }
+
+        /* Read the file to compute its digest. */
+        fh = mopen_r(fname);
+        if (fh == -1)
+                return 0;
+        c = 0xFFFFFFFFL;
+        while ((count = mread(fh, digest_iobfr, DIGEST_IOSIZE)) > 0)
+                c = crc_block(c, digest_iobfr, count);
+        mclose(fh);
+        if (count == -1)
+                return 0;
+        c ^= 0xFFFFFFFFL;
+
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                mputs(MSG_DBG_DIGESTED);
+                mputs(fname);
+                mputs("\n");
+        }
+
+        /* Remember the digest. */
+        dig->dcrc = c;
+        dig->dtime = fstat.st_mtime;
+        dig->dsize = fstat.st_size;
+        dig->dflags |= DIG_FILE;
+        digest_dirty = 1;
+
+        *crc = c;
+        return 1;
+}
+
+/*
+** check_digest:
+** Checks if a target is up to date by comparing digests with the
+** ones recorded when the target was last built.  With '-h', the
+** digests of the target's dependents and of the target file itself
+** are compared.  With '-g', the digest of the target's expanded
+** commands is compared.  This must be called for every target that
+** might be built, whether or not the target exists, so that
+** commit_digest() knows the target's dependents and commands.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      tar     Target descriptor for target (if any).
+**      rul     Rule descriptor for rule being used (if any).
+**      srcname Name of rule's source file (NULL if no rule).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Target is up to date.
+**      0       Target must be built.
+*/
+int
+check_digest(tname, tar, rul, srcname)
+        char    *tname;
+        TARGET  *tar;
+        RULE    *rul;
+        char    *srcname;
+{
+        DIGEST          *dig;
+        unsigned long   crc;
+
+        dig = find_digest(tname, 1);
+        if (dig == (DIGEST *)NULL)
+                return 0;
+
+        /* Remember the target's dependents for commit_digest(). */
+        dig->dtar = tar;
+        dig->drul = rul;
+        if (dig->dsrc != (char *)NULL)
+        {
+                mem_free(dig->dsrc);
+                dig->dsrc = (char *)NULL;
+        }
+        if (srcname != (char *)NULL)
+        {
+                dig->dsrc = (char *)mem_alloc(strlen(srcname) + 1);
+                if (dig->dsrc == (char *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                strcpy(dig->dsrc, srcname);
+        }
+        dig->dflags |= DIG_CHECKED;
+
+        /* Compare the commands with the ones from the last build. */
+        if (CHKFLAG(FLAG_CMDSIG))
+        {
+                if (!(dig->dflags & DIG_COMMANDS) ||
+                        !cmds_digest(dig, &crc) || crc != dig->dcmd)
+                {
+                        if (CHKFLAG(FLAG_DEBUG))
+                        {
+                                mputs(MSG_DBG_CMDSCHANGED);
+                                mputs(tname);
+                                mputs("\n");
+                        }
+                        return 0;
+                }
+        }
+
+        /* Compare the digests with the ones from the last build. */
+        if (CHKFLAG(FLAG_DIGEST))
+        {
+                if (!(dig->dflags & DIG_TARGET))
+                        return 0;
+                if (!deps_digest(dig, &crc) || crc != dig->ddeps)
+                        return 0;
+                if (!file_digest(tname, &crc) || crc != dig->dout)
+                        return 0;
+        }
+
+        return 1;
+}
+
+/*
+** commit_digest:
+** Records the digests of a target, its dependents, and its
+** commands after the target has been built successfully.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**
+** Returns:
+**      NONE
+*/
+void
+commit_digest(tname)
+        char    *tname;
+{
+        DIGEST          *dig;
+        unsigned long   deps;
+        unsigned long   out;
+
+        dig = find_digest(tname, 0);
+        if (dig == (DIGEST *)NULL || !(dig->dflags & DIG_CHECKED))
+                return;
+
+        /* Record the target's commands. */
+        if (CHKFLAG(FLAG_CMDSIG) && cmds_digest(dig, &deps))
+        {
+                dig->dcmd = deps;
+                dig->dflags |= DIG_COMMANDS;
+                digest_dirty = 1;
+        }
+
+        /* A target that doesn't exist as a file can't be recorded. */
+        if (!CHKFLAG(FLAG_DIGEST) ||
+                !deps_digest(dig, &deps) || !file_digest(tname, &out))
+        {
+                return;
+        }
+
+        dig->ddeps = deps;
+        dig->dout = out;
+        dig->dflags |= DIG_TARGET;
+        digest_dirty = 1;
+}
+
+/*
+** digest_key:
+** Computes the key under which a target is kept in the artifact
+** cache, from the target's name, its commands, and the names and
+** contents of its dependents.  check_digest() must have been
+** called for the target first.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      key     Pointer to value to receive the key.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Target can't be cached.
+*/
+int
+digest_key(tname, key)
+        char            *tname;
+        unsigned long   *key;
+{
+        DIGEST          *dig;
+        unsigned long   cmds;
+        unsigned long   deps;
+        unsigned long   c;
+
+        dig = find_digest(tname, 0);
+        if (dig == (DIGEST *)NULL || !(dig->dflags & DIG_CHECKED))
+                return 0;
+        if (!cmds_digest(dig, &cmds) || !deps_digest(dig, &deps))
+                return 0;
+
+        c = crc_block(0xFFFFFFFFL, dig->dname, strlen(dig->dname));
+        c = crc_long(c, cmds);
+        c = crc_long(c, deps);
+        *key = c;
+        return 1;
+}
+
+/*
+** mark_unchanged:
+** Records that a target's commands were run but left its
+** contents the same.  The time its contents last changed is
+** kept, so it can be passed on to the targets that depend on
+** it in place of its new timestamp.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      otime   Target's timestamp before its commands were run.
+**      ntime   Target's timestamp after its commands were run.
+**
+** Returns:
+**      NONE
+*/
+void
+mark_unchanged(tname, otime, ntime)
+        char    *tname;
+        time_t  otime;
+        time_t  ntime;
+{
+        DIGEST  *dig;
+
+        dig = find_digest(tname, 1);
+        if (dig == (DIGEST *)NULL)
+                return;
+
+        /* Keep the older time if the contents were unchanged before. */
+        if (!(dig->dflags & DIG_UNCHANGED) ||
+                dig->dstamp != (unsigned long)otime)
+        {
+                dig->dchanged = (unsigned long)otime;
+        }
+        dig->dstamp = (unsigned long)ntime;
+        dig->dflags |= DIG_UNCHANGED;
+        digest_dirty = 1;
+}
+
+/*
+** mark_changed:
+** Forgets the time recorded by mark_unchanged() for a target
+** whose commands have changed its contents.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**
+** Returns:
+**      NONE
+*/
+void
+mark_changed(tname)
+        char    *tname;
+{
+        DIGEST  *dig;
+
+        dig = find_digest(tname, 0);
+        if (dig != (DIGEST *)NULL && (dig->dflags & DIG_UNCHANGED))
+        {
+                dig->dflags &= ~DIG_UNCHANGED;
+                digest_dirty = 1;
+        }
+}
+
+/*
+** last_changed:
+** Gets the time to pass on to the targets that depend on a
+** target, which is the time recorded by mark_unchanged() if
+** the target still has the timestamp it had then, or else the
+** target's own timestamp.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      ftime   Target's timestamp.
+**
+** Returns:
+**      Time the target's contents last changed.
+*/
+time_t
+last_changed(tname, ftime)
+        char    *tname;
+        time_t  ftime;
+{
+        DIGEST  *dig;
+
+        dig = find_digest(tname, 0);
+        if (dig != (DIGEST *)NULL && (dig->dflags & DIG_UNCHANGED) &&
+                dig->dstamp == (unsigned long)ftime)
+        {
+                return (time_t)dig->dchanged;
+        }
+
+        return ftime;
+}
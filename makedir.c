@@ -0,0 +1,779 @@
+/*
+======================================================================
+makedir.c
+Directory index routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+Make asks DOS about the same directories over and over:  mstat()
+is called for every target and dependent, find_rule() tries the
+basename of each undescribed target with every suffix in the
+".SUFFIXES" list (most of which don't exist), and expand_wildcard()
+scans a directory for every wildcard dependent.  Each question
+about a file that isn't in mstat()'s cache costs several DOS calls,
+and each question about a file that doesn't exist costs one.
+
+A directory index holds the name, time/date stamp, size, and
+attributes of every entry in one directory, read with a single
+_dos_findfirst()/_dos_findnext() scan.  The names are kept in
+directory order in a STRVEC, so wildcard scans see them in the same
+order as DOS returns them, along with an array of the entry numbers
+sorted by name, so dir_mstat() can find a name with a binary search.
+A name that isn't in the index doesn't exist, so misses are answered
+without asking DOS at all.
+
+Reading a directory costs one DOS call per entry, which is more than
+a few lookups cost, so the index for a directory is only read after
+DIR_MINPROBES lookups in it have gone to DOS.  A wildcard scan reads
+it right away, since it has to look at every entry anyway.  The
+entries grow on demand, so a directory is indexed unless it has
+more entries than fit in one block of memory.  Directories after
+the first DIR_MAXDIRS are never indexed; their lookups and scans go
+to DOS as before.
+
+Whenever make does something that may change a file, forget_mstat()
+calls forget_dirent(), which marks that file's entry in the index of
+its own directory as stale, adding an entry if the file wasn't there.
+Lookups of a stale entry go to DOS, while every other name is still
+answered from the index.  A wildcard scan reads a directory with
+stale entries again, which makes them current.  As with mstat()'s
+cache, only the files make is told about are noticed; other files
+that commands happen to create or change are not.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static int      split_dir(char *fname, char *dname);
+static int      is_dos_name(char *name);
+static DIRIDX   *get_dir(char *fname, int make);
+static void     free_dir(DIRIDX *dir);
+static int      grow_dir(DIRIDX *dir);
+static int      read_dir(DIRIDX *dir);
+static int      find_entry(DIRIDX *dir, char *name, unsigned int *pos);
+static int      add_stale(DIRIDX *dir, char *name, unsigned int pos);
+static int      compare_names(const void *a, const void *b);
+
+/****************************** CONSTANTS ***************************/
+
+/* Most directories that will be indexed. */
+#define DIR_MAXDIRS     16
+
+/* Number of lookups that go to DOS before a directory is read. */
+#define DIR_MINPROBES   8
+
+/* Attributes of the entries that are kept in an index. */
+#define DIR_ATTRIBS     (_A_NORMAL | _A_ARCH | _A_SUBDIR | \
+                         _A_HIDDEN | _A_SYSTEM | _A_RDONLY)
+
+/****************************** VARIABLES ***************************/
+
+/* dir_list:  Linked list of directory indexes. */
+static DIRIDX *dir_list;
+
+/* dir_count:  Number of directories in dir_list. */
+static int dir_count;
+
+/* sort_dir:  Directory whose entries compare_names() is sorting. */
+static DIRIDX *sort_dir;
+
+/*
+** Number of directory scans, and number of dir_mstat() lookups
+** answered from an index.
+*/
+static unsigned long dir_reads;
+static unsigned long dir_hits;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** split_dir:
+** Gets the drive/directory part of a filename, in the same way
+** as getpath() does for wildcard scans.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Filename to split.
+**      dname   Buffer of MAXPATH bytes to receive the drive/
+**              directory part in lowercase, including any
+**              trailing backslash or colon.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      -1      Directory part is too long.
+**      other   Length of the drive/directory part.
+*/
+static int
+split_dir(fname, dname)
+        char    *fname;
+        char    *dname;
+{
+        int     i;
+        int     len = 0;
+
+        for (i = 0; fname[i] != '\0'; i++)
+        {
+                if (fname[i] == '\\' || fname[i] == ':')
+                        len = i + 1;
+        }
+
+        /* Leave room for the "*.*" of a directory scan. */
+        if (len > MAXPATH - 4)
+                return -1;
+
+        memcpy(dname, fname, len);
+        dname[len] = '\0';
+        strlwr(dname);
+
+        return len;
+}
+
+/*
+** is_dos_name:
+** Checks if a filename (without any directory) is spelled
+** exactly as DOS would return it from a directory scan, apart
+** from case.  Other names, such as ones that DOS would shorten
+** to eight characters, can't be looked up in an index.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      name    Filename to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Name can be looked up in an index.
+**      0       Name must be looked up by DOS.
+*/
+static int
+is_dos_name(name)
+        char    *name;
+{
+        int     i;
+        int     dot = -1;       /* Position of '.', if any. */
+
+        for (i = 0; name[i] != '\0'; i++)
+        {
+                if (name[i] == '.')
+                {
+                        if (dot >= 0)
+                                return 0;
+                        dot = i;
+                }
+                else if ((unsigned char)name[i] <= ' ' ||
+                        (unsigned char)name[i] >= 128 ||
+                        strchr("*?/\\:\"<>|+=;,[]", name[i]) != (char *)NULL)
+                {
+                        return 0;
+                }
+        }
+
+        if (dot < 0)
+                return i >= 1 && i <= 8;
+        return dot >= 1 && dot <= 8 && i - dot - 1 >= 1 && i - dot - 1 <= 3;
+}
+
+/*
+** get_dir:
+** Finds the index for the directory part of a filename, making
+** a new, unread one if there isn't one yet and 'make' is set.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Filename whose directory is wanted.
+**      make    Nonzero to make an index if there isn't one.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Directory can't be indexed.
+**      other   Pointer to directory's index.
+*/
+static DIRIDX *
+get_dir(fname, make)
+        char    *fname;
+        int     make;
+{
+        DIRIDX          *dir;
+        char            dname[MAXPATH];
+        unsigned int    hash;
+
+        if (split_dir(fname, dname) < 0)
+                return (DIRIDX *)NULL;
+        hash = hash_name(dname);
+
+        for (dir = dir_list; dir != (DIRIDX *)NULL; dir = dir->dnext)
+        {
+                if (dir->dhash == hash && strcmp(dir->dname, dname) == 0)
+                        return dir;
+        }
+
+        if (!make || dir_count >= DIR_MAXDIRS)
+                return (DIRIDX *)NULL;
+
+        /* Make a new index, which gets read later. */
+        dir = (DIRIDX *)mem_alloc(sizeof(DIRIDX));
+        if (dir == (DIRIDX *)NULL)
+                return (DIRIDX *)NULL;
+        dir->dname = (char *)mem_alloc(strlen(dname) + 1);
+        if (dir->dname == (char *)NULL)
+        {
+                mem_free(dir);
+                return (DIRIDX *)NULL;
+        }
+        strcpy(dir->dname, dname);
+        dir->dlen = strlen(dname);
+        dir->dhash = hash;
+        init_strvec(&dir->dnames);
+        dir->dents = (DENTRY *)NULL;
+        dir->dsorted = (unsigned int *)NULL;
+        dir->dmax = 0;
+        dir->dstale = 0;
+        dir->dprobes = 0;
+        dir->dstate = DIR_UNREAD;
+
+        dir->dnext = dir_list;
+        dir_list = dir;
+        dir_count++;
+
+        return dir;
+}
+
+/*
+** free_dir:
+** Frees the entries of a directory index.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Directory index to empty.
+**
+** Returns:
+**      NONE
+*/
+static void
+free_dir(dir)
+        DIRIDX  *dir;
+{
+        flush_strvec(&dir->dnames);
+        if (dir->dents != (DENTRY *)NULL)
+                mem_free(dir->dents);
+        if (dir->dsorted != (unsigned int *)NULL)
+                mem_free(dir->dsorted);
+        dir->dents = (DENTRY *)NULL;
+        dir->dsorted = (unsigned int *)NULL;
+        dir->dmax = 0;
+        dir->dstale = 0;
+}
+
+/*
+** grow_dir:
+** Doubles the number of entries a directory index has room
+** for, in both its entry array and its sorted entry numbers.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Directory index to grow.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Too many entries for one block, or out of memory.
+*/
+static int
+grow_dir(dir)
+        DIRIDX  *dir;
+{
+        unsigned int    n;
+        unsigned int    count;
+        char            *p;
+
+        n = (dir->dmax == 0) ? 32 : dir->dmax * 2;
+        if (n <= dir->dmax || n > MAXALLOC / sizeof(DENTRY))
+                return 0;
+        count = dir->dnames.vcount;
+
+        p = grow_block((char *)dir->dents, count * sizeof(DENTRY),
+                n * sizeof(DENTRY));
+        if (p == (char *)NULL)
+                return 0;
+        dir->dents = (DENTRY *)p;
+
+        p = grow_block((char *)dir->dsorted, count * sizeof(unsigned int),
+                n * sizeof(unsigned int));
+        if (p == (char *)NULL)
+                return 0;
+        dir->dsorted = (unsigned int *)p;
+
+        dir->dmax = n;
+        return 1;
+}
+
+/*
+** read_dir:
+** Reads (or reads again) the entries of a directory into its
+** index.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Directory index to fill in.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Directory is too large, or out of memory.  The
+**              directory won't be indexed again.
+*/
+static int
+read_dir(dir)
+        DIRIDX  *dir;
+{
+        struct find_t   findbfr;        /* Buffer for _dos_find...() */
+        char            pattern[MAXPATH];
+        unsigned int    count = 0;      /* Number of entries read. */
+        unsigned int    i;
+        int             result;
+
+        free_dir(dir);
+        dir->dprobes = 0;
+        dir->dstate = DIR_UNUSABLE;
+        dir_reads++;
+
+        /* Scan every entry in the directory. */
+        strcpy(pattern, dir->dname);
+        strcat(pattern, "*.*");
+        result = _dos_findfirst(pattern, DIR_ATTRIBS, &findbfr);
+        while (!result)
+        {
+                /* Skip the "." and ".." entries. */
+                if (findbfr.name[0] == '.')
+                {
+                        result = _dos_findnext(&findbfr);
+                        continue;
+                }
+
+                /* Make room for another entry. */
+                if (count >= dir->dmax && !grow_dir(dir))
+                {
+                        /* Too large to index. */
+                        free_dir(dir);
+                        return 0;
+                }
+
+                /* Add the entry; names are kept in lowercase. */
+                strlwr(findbfr.name);
+                if (!add_strvec(&dir->dnames, findbfr.name))
+                {
+                        free_dir(dir);
+                        return 0;
+                }
+                dir->dents[count].dtime =
+                        ((unsigned long)findbfr.wr_date << 16) +
+                                (unsigned long)findbfr.wr_time;
+                dir->dents[count].dsize = findbfr.size;
+                dir->dents[count].dattrib = findbfr.attrib;
+                count++;
+
+                result = _dos_findnext(&findbfr);
+        }
+
+        /* Sort the entry numbers by name for dir_mstat(). */
+        if (count > 0)
+        {
+                for (i = 0; i < count; i++)
+                        dir->dsorted[i] = i;
+                sort_dir = dir;
+                qsort(dir->dsorted, count, sizeof(unsigned int),
+                        compare_names);
+        }
+
+        dir->dstate = DIR_READ;
+        return 1;
+}
+
+/*
+** compare_names:
+** Compares the names of two entries in the directory being
+** sorted by read_dir().  Used with qsort().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      a       Pointer to first entry number.
+**      b       Pointer to second entry number.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      <0      First name sorts before second.
+**      0       Names are the same.
+**      >0      First name sorts after second.
+*/
+static int
+compare_names(a, b)
+        const void      *a;
+        const void      *b;
+{
+        return strcmp(VSTR(&sort_dir->dnames, *(unsigned int *)a),
+                VSTR(&sort_dir->dnames, *(unsigned int *)b));
+}
+
+/*
+** find_entry:
+** Looks for a name in the sorted entry numbers of a directory
+** index.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Directory index to search.
+**      name    Filename (without directory) in lowercase.
+**      pos     Pointer to receive the position of the name in
+**              dsorted, or where it would be inserted.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Name was found.
+**      0       Name isn't in the index.
+*/
+static int
+find_entry(dir, name, pos)
+        DIRIDX          *dir;
+        char            *name;
+        unsigned int    *pos;
+{
+        unsigned int    lo, hi, mid;
+        int             cmp;
+
+        lo = 0;
+        hi = dir->dnames.vcount;
+        while (lo < hi)
+        {
+                mid = (lo + hi) / 2;
+                cmp = strcmp(name, VSTR(&dir->dnames, dir->dsorted[mid]));
+                if (cmp == 0)
+                {
+                        *pos = mid;
+                        return 1;
+                }
+                if (cmp < 0)
+                        hi = mid;
+                else
+                        lo = mid + 1;
+        }
+
+        *pos = lo;
+        return 0;
+}
+
+/*
+** add_stale:
+** Adds a stale entry for a name that isn't in a directory
+** index, so lookups of the name go to DOS.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Directory index to add to.
+**      name    Filename (without directory) in lowercase.
+**      pos     Position in dsorted where the name belongs, as
+**              returned by find_entry().
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+add_stale(dir, name, pos)
+        DIRIDX          *dir;
+        char            *name;
+        unsigned int    pos;
+{
+        unsigned int    count;
+
+        count = dir->dnames.vcount;
+        if (count >= dir->dmax && !grow_dir(dir))
+                return 0;
+        if (!add_strvec(&dir->dnames, name))
+                return 0;
+
+        dir->dents[count].dtime = 0L;
+        dir->dents[count].dsize = 0L;
+        dir->dents[count].dattrib = DENT_STALE;
+        memmove(&dir->dsorted[pos + 1], &dir->dsorted[pos],
+                (count - pos) * sizeof(unsigned int));
+        dir->dsorted[pos] = count;
+        dir->dstale++;
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_dirs:
+** Initializes the list of directory indexes.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_dirs(void)
+{
+        dir_list = (DIRIDX *)NULL;
+        dir_count = 0;
+        dir_reads = 0L;
+        dir_hits = 0L;
+}
+
+/*
+** flush_dirs:
+** Frees all of the directory indexes.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_dirs(void)
+{
+        DIRIDX  *dir;
+
+        while (dir_list != (DIRIDX *)NULL)
+        {
+                dir = dir_list;
+                dir_list = dir->dnext;
+                free_dir(dir);
+                mem_free(dir->dname);
+                mem_free(dir);
+        }
+        dir_count = 0;
+}
+
+/*
+** forget_dirent:
+** Marks a file's entry in the index of its directory as stale.
+** This must be called whenever make does something that may
+** create, change, or delete the file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file that may have changed.
+**
+** Returns:
+**      NONE
+*/
+void
+forget_dirent(fname)
+        char    *fname;
+{
+        DIRIDX          *dir;
+        char            lname[MAXPATH];
+        unsigned int    pos;
+        DENTRY          *ent;
+
+        dir = get_dir(fname, 0);
+        if (dir == (DIRIDX *)NULL || dir->dstate != DIR_READ)
+                return;
+
+        /*
+        ** DOS may store a name it would shorten under another
+        ** name, so the whole directory must be read again.
+        */
+        if (!is_dos_name(&fname[dir->dlen]))
+        {
+                dir->dstate = DIR_UNREAD;
+                return;
+        }
+
+        strcpy(lname, &fname[dir->dlen]);
+        strlwr(lname);
+        if (find_entry(dir, lname, &pos))
+        {
+                ent = &dir->dents[dir->dsorted[pos]];
+                if (!(ent->dattrib & DENT_STALE))
+                {
+                        ent->dattrib |= DENT_STALE;
+                        dir->dstale++;
+                }
+        }
+        else if (!add_stale(dir, lname, pos))
+        {
+                /* No room to note the name; read it all again. */
+                dir->dstate = DIR_UNREAD;
+        }
+}
+
+/*
+** scan_dir:
+** Gets an up to date index of the directory part of a filespec,
+** for a wildcard scan.  The directory is read (or read again)
+** if necessary.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fspec   Filespec whose directory is to be scanned.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Directory can't be indexed; scan it with DOS.
+**      other   Pointer to directory's index.  The filename
+**              part of fspec starts at fspec[dlen].
+*/
+DIRIDX *
+scan_dir(fspec)
+        char    *fspec;
+{
+        DIRIDX  *dir;
+
+        dir = get_dir(fspec, 1);
+        if (dir == (DIRIDX *)NULL || dir->dstate == DIR_UNUSABLE)
+                return (DIRIDX *)NULL;
+
+        if (dir->dstate == DIR_UNREAD || dir->dstale > 0)
+        {
+                if (!read_dir(dir))
+                        return (DIRIDX *)NULL;
+        }
+
+        return dir;
+}
+
+/*
+** dir_mstat:
+** Looks up the time/date stamp and size of a file in the index
+** of its directory.  Called by mstat() for files that aren't in
+** its cache.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to get status of.
+**      tstat   Pointer to mstat_t structure to
+**              put time/date stamp and size of file into.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      0       File exists; tstat was filled in.
+**      1       File doesn't exist.
+**      -1      Index can't tell; ask DOS.
+*/
+int
+dir_mstat(fname, tstat)
+        char            *fname;
+        struct mstat_t  *tstat;
+{
+        DIRIDX          *dir;
+        DENTRY          *ent;
+        char            lname[MAXPATH];
+        unsigned int    pos;
+
+        dir = get_dir(fname, 1);
+        if (dir == (DIRIDX *)NULL || dir->dstate == DIR_UNUSABLE)
+                return -1;
+        if (!is_dos_name(&fname[dir->dlen]))
+                return -1;
+
+        /*
+        ** Read the directory once enough lookups have gone to DOS,
+        ** counting its size against it if it is being read again.
+        */
+        if (dir->dstate == DIR_UNREAD)
+        {
+                if (++dir->dprobes < DIR_MINPROBES + dir->dnames.vcount / 4)
+                        return -1;
+                if (!read_dir(dir))
+                        return -1;
+        }
+
+        /* Look for the name in the sorted entry numbers. */
+        strcpy(lname, &fname[dir->dlen]);
+        strlwr(lname);
+        if (!find_entry(dir, lname, &pos))
+        {
+                /* Not in the directory, so it doesn't exist. */
+                dir_hits++;
+                return 1;
+        }
+
+        /* A file make may have changed must be looked up by DOS. */
+        ent = &dir->dents[dir->dsorted[pos]];
+        if (ent->dattrib & DENT_STALE)
+                return -1;
+        dir_hits++;
+
+        /* DOS can't open a directory as a file. */
+        if (ent->dattrib & _A_SUBDIR)
+                return 1;
+        tstat->st_mtime = ent->dtime;
+        tstat->st_size = ent->dsize;
+        return 0;
+}
+
+/*
+** dump_dirs:
+** Outputs the number of directory scans and the number of
+** lookups that were answered from a directory index.  This
+** function is used for debugging.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_dirs(void)
+{
+        mputs(MSG_DBG_DIRREADS);
+        mputs(multoa(dir_reads));
+        mputs(MSG_DBG_DIRHITS);
+        mputs(multoa(dir_hits));
+        mputs("\n");
+}
@@ -0,0 +1,439 @@
+/*
+======================================================================
+makeexec.c
+Command launching routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+spawn_command() runs a command line for run_command() under MS-DOS
+and OS/2.  Loading a second copy of the command interpreter for
+every command is slow, so commands are spawned directly whenever
+possible:
+
+The command line is split into arguments by split_command().
+Whitespace inside double quotes doesn't split arguments, and the
+quotes are passed along to the program, which does its own
+parsing of its command tail.  There is no fixed limit on the
+number of arguments.
+
+Simple input and output redirections ("<file", ">file", and
+">>file") are handled here, by opening the files and pointing the
+standard input and output handles at them while the program is
+spawned, the same way the command interpreter does it.
+
+Only command lines that use pipes, which need the command
+interpreter to run more than one program, are passed to the
+command interpreter named by the COMSPEC environment variable.
+If a program can't be found, the command is assumed to be one that
+is built into the command interpreter (such as "copy" or "del") or
+a batch file, and is passed to the command interpreter too.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+#include <process.h>
+#include <errno.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static int      needs_shell(char *line);
+static int      split_command(char *line, char *bfr, char *plain,
+                        char **margv, char **infile, char **outfile,
+                        int *append);
+static int      redirect(int handle, char *fname, int oflag);
+static void     restore(int handle, int saved);
+static int      spawn_shell(int mode, char *line);
+
+/****************************** CONSTANTS ***************************/
+
+/* Command interpreter to use if COMSPEC isn't set. */
+#define DEFAULT_SHELL   "command.com"
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** needs_shell:
+** Checks if a command line must be run by the command
+** interpreter because it uses a pipe.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    Command line to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Command interpreter is needed.
+**      0       Command can be spawned directly.
+*/
+static int
+needs_shell(line)
+        char    *line;
+{
+        int     inquote = 0;
+
+        while (*line != '\0')
+        {
+                if (*line == '"')
+                        inquote = !inquote;
+                else if (*line == '|' && !inquote)
+                        return 1;
+                line++;
+        }
+
+        return 0;
+}
+
+/*
+** split_command:
+** Splits a command line into arguments and redirections.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    Command line to split.
+**      bfr     Buffer to receive arguments, at least as large
+**              as the command line.
+**      plain   Buffer to receive the command line without its
+**              redirections, at least as large as the command line.
+**      margv   Array to receive pointers to arguments, with at
+**              least one entry for every two characters in the
+**              command line, plus two.
+**      infile  Pointer to receive name of input file (or NULL).
+**      outfile Pointer to receive name of output file (or NULL).
+**      append  Pointer to flag, set if output is to be appended.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      other   Number of arguments.
+**      -1      Redirection syntax isn't understood.
+*/
+static int
+split_command(line, bfr, plain, margv, infile, outfile, append)
+        char    *line;
+        char    *bfr;
+        char    *plain;
+        char    **margv;
+        char    **infile;
+        char    **outfile;
+        int     *append;
+{
+        int     margc = 0;
+        int     kind;           /* '<', '>', or 0 for an argument. */
+        int     inquote;
+        char    *start;
+        char    *pstart = plain;
+
+        *infile = (char *)NULL;
+        *outfile = (char *)NULL;
+        *append = 0;
+        *plain = '\0';
+
+        for (;;)
+        {
+                /* Skip whitespace before next argument. */
+                while (*line == ' ' || *line == '\t')
+                        line++;
+                if (*line == '\0')
+                        break;
+
+                /* Check for a redirection. */
+                kind = 0;
+                if (*line == '<' || *line == '>')
+                {
+                        kind = *line++;
+                        if (kind == '>' && *line == '>')
+                        {
+                                *append = 1;
+                                line++;
+                        }
+                        while (*line == ' ' || *line == '\t')
+                                line++;
+                }
+
+                /* Copy the argument, keeping quoted whitespace. */
+                start = bfr;
+                inquote = 0;
+                if (kind == 0 && plain != pstart)
+                        *plain++ = ' ';
+                while (*line != '\0')
+                {
+                        if (!inquote && (*line == ' ' || *line == '\t' ||
+                                *line == '<' || *line == '>'))
+                        {
+                                break;
+                        }
+                        if (*line == '"')
+                                inquote = !inquote;
+                        if (kind == 0)
+                                *plain++ = *line;
+                        if (kind == 0 || *line != '"')
+                                *bfr++ = *line;
+                        line++;
+                }
+                *bfr++ = '\0';
+                *plain = '\0';
+
+                if (kind == 0)
+                {
+                        margv[margc++] = start;
+                }
+                else if (*start == '\0' ||
+                        (kind == '<' && *infile != (char *)NULL) ||
+                        (kind == '>' && *outfile != (char *)NULL))
+                {
+                        /* Leave anything unusual to the interpreter. */
+                        return -1;
+                }
+                else if (kind == '<')
+                {
+                        *infile = start;
+                }
+                else
+                {
+                        *outfile = start;
+                }
+        }
+
+        margv[margc] = (char *)NULL;
+        return margc;
+}
+
+/*
+** redirect:
+** Points a standard handle at a file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      handle  Standard handle to redirect (0 or 1).
+**      fname   Name of file.
+**      oflag   Flags for opening the file.  If O_APPEND is
+**              set, the handle is positioned at the end of
+**              the file.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      -1      Error occurred (errno is set).
+**      other   Copy of original handle, for restore().
+*/
+static int
+redirect(handle, fname, oflag)
+        int     handle;
+        char    *fname;
+        int     oflag;
+{
+        int     fh;
+        int     saved;
+
+        fh = open(fname, oflag, S_IREAD | S_IWRITE);
+        if (fh == -1)
+                return -1;
+
+        /*
+        ** O_APPEND only makes our own write() calls seek to the
+        ** end; the child gets the raw handle, so move it there.
+        */
+        if ((oflag & O_APPEND) && lseek(fh, 0L, SEEK_END) == -1L)
+        {
+                close(fh);
+                return -1;
+        }
+
+        saved = dup(handle);
+        if (saved == -1 || dup2(fh, handle) == -1)
+        {
+                if (saved != -1)
+                        close(saved);
+                close(fh);
+                return -1;
+        }
+        close(fh);
+
+        return saved;
+}
+
+/*
+** restore:
+** Points a standard handle back where it was before redirect().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      handle  Standard handle that was redirected.
+**      saved   Value returned by redirect().
+**
+** Returns:
+**      NONE
+*/
+static void
+restore(handle, saved)
+        int     handle;
+        int     saved;
+{
+        dup2(saved, handle);
+        close(saved);
+}
+
+/*
+** spawn_shell:
+** Runs a command line with the command interpreter.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      mode    P_WAIT or P_NOWAIT.
+**      line    Command line to run.
+**
+** Returns:
+**      Same as spawnvp().
+*/
+static int
+spawn_shell(mode, line)
+        int     mode;
+        char    *line;
+{
+        char    *margv[4];
+
+        margv[0] = getenv("COMSPEC");
+        if (margv[0] == (char *)NULL || margv[0][0] == '\0')
+                margv[0] = DEFAULT_SHELL;
+        margv[1] = "/c";
+        margv[2] = line;
+        margv[3] = (char *)NULL;
+
+        return spawnvp(mode, margv[0], margv);
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** spawn_command:
+** Runs a command line, spawning the program directly when the
+** command interpreter isn't needed.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      mode    P_WAIT or P_NOWAIT.
+**      line    Command line to run.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      -1      Command couldn't be run (errno is set).
+**      other   Return code of command (P_WAIT), or process
+**              ID of command (P_NOWAIT).
+*/
+int
+spawn_command(mode, line)
+        int     mode;
+        char    *line;
+{
+        unsigned len;
+        char    *bfr;
+        char    *plain;
+        char    **margv;
+        char    *infile;
+        char    *outfile;
+        int     append;
+        int     margc;
+        int     savein = -1;
+        int     saveout = -1;
+        int     result = -1;
+        int     err;
+
+        /* Pipes need the command interpreter. */
+        if (needs_shell(line))
+                return spawn_shell(mode, line);
+
+        /* Get buffers big enough for any split of the line. */
+        len = strlen(line) + 1;
+        bfr = (char *)mem_alloc(len * 2);
+        margv = (char **)mem_alloc((len / 2 + 2) * sizeof(char *));
+        if (bfr == (char *)NULL || margv == (char **)NULL)
+        {
+                if (bfr != (char *)NULL)
+                        mem_free(bfr);
+                errno = ENOMEM;
+                return -1;
+        }
+        plain = &bfr[len];
+
+        margc = split_command(line, bfr, plain, margv,
+                &infile, &outfile, &append);
+        if (margc == -1)
+        {
+                /* Let the command interpreter make sense of it. */
+                result = spawn_shell(mode, line);
+        }
+        else if (margc == 0)
+        {
+                /* Nothing to run. */
+                result = 0;
+        }
+        else
+        {
+                /* Set up the redirections. */
+                if (outfile != (char *)NULL)
+                {
+                        saveout = redirect(1, outfile, O_WRONLY | O_CREAT |
+                                O_TEXT | (append ? O_APPEND : O_TRUNC));
+                }
+                if (infile != (char *)NULL &&
+                        (outfile == (char *)NULL || saveout != -1))
+                {
+                        savein = redirect(0, infile, O_RDONLY | O_TEXT);
+                }
+
+                if ((outfile == (char *)NULL || saveout != -1) &&
+                        (infile == (char *)NULL || savein != -1))
+                {
+                        result = spawnvp(mode, margv[0], margv);
+                        if (result == -1 && errno == ENOENT)
+                        {
+                                /*
+                                ** Not a program; try it as a built-in
+                                ** command or a batch file.
+                                */
+                                result = spawn_shell(mode, plain);
+                        }
+                }
+
+                /* Put the standard handles back. */
+                err = errno;
+                if (savein != -1)
+                        restore(0, savein);
+                if (saveout != -1)
+                        restore(1, saveout);
+                errno = err;
+        }
+
+        mem_free(margv);
+        mem_free(bfr);
+        return result;
+}
@@ -41,8 +41,13 @@ Buffering:
 
 Raw data from the makefile is blocked into a buffer called 'iobfr'
 rather than reading one byte at a time from the file.  The
-read_logical_line() routine then reads from 'iobfr' a byte at a
-time as it needs, refilling 'iobfr' whenever it becomes empty.
+read_logical_line() routine then finds the end of each physical
+line in 'iobfr' with memchr(), and copies the whole line into the
+caller's buffer at once, leaving off the carriage return at the
+end of the line.  Only lines with carriage returns in the middle of
+them are copied a byte at a time.  'iobfr' is refilled whenever it
+becomes empty.  Continuation lines are joined by appending the next
+physical line in place of the trailing backslash.
 
 Since it is necessary for the make utility to sometimes back up
 the input, a mechanism has been provided for backing up one
@@ -52,6 +57,28 @@ data being unread, called 'unread_lbfr'.  The next call to
 read_logical_line() will check 'unread_lbfr', and use its contents
 before processing more data from 'iobfr'.
 
+
+Include Files:
+
+The "!INCLUDE filename" directive reads the lines of another file
+as if they appeared in place of the directive.  If the filename is
+enclosed in angle brackets, the directories listed in the INCLUDE
+environment variable are searched for it.
+
+The first time a file is included, all of its logical lines are
+read into a list of lines, using a separate 'iobfr', and the list
+is kept until the program ends.  Each time the file is included,
+the lines are replayed from the list, so a fragment included from
+many places is only read and scanned once.  Since named macros are
+only expanded as each line is replayed, and directives are still
+handled then, a fragment behaves the same as if its text were
+pasted in.  Comment lines are left out of the list.
+
+Included files being replayed are kept on a stack, so included
+files may include other files, up to MAXINCS deep.  A fragment
+that contains a "!ONCE" directive is only replayed the first time
+it is included.
+
 ======================================================================
 */
 
@@ -71,6 +98,8 @@ before processing more data from 'iobfr'.
 
 #include "make.h"
 
+#include "cvtslash.h"
+
 /****************************** HEADERS *****************************/
 
 /* Functions that are local to this file: */
@@ -78,12 +107,18 @@ static int do_psuedo(char *line);
 static int line_type(char *line);
 static int init_input_buffers(void);
 static void deinit_input_buffers(void);
+static int read_physical_lines(int handle, char *str, int maxlen,
+                char *has_dollar);
+static int expand_line(char *str, int maxlen);
+static INCFILE *load_include(char *fname, char *str, int maxlen);
+static int do_include(char *line, char *str, int maxlen);
 static int local_read_logical_line(int handle, char *str, int maxlen);
 
 /****************************** CONSTANTS ***************************/
 
-#define MAXIO   1024    /* Size of I/O buffer. */
+#define MAXIO   8192    /* Size of I/O buffer. */
 #define MAXIFS  8       /* Maximum nesting level of !IFs. */
+#define MAXINCS 8       /* Maximum nesting level of !INCLUDEs. */
 
 /****************************** VARIABLES ***************************/
 
@@ -99,12 +134,26 @@ static char *unread_lbfr;
 static char     ifmode[MAXIFS];
 static int      iflevel;
 
+/* include_list:  Files that have been read by !INCLUDE. */
+static INCFILE  *include_list;
+static INCFILE  *include_tail;
+
+/*
+** incfile:  Stack of included files being replayed, with the
+** next line to replay from each, and the !IF level outside each.
+** inclevel is -1 when reading from the makefile itself.
+*/
+static INCFILE  *incfile[MAXINCS];
+static LINE     *incnext[MAXINCS];
+static int      incif[MAXINCS];
+static int      inclevel;
+
 /*************************** LOCAL FUNCTIONS ************************/
 
 /*
 ** do_psuedo:
 ** Parses psuedo-target lines.  Handles ".SUFFIXES", ".IGNORE",
-** ".SILENT", and ".PRECIOUS".
+** ".SILENT", ".PRECIOUS", and ".RESTAT".
 **
 ** Parameters:
 **      Name    Description
@@ -137,6 +186,22 @@ do_psuedo(line)
                         return 0;
                 }
         }
+        else if (strncmp(line, ".RESTAT", 7) == 0)
+        {
+                if (!do_restat(line))
+                {
+                        /* Failed handling ".RESTAT" */
+                        return 0;
+                }
+        }
+        else if (strncmp(line, ".PHONY", 6) == 0)
+        {
+                if (!do_phony(line))
+                {
+                        /* Failed handling ".PHONY" */
+                        return 0;
+                }
+        }
         else if (strncmp(line, ".IGNORE", 7) == 0)
         {
                 SETFLAG(FLAG_IGNORE);
@@ -174,6 +239,7 @@ do_psuedo(line)
 **      3       Line is the start of a psuedo-target (i.e. ".SUFFIXES").
 **      4       Line is the start of a rule.
 **      5       Line is the start of a target.
+**      6       Line is the start of a pattern rule.
 */
 static int
 line_type(line)
@@ -181,6 +247,7 @@ line_type(line)
 {
         int     i;              /* Loop index. */
         int     allwhite;       /* Flag. */
+        int     pct;            /* Flag, nonzero if '%' seen. */
 
         /*
         ** Check for the different types of makefile sections:
@@ -206,6 +273,11 @@ line_type(line)
         **      |.ext.ext:
         **      |       [commands]
         **
+        ** A pattern rule of the form:
+        **      |
+        **      |dir\%.ext: dir\%.ext
+        **      |       [commands]
+        **
         ** A target of the form:
         **      |
         **      |target.trg: [dependents]
@@ -267,6 +339,31 @@ line_type(line)
                 return 2;
         }
 
+        /*
+        ** Check for a pattern rule.  If the first
+        ** token on the line contains a '%' and is
+        ** followed by a colon, we assume it is a
+        ** pattern rule.
+        */
+        i = 0;
+        pct = 0;
+        while (line[i] != '\0' &&
+                line[i] != ' ' &&
+                line[i] != '\t' &&
+                !(line[i] == ':' && line[i + 1] != '\\'))
+        {
+                if (line[i] == '%')
+                        pct = 1;
+                i++;
+        }
+        while (line[i] == ' ' || line[i] == '\t')
+                i++;
+        if (pct && line[i] == ':')
+        {
+                /* Line is a pattern rule. */
+                return 6;
+        }
+
         /*
         ** Check for a rule definition.  If the
         ** first five tokens on the line are
@@ -370,6 +467,7 @@ init_input_buffers(void)
         }
 
         iflevel = -1;
+        inclevel = -1;
 
         return 1;
 }
@@ -406,15 +504,14 @@ deinit_input_buffers(void)
         unread_lbfr = (char *)NULL;
 
         iflevel = -1;
+        inclevel = -1;
 }
 
 /*
-** local_read_logical_line:
-** Reads a logical line of text from the makefile.  A logical
-** line is one line of text which is a combination of the next
-** physical line from the makefile plus any physical continuation
-** lines indicated by a trailing backslash on the previous line.
-** Called by read_logical_line().
+** read_physical_lines:
+** Reads physical lines from a file until the end of a logical
+** line, joining any continuation lines.  Named macros are not
+** expanded.
 **
 ** Parameters:
 **      Name    Description
@@ -422,49 +519,40 @@ deinit_input_buffers(void)
 **      handle  Open file handle to read from.
 **      str     Buffer to read into.
 **      maxlen  Maximum number of bytes to read.
+**      has_dollar Pointer to flag, set if the line contains a '$'.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
 **      1       If successful.
-**      0       If end-of-file or I/O error occurs.
-**      -1      If line exceeds maximum length or fatal error
-**              occurs.
+**      0       If end-of-file occurs.
+**      -1      If line exceeds maximum length or an I/O
+**              error occurs.
 */
 static int
-local_read_logical_line(handle, str, maxlen)
+read_physical_lines(handle, str, maxlen, has_dollar)
         int     handle;
         char    *str;
         int     maxlen;
+        char    *has_dollar;
 {
         char    *sstart = str;  /* Copy of original string pointer. */
         int     bytes = 0;      /* Number of bytes in line so far. */
-        char    last = '\0';    /* Last character placed in buffer. */
-        char    last2 = '\0';   /* Second to last char placed in buffer. */
-        char    *tmp;           /* Buffer for macro expansion. */
-        int     eresult;        /* Result of last macro expansion. */
-        char    has_dollar = 0; /* Flag, nonzero if line contains a '$'. */
-
-        /* Check if the unread buffer has something in it. */
-        if (unread_lbfr != (char *)NULL)
-        {
-                if (strlen(unread_lbfr) > (unsigned)maxlen)
-                {
-                        /* Unread buffer is too long for caller's buffer. */
-                        errmsg(MSG_ERR_UNREADLEN, (char *)NULL, NOVAL);
-                        return -1;
-                }
-                strcpy(str, unread_lbfr);
-                mem_free(unread_lbfr);
-                unread_lbfr = (char *)NULL;
-                return 1;
-        }
+        char    *pline;         /* Start of current physical line. */
+        char    *src;           /* Start of bytes to copy from iobfr. */
+        char    *eol;           /* End of line in iobfr. */
+        int     span;           /* Number of bytes to copy from iobfr. */
+        int     count;          /* Number of bytes to keep from iobfr. */
+        char    *cr;            /* Carriage return found in iobfr. */
+        char    *dst;           /* Where to move kept bytes in iobfr. */
 
         /*
-        ** Read characters from the input file until the
-        ** end of a line is found or an error occurs.
+        ** Copy physical lines from the input buffer until the
+        ** end of a logical line is found or an error occurs.
         */
+        *has_dollar = 0;
         *str = '\0';
+        pline = str;
         while (1)
         {
                 /* See if we need to read a new buffer full of data. */
@@ -495,87 +583,464 @@ local_read_logical_line(handle, str, maxlen)
                         return 0;
                 }
 
-                /* Copy byte from input buffer to caller's buffer. */
-                *str = iobfr[iopos++];
-                if (*str == '$')
-                        has_dollar = 1;
+                /*
+                ** Find the end of the physical line, or of the
+                ** buffered data if the line goes past it.
+                */
+                src = &iobfr[iopos];
+                span = iosize - iopos;
+                eol = (char *)memchr(src, '\n', span);
+                if (eol != (char *)NULL)
+                        span = (int)(eol - src);
+                eol = (char *)memchr(src, '\0', span);
+                if (eol != (char *)NULL)
+                        span = (int)(eol - src);
+                iopos += span;
+
+                if (!*has_dollar && memchr(src, '$', span) != (void *)NULL)
+                        *has_dollar = 1;
 
-                /* Do the right thing depending on what byte it is. */
-                if (*str == '\n' || *str == '\0')
+                /*
+                ** Leave out carriage returns, squeezing any that
+                ** aren't at the end out of the buffered bytes.
+                */
+                count = span;
+                if (count > 0 && src[count - 1] == '\r')
+                        count--;
+                cr = (char *)memchr(src, '\r', count);
+                if (cr != (char *)NULL)
                 {
-                        /* Check for continuation line. */
-                        if (last == '\\' && last2 != '\\')
+                        for (dst = cr; cr < src + count; cr++)
                         {
-                                /* Continuation line. */
-                                last = '\0';
-                                last2 = '\0';
-                                str--;
-                                *str = '\0';
-                        }
-                        else
-                        {
-                                /* This is the end of the line. */
-                                break;
+                                if (*cr != '\r')
+                                        *dst++ = *cr;
                         }
+                        count = (int)(dst - src);
                 }
-                if ((*str != '\r') && (*str != '\n') && (*str != '\0'))
-                {
-                        last2 = last;
-                        last = *str;
-                        str++;
-                        bytes++;
-                }
-                *str = '\0';
 
-                if (bytes >= maxlen)
+                /* Copy the bytes that are kept. */
+                if (bytes + count >= maxlen)
                 {
                         /* Line too long. */
                         errmsg(MSG_ERR_LINETOOLONG, (char *)NULL, NOVAL);
                         return -1;
                 }
+                memcpy(str, src, count);
+                str += count;
+                bytes += count;
+                *str = '\0';
+
+                /* Get more data if the line isn't finished yet. */
+                if (iopos >= iosize)
+                        continue;
+
+                /* Skip the end of line character. */
+                iopos++;
+
+                /* Check for continuation line. */
+                if (str > pline && str[-1] == '\\' &&
+                        (str - 1 == pline || str[-2] != '\\'))
+                {
+                        /* Continuation line. */
+                        str--;
+                        bytes--;
+                        *str = '\0';
+                        pline = str;
+                }
+                else
+                {
+                        /* This is the end of the line. */
+                        break;
+                }
         }
 
         /* Mark end of line with null. */
         *str = '\0';
 
-        /* Check if we should try expanding named macros. */
-        if (has_dollar && (sstart[0] != '#'))
+        return 1;
+}
+
+/*
+** expand_line:
+** Expands the named macros in a logical line, unless the
+** line is a comment.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      str     Line to expand in place.
+**      maxlen  Size of buffer containing line.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      -1      Fatal error occurred.
+*/
+static int
+expand_line(str, maxlen)
+        char    *str;
+        int     maxlen;
+{
+        char    *tmp;           /* Buffer for macro expansion. */
+        int     eresult;        /* Result of last macro expansion. */
+
+        if (str[0] == '#')
+                return 1;
+
+        /* Allocate memory for macro expansion. */
+        tmp = (char *)mem_alloc(maxlen);
+        if (tmp == (char *)NULL)
         {
-                /*
-                ** The line contains at least one '$', so we
-                ** need to try expanding named macros.
-                */
+                /* Not enough memory. */
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return -1;
+        }
+
+        /*
+        ** Perform macro expansions on named macros.  Macros
+        ** within macros are expanded in the same pass.
+        */
+        eresult = expand_named_macros(str, tmp, maxlen);
+        if (eresult < 1)
+        {
+                /* Error expanding macros. */
+                mem_free(tmp);
+                return -1;
+        }
+        if (eresult == 2)
+                strcpy(str, tmp);
+
+        /* Free macro expansion buffer. */
+        mem_free(tmp);
+
+        return 1;
+}
+
+/*
+** load_include:
+** Finds an included file in the list of files that have
+** already been read, or reads its logical lines into the list.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of included file.
+**      str     Buffer to use while reading lines.
+**      maxlen  Size of buffer.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Error occurred.
+**      other   Pointer to included file's descriptor.
+*/
+static INCFILE *
+load_include(fname, str, maxlen)
+        char    *fname;
+        char    *str;
+        int     maxlen;
+{
+        INCFILE *inc;           /* Included file descriptor. */
+        LINE    *tail = (LINE *)NULL; /* Last line read so far. */
+        LINE    *lptr;          /* New line. */
+        char    *sbfr;          /* Makefile's 'iobfr'. */
+        int     ssize;          /* Makefile's 'iosize'. */
+        int     spos;           /* Makefile's 'iopos'. */
+        int     fh;             /* Handle of included file. */
+        int     result;         /* Result of last read. */
+        char    has_dollar;     /* Not used. */
+
+        /* See if the file has been read already. */
+        for (inc = include_list; inc != (INCFILE *)NULL; inc = inc->inext)
+        {
+                if (stricmp(inc->iname, fname) == 0)
+                        return inc;
+        }
+
+        /* Allocate descriptor for the file. */
+        inc = (INCFILE *)mem_alloc(sizeof(INCFILE));
+        if (inc == (INCFILE *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return (INCFILE *)NULL;
+        }
+        inc->iname = (char *)mem_alloc(strlen(fname) + 1);
+        if (inc->iname == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                mem_free(inc);
+                return (INCFILE *)NULL;
+        }
+        strcpy(inc->iname, fname);
+        inc->ilines = (LINE *)NULL;
+        inc->ionce = 0;
+        inc->inext = (INCFILE *)NULL;
+
+        fh = mopen_r(fname);
+        if (fh < 0)
+        {
+                errmsg(MSG_ERR_CANTOPEN, fname, NOVAL);
+                mem_free(inc->iname);
+                mem_free(inc);
+                return (INCFILE *)NULL;
+        }
+
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                /* Tell which file we're reading from. */
+                mputs(MSG_DBG_MAKENAME);
+                mputs(fname);
+                mputs("\n");
+        }
+
+        /* Read the file with its own input buffer. */
+        sbfr = iobfr;
+        ssize = iosize;
+        spos = iopos;
+        iobfr = (char *)mem_alloc(MAXIO);
+        iosize = 0;
+        iopos = 0;
+        result = -1;
+        if (iobfr == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+        }
+        else
+        {
+                while ((result = read_physical_lines(fh, str, maxlen,
+                        &has_dollar)) == 1)
+                {
+                        /* Comments are never used, so leave them out. */
+                        if (str[0] == '#')
+                                continue;
+
+                        lptr = create_line(str);
+                        if (lptr == (LINE *)NULL)
+                        {
+                                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL,
+                                        NOVAL);
+                                result = -1;
+                                break;
+                        }
+                        if (tail == (LINE *)NULL)
+                                inc->ilines = lptr;
+                        else
+                                tail->lnext = lptr;
+                        tail = lptr;
+                }
+                mem_free(iobfr);
+        }
+        iobfr = sbfr;
+        iosize = ssize;
+        iopos = spos;
+        mclose(fh);
+
+        if (result == -1)
+        {
+                free_lines(inc->ilines);
+                mem_free(inc->iname);
+                mem_free(inc);
+                return (INCFILE *)NULL;
+        }
+
+        /* Add the file to the list. */
+        if (include_list == (INCFILE *)NULL)
+                include_list = inc;
+        else
+                include_tail->inext = inc;
+        include_tail = inc;
+
+        return inc;
+}
+
+/*
+** do_include:
+** Handles the "!INCLUDE" directive, by starting to replay the
+** lines of the included file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    Name of file to include, as given after the
+**              directive.
+**      str     Buffer to use while reading lines.
+**      maxlen  Size of buffer.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+do_include(line, str, maxlen)
+        char    *line;
+        char    *str;
+        int     maxlen;
+{
+        char    fname[MAXPATH]; /* Name of included file. */
+        char    *cp;            /* Directory from INCLUDE variable. */
+        int     search = 0;     /* Flag, set if name was in <>. */
+        int     len;
+        INCFILE *inc;
+
+        /* Take off any quotes or angle brackets. */
+        while (*line == ' ' || *line == '\t')
+                line++;
+        len = strlen(line);
+        while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t'))
+                len--;
+        if (len >= 2 && ((line[0] == '"' && line[len - 1] == '"') ||
+                (line[0] == '<' && line[len - 1] == '>')))
+        {
+                search = line[0] == '<';
+                line++;
+                len -= 2;
+        }
+        if (len <= 0 || len >= MAXPATH)
+        {
+                errmsg(MSG_ERR_BADINCLUDE, line, NOVAL);
+                return 0;
+        }
+        strncpy(fname, line, len);
+        fname[len] = '\0';
+        cvt_slash(fname);
+
+        /*
+        ** Look for a name in angle brackets in the directories
+        ** listed in the INCLUDE environment variable.
+        */
+        if (search && access(fname, 0) != 0)
+        {
+                enumpath(0, "INCLUDE");
+                while ((cp = enumpath(1, "INCLUDE")) != (char *)NULL)
+                {
+                        if (strlen(cp) + len + 2 > MAXPATH)
+                                continue;
+                        strcpy(str, cp);
+                        if (str[0] != '\0' && str[strlen(str) - 1] != '\\')
+                                strcat(str, "\\");
+                        strcat(str, fname);
+                        if (access(str, 0) == 0)
+                        {
+                                strcpy(fname, str);
+                                break;
+                        }
+                }
+        }
+
+        if (inclevel >= MAXINCS - 1)
+        {
+                /* Nesting too deep in includes. */
+                errmsg(MSG_ERR_TOOMANYINCS, fname, NOVAL);
+                return 0;
+        }
+
+        inc = load_include(fname, str, maxlen);
+        if (inc == (INCFILE *)NULL)
+                return 0;
+
+        /* A file marked with !ONCE is only replayed the first time. */
+        if (inc->ionce)
+                return 1;
+
+        inclevel++;
+        incfile[inclevel] = inc;
+        incnext[inclevel] = inc->ilines;
+        incif[inclevel] = iflevel;
+
+        return 1;
+}
+
+/*
+** local_read_logical_line:
+** Reads a logical line of text from the makefile, or from the
+** included file being replayed.  A logical line is one line of
+** text which is a combination of the next physical line from
+** the makefile plus any physical continuation lines indicated
+** by a trailing backslash on the previous line.
+** Called by read_logical_line().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      handle  Open file handle to read from.
+**      str     Buffer to read into.
+**      maxlen  Maximum number of bytes to read.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       If successful.
+**      0       If end-of-file or I/O error occurs.
+**      -1      If line exceeds maximum length or fatal error
+**              occurs.
+*/
+static int
+local_read_logical_line(handle, str, maxlen)
+        int     handle;
+        char    *str;
+        int     maxlen;
+{
+        LINE    *lptr;          /* Line being replayed. */
+        int     result;         /* Result of reading line. */
+        char    has_dollar = 0; /* Flag, nonzero if line contains a '$'. */
 
-                /* Allocate memory for macro expansion. */
-                tmp = (char *)mem_alloc(maxlen);
-                if (tmp == (char *)NULL)
+        /* Check if the unread buffer has something in it. */
+        if (unread_lbfr != (char *)NULL)
+        {
+                if (strlen(unread_lbfr) > (unsigned)maxlen)
                 {
-                        /* Not enough memory. */
-                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        /* Unread buffer is too long for caller's buffer. */
+                        errmsg(MSG_ERR_UNREADLEN, (char *)NULL, NOVAL);
                         return -1;
                 }
+                strcpy(str, unread_lbfr);
+                mem_free(unread_lbfr);
+                unread_lbfr = (char *)NULL;
+                return 1;
+        }
 
-                /*
-                ** Perform macro expansions on named macros.
-                */
-                do
+        /* Replay the next line from an included file, if any. */
+        while (inclevel > -1)
+        {
+                lptr = incnext[inclevel];
+                if (lptr == (LINE *)NULL)
                 {
-                        eresult = expand_named_macros(sstart, tmp, maxlen);
-                        if (eresult > 0)
-                                strcpy(sstart, tmp);
+                        /* End of included file. */
+                        if (iflevel != incif[inclevel])
+                        {
+                                errmsg(MSG_ERR_EOF, incfile[inclevel]->iname,
+                                        NOVAL);
+                                return -1;
+                        }
+                        inclevel--;
+                        continue;
                 }
-                while (eresult == 2);
-                if (eresult < 1)
+                incnext[inclevel] = lptr->lnext;
+
+                if (strlen(lptr->ldata) >= (unsigned)maxlen)
                 {
-                        /* Error expanding macros. */
-                        mem_free(tmp);
+                        /* Line too long. */
+                        errmsg(MSG_ERR_LINETOOLONG, (char *)NULL, NOVAL);
                         return -1;
                 }
-
-                /* Free macro expansion buffer. */
-                mem_free(tmp);
+                strcpy(str, lptr->ldata);
+                if (strchr(str, '$') != (char *)NULL)
+                        return expand_line(str, maxlen);
+                return 1;
         }
 
+        /* Read the next line from the makefile. */
+        result = read_physical_lines(handle, str, maxlen, &has_dollar);
+        if (result != 1)
+                return result;
+
+        /* Check if we should try expanding named macros. */
+        if (has_dollar)
+                return expand_line(str, maxlen);
+
         return 1;
 }
 
@@ -863,7 +1328,41 @@ read_logical_line(handle, str, maxlen)
                         }
                         else if (strcmp(token, "INCLUDE") == 0)
                         {
-                                /* NOT IMPLEMENTED YET. */
+                                /* See if we're skipping right now. */
+                                k = 0;
+                                j = iflevel;
+                                while (j >= 0)
+                                {
+                                        /* Is this level in skip mode? */
+                                        if (ifmode[j] == 2)
+                                                k = 1;
+                                        j--;
+                                }
+
+                                /* Start reading the included file. */
+                                if (k == 0 &&
+                                        !do_include(&str[i], str, maxlen))
+                                {
+                                        return -1;
+                                }
+                                haveline = 0;
+                        }
+                        else if (strcmp(token, "ONCE") == 0)
+                        {
+                                /* See if we're skipping right now. */
+                                k = 0;
+                                j = iflevel;
+                                while (j >= 0)
+                                {
+                                        /* Is this level in skip mode? */
+                                        if (ifmode[j] == 2)
+                                                k = 1;
+                                        j--;
+                                }
+
+                                /* Don't replay this included file again. */
+                                if (k == 0 && inclevel > -1)
+                                        incfile[inclevel]->ionce = 1;
                                 haveline = 0;
                         }
                         else if (strcmp(token, "UNDEF") == 0)
@@ -995,6 +1494,15 @@ process_makefile(mf)
                                 }
                                 break;
 
+                        case 6: /* Pattern rule. */
+                                if (!define_pattern(inpline, mh))
+                                {
+                                        /* Error defining pattern rule. */
+                                        deinit_input_buffers();
+                                        return 0;
+                                }
+                                break;
+
                         case 0:
                         default:
                                 /* Syntax error in makefile. */
@@ -1019,3 +1527,58 @@ process_makefile(mf)
         return 1;
 }
 
+/*
+** flush_includes:
+** Frees the lines of the files that have been read by
+** "!INCLUDE".  This function gets called before the program
+** terminates.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_includes(void)
+{
+        INCFILE *inc;
+
+        while (include_list != (INCFILE *)NULL)
+        {
+                inc = include_list;
+                include_list = inc->inext;
+                free_lines(inc->ilines);
+                mem_free(inc->iname);
+                mem_free(inc);
+        }
+        include_tail = (INCFILE *)NULL;
+}
+
+/*
+** enum_include:
+** Enumerates the name of a file that has been read by
+** "!INCLUDE".
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      index   Index in list of file to enumerate.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Specified index is out of range.
+**      other   Pointer to name of included file.
+*/
+char *
+enum_include(index)
+        int     index;
+{
+        INCFILE *inc = include_list;
+
+        while (inc != (INCFILE *)NULL && index-- > 0)
+                inc = inc->inext;
+
+        return inc == (INCFILE *)NULL ? (char *)NULL : inc->iname;
+}
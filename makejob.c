@@ -0,0 +1,743 @@
+/*
+======================================================================
+makejob.c
+Job queue routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+When more than one job is requested with the '-j' option, the
+make_target() function doesn't run the commands for out-of-date
+targets itself.  Instead, each target that needs to be built is
+placed in the job queue by queue_job(), along with the names of
+the dependent files it must wait for.  Since make_target() works
+its way down the dependency graph before queueing a target, a
+target's dependents are always queued ahead of the target.
+
+Once all of the requested targets have been examined, run_jobs()
+starts the commands for every queued target whose dependents are
+finished, keeping up to 'maxjobs' commands running at once.  The
+commands for any single target are still run one at a time, in
+the order they appear in the makefile.
+
+So that builds with thousands of targets don't search the queue
+for every dependent of every job, each job counts the unfinished
+jobs it is waiting for, and keeps a list of the jobs waiting for
+it.  When a job finishes, the counts of the jobs waiting for it
+go down, and a job whose count reaches zero is added to the end
+of the ready list, which run_jobs() starts jobs from.  Jobs are
+found by name through a hash table.
+
+Commands can only be run without waiting for them under OS/2.
+Under MS-DOS and Windows, run_command() runs each command to
+completion, so the job queue simply builds the targets in
+dependency order.
+
+The job queue is implemented as a linked list of job descriptors,
+of the data type JOB, which is defined in the "make.h" file.  The
+lists of waiting jobs are kept in an arena of their own.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+#include <process.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static unsigned int job_hash(char *tname);
+static void     free_job(JOB *job);
+static int      wait_for_job(JOB *job, char *dname);
+static void     ready_job(JOB *job);
+static void     finish_job(JOB *job);
+static int      start_job(JOB *job);
+static void     fail_job(JOB *job);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the job table. */
+#define JOB_HASH_SIZE   64
+
+/****************************** VARIABLES ***************************/
+
+/* job_list:  Linked list of queued jobs. */
+static JOB *job_list;
+
+/* job_tail:  Last job in the job list. */
+static JOB *job_tail;
+
+/* job_table:  Hash table of queued jobs, by target name. */
+static JOB *job_table[JOB_HASH_SIZE];
+
+/* ready_list, ready_tail:  Jobs whose dependents are finished. */
+static JOB *ready_list;
+static JOB *ready_tail;
+
+/* run_list:  Jobs with a command running without waiting for it. */
+static JOB *run_list;
+
+/* job_running:  Number of jobs with commands running. */
+static int job_running;
+
+/* job_waiting:  Number of jobs waiting for other jobs. */
+static int job_waiting;
+
+/* Memory for the lists of jobs waiting for other jobs. */
+static ARENA job_arena;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** job_hash:
+** Computes the hash value of a target name for the job table.
+** Target names are compared without regard to case, so the
+** value is that of the lowercase name.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**
+** Returns:
+**      Hash value for the name.
+*/
+static unsigned int
+job_hash(tname)
+        char    *tname;
+{
+        char    lname[MAXPATH];
+
+        strncpy(lname, tname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+
+        return hash_name(lname);
+}
+
+/*
+** free_job:
+** Frees a job descriptor and the memory associated with it.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor to be freed.
+**
+** Returns:
+**      NONE
+*/
+static void
+free_job(job)
+        JOB     *job;
+{
+        if (job->jname != (char *)NULL)
+                mem_free(job->jname);
+        if (job->jsrc != (char *)NULL)
+                mem_free(job->jsrc);
+        if (job->jline != (char *)NULL)
+                mem_free(job->jline);
+        mem_free(job);
+}
+
+/*
+** wait_for_job:
+** Makes a job wait for the job that builds one of its dependents,
+** if that job is in the queue and hasn't finished yet.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor of waiting job.
+**      dname   Name of dependent.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+wait_for_job(job, dname)
+        JOB     *job;
+        char    *dname;
+{
+        JOB     *jptr;
+        JOBLINK *lptr;
+
+        jptr = find_job(dname);
+        if (jptr == (JOB *)NULL || jptr->jstate == JOB_DONE)
+                return 1;
+
+        lptr = (JOBLINK *)arena_alloc(&job_arena, sizeof(JOBLINK));
+        if (lptr == (JOBLINK *)NULL)
+                return 0;
+        lptr->ljob = job;
+        lptr->lnext = jptr->jwaiters;
+        jptr->jwaiters = lptr;
+        job->jcount++;
+
+        return 1;
+}
+
+/*
+** ready_job:
+** Adds a job to the end of the ready list.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor.
+**
+** Returns:
+**      NONE
+*/
+static void
+ready_job(job)
+        JOB     *job;
+{
+        job->jrnext = (JOB *)NULL;
+        if (ready_tail == (JOB *)NULL)
+                ready_list = job;
+        else
+                ready_tail->jrnext = job;
+        ready_tail = job;
+}
+
+/*
+** finish_job:
+** Marks a job as done, and moves the jobs that were waiting
+** only for it to the ready list.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor.
+**
+** Returns:
+**      NONE
+*/
+static void
+finish_job(job)
+        JOB     *job;
+{
+        JOBLINK *lptr;
+
+        job->jstate = JOB_DONE;
+        job_running--;
+
+        for (lptr = job->jwaiters; lptr != (JOBLINK *)NULL;
+                lptr = lptr->lnext)
+        {
+                if (--lptr->ljob->jcount == 0)
+                {
+                        job_waiting--;
+                        ready_job(lptr->ljob);
+                }
+        }
+        job->jwaiters = (JOBLINK *)NULL;
+}
+
+/*
+** start_job:
+** Runs a job's remaining commands until one of them is started
+** without waiting for it, or until there are no more commands.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+start_job(job)
+        JOB     *job;
+{
+        char    cmd[MAXPATH];
+
+        while (job->jcmd != (LINE *)NULL)
+        {
+#ifdef WIN
+                /* Check if user aborted. */
+                if (check_abort())
+                        return 0;
+#endif /* WIN */
+
+                /* Expand the command line. */
+                if (!expand_command(job->jname, job->jtar, job->jsrc,
+                        job->jcmd, cmd, 0))
+                {
+                        /* Macro expansion error. */
+                        return 0;
+                }
+                job->jcmd = job->jcmd->lnext;
+
+                /* Save command so its return code can be checked. */
+                strcpy(job->jline, cmd);
+
+                /* The command may change the target file. */
+                forget_mstat(job->jname);
+
+                /* Run the command. */
+                if (!run_command(cmd, &job->jpid))
+                {
+                        /* Couldn't run the command. */
+                        return 0;
+                }
+
+                /* If the command is still running, come back later. */
+                if (job->jpid != 0)
+                        return 1;
+        }
+
+        /* All commands for the job are done. */
+        finish_job(job);
+        if (job->jrestat)
+                end_restat(job->jname, job->jotime, job->jocrc);
+        if (CHKFLAG(FLAG_DIGEST | FLAG_CMDSIG | FLAG_CACHE) &&
+                !CHKFLAG(FLAG_NOSPAWN))
+        {
+                commit_digest(job->jname);
+        }
+        if (CHKFLAG(FLAG_CACHE))
+                store_cache(job->jname);
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                mputs(MSG_DBG_JOBDONE);
+                mputs(job->jname);
+                mputs("\n");
+        }
+
+        return 1;
+}
+
+/*
+** fail_job:
+** Cleans up after a job whose command failed.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      job     Pointer to job descriptor.
+**
+** Returns:
+**      NONE
+*/
+static void
+fail_job(job)
+        JOB     *job;
+{
+        job->jpid = 0;
+        finish_job(job);
+
+        if (!is_precious(job->jname) && !is_phony(job->jname))
+        {
+                /* Remove the potentially incorrect target file. */
+                unlink(job->jname);
+        }
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_jobs:
+** Initializes the job queue.  This function gets called before
+** any other actions are performed on the job queue.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_jobs(void)
+{
+        int     i;
+
+        job_list = (JOB *)NULL;
+        job_tail = (JOB *)NULL;
+        for (i = 0; i < JOB_HASH_SIZE; i++)
+                job_table[i] = (JOB *)NULL;
+        ready_list = (JOB *)NULL;
+        ready_tail = (JOB *)NULL;
+        run_list = (JOB *)NULL;
+        job_running = 0;
+        job_waiting = 0;
+        arena_init(&job_arena, "job queue");
+}
+
+/*
+** flush_jobs:
+** Empties and frees the job queue.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_jobs(void)
+{
+        JOB     *job;
+        JOB     *job2;
+
+        job = job_list;
+        while (job != (JOB *)NULL)
+        {
+                job2 = job->jnext;
+                free_job(job);
+                job = job2;
+        }
+
+        arena_release(&job_arena);
+        init_jobs();
+}
+
+/*
+** queue_job:
+** Adds a target to the end of the job queue, so that its commands
+** will be run by run_jobs() once its dependents have been built.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to be built.
+**      tar     Target descriptor for target (if any).
+**      rul     Rule descriptor for rule being used (if any).
+**      srcname Name of rule's source file (NULL if no rule).
+**
+** Either tar or rul may be NULL, but not both.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+queue_job(tname, tar, rul, srcname)
+        char    *tname;
+        TARGET  *tar;
+        RULE    *rul;
+        char    *srcname;
+{
+        JOB     *job;
+        DEPEND  *dptr;
+
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                mputs(MSG_DBG_JOBQUEUED);
+                mputs(tname);
+                mputs("\n");
+        }
+
+        /* Allocate memory for job descriptor. */
+        job = (JOB *)mem_alloc(sizeof(JOB));
+        if (job == (JOB *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+        job->jname = (char *)NULL;
+        job->jtar = tar;
+        job->jsrc = (char *)NULL;
+        job->jwait = (DEPEND *)NULL;
+        job->jcmd = (rul != (RULE *)NULL) ? rul->rcommands : tar->tcommands;
+        job->jline = (char *)NULL;
+        job->jpid = 0;
+        job->jstate = JOB_WAITING;
+        job->jrestat = 0;
+        job->jhash = job_hash(tname);
+        job->jcount = 0;
+        job->jwaiters = (JOBLINK *)NULL;
+        job->jhnext = (JOB *)NULL;
+        job->jrnext = (JOB *)NULL;
+        job->jnext = (JOB *)NULL;
+
+        /* Save the target name and a buffer for its commands. */
+        job->jname = (char *)mem_alloc(strlen(tname) + 1);
+        job->jline = (char *)mem_alloc(MAXPATH);
+        if (job->jname == (char *)NULL || job->jline == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                free_job(job);
+                return 0;
+        }
+        strcpy(job->jname, tname);
+
+        /*
+        ** The job must wait for the target's dependents, which are
+        ** kept with the target, and for the rule's source file.
+        */
+        if (tar != (TARGET *)NULL && tar->tdependents != (char *)NULL)
+        {
+                if (!expand_dependents(tar))
+                {
+                        /* Error expanding dependent list. */
+                        free_job(job);
+                        return 0;
+                }
+                job->jwait = tar->tdeps;
+        }
+        if (srcname != (char *)NULL)
+        {
+                job->jsrc = (char *)mem_alloc(strlen(srcname) + 1);
+                if (job->jsrc == (char *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        free_job(job);
+                        return 0;
+                }
+                strcpy(job->jsrc, srcname);
+        }
+
+        /* Add the job to the end of the queue. */
+        if (job_tail == (JOB *)NULL)
+                job_list = job;
+        else
+                job_tail->jnext = job;
+        job_tail = job;
+
+        /*
+        ** The dependents' jobs are always queued ahead of this
+        ** one, so see which of them it has to wait for.  If we
+        ** run out of memory, the job is freed with the rest of
+        ** the queue.
+        */
+        if (job->jwait != (DEPEND *)NULL)
+        {
+                for (dptr = job->jwait; dptr->dname != (char *)NULL; dptr++)
+                {
+                        if (!wait_for_job(job, dptr->dname))
+                        {
+                                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL,
+                                        NOVAL);
+                                return 0;
+                        }
+                }
+        }
+        if (job->jsrc != (char *)NULL && !wait_for_job(job, job->jsrc))
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+        if (job->jcount == 0)
+                ready_job(job);
+        else
+                job_waiting++;
+
+        /* Add the job to the job table. */
+        job->jhnext = job_table[job->jhash % JOB_HASH_SIZE];
+        job_table[job->jhash % JOB_HASH_SIZE] = job;
+
+        return 1;
+}
+
+/*
+** find_job:
+** Searches the job queue for a particular target.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to search for.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Target is not in the job queue.
+**      other   Pointer to target's job descriptor.
+*/
+JOB *
+find_job(tname)
+        char    *tname;
+{
+        JOB             *job;
+        unsigned int    hash;
+
+        if (job_list == (JOB *)NULL)
+                return (JOB *)NULL;
+
+        hash = job_hash(tname);
+        job = job_table[hash % JOB_HASH_SIZE];
+        while (job != (JOB *)NULL)
+        {
+                if (job->jhash == hash && stricmp(job->jname, tname) == 0)
+                        return job;
+                job = job->jhnext;
+        }
+
+        return (JOB *)NULL;
+}
+
+/*
+** run_jobs:
+** Runs the commands for all of the targets in the job queue,
+** keeping up to 'maxjobs' commands running at the same time.
+** If a command fails, no more jobs are started, but commands
+** that are already running are allowed to finish.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+run_jobs(void)
+{
+        JOB     *job;
+        JOB     **jpp;
+        int     ok = 1;         /* Flag, zero once an error occurred. */
+        int     pid;
+        int     status;
+        int     result;
+
+        for (;;)
+        {
+                /* Start as many ready jobs as we are allowed. */
+                while (ok && ready_list != (JOB *)NULL &&
+                        job_running < maxjobs)
+                {
+                        job = ready_list;
+                        ready_list = job->jrnext;
+                        if (ready_list == (JOB *)NULL)
+                                ready_tail = (JOB *)NULL;
+
+                        if (CHKFLAG(FLAG_DEBUG))
+                        {
+                                mputs(MSG_DBG_JOBSTART);
+                                mputs(job->jname);
+                                mputs("\n");
+                        }
+                        job->jstate = JOB_RUNNING;
+                        job_running++;
+                        if (CHKFLAG(FLAG_CACHE) && fetch_cache(job->jname))
+                        {
+                                /* No commands to run. */
+                                job->jcmd = (LINE *)NULL;
+                        }
+                        else
+                        {
+                                job->jrestat = begin_restat(job->jname,
+                                        &job->jotime, &job->jocrc);
+                        }
+                        if (!start_job(job))
+                        {
+                                fail_job(job);
+                                ok = 0;
+                        }
+                        else if (job->jstate == JOB_RUNNING)
+                        {
+                                /* Command is running; wait for it. */
+                                job->jrnext = run_list;
+                                run_list = job;
+                        }
+                }
+
+                /* Done if nothing is left running. */
+                if (job_running == 0)
+                {
+                        if (job_waiting > 0 && ok)
+                        {
+                                /*
+                                ** Jobs are waiting on dependents
+                                ** that will never be built.
+                                */
+                                errmsg(MSG_ERR_JOBSTUCK, (char *)NULL, NOVAL);
+                                ok = 0;
+                        }
+                        break;
+                }
+
+#ifndef WIN
+                /* Wait for any running command to finish. */
+                pid = wait(&status);
+                if (pid == -1)
+                {
+                        errmsg(MSG_ERR_JOBWAIT, (char *)NULL, (int)errno);
+                        ok = 0;
+                        break;
+                }
+
+                /*
+                ** Find the job that the command belongs to, and
+                ** take it off the list of running jobs.
+                */
+                jpp = &run_list;
+                while (*jpp != (JOB *)NULL && (*jpp)->jpid != pid)
+                        jpp = &(*jpp)->jrnext;
+                job = *jpp;
+                if (job == (JOB *)NULL)
+                        continue;
+                *jpp = job->jrnext;
+                job->jpid = 0;
+
+                /*
+                ** The low byte of the status is the termination
+                ** code, which is nonzero if the process ended
+                ** abnormally; the high byte is the return code.
+                */
+                if ((status & 0xFF) != 0)
+                        result = status & 0xFF;
+                else
+                        result = (status >> 8) & 0xFF;
+
+                /* Check the command, then go on to the next one. */
+                if (!check_command(job->jline, result) ||
+                        (ok && !start_job(job)))
+                {
+                        fail_job(job);
+                        ok = 0;
+                }
+                else if (!ok && job->jstate == JOB_RUNNING)
+                {
+                        /* Don't run any more commands after an error. */
+                        finish_job(job);
+                }
+                else if (job->jstate == JOB_RUNNING)
+                {
+                        /* Next command is running; wait for it. */
+                        job->jrnext = run_list;
+                        run_list = job;
+                }
+#else /* WIN */
+                /* Commands always run to completion under Windows. */
+                break;
+#endif /* WIN */
+        }
+
+        flush_jobs();
+        return ok;
+}
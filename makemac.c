@@ -18,6 +18,22 @@ from the makefile into the macro list used internally by the make
 utility.  Only the parsing and list management is done here; the
 invocation (expansion) of macros is handled elsewhere.
 
+The macros are kept in a linked list in the order they were first
+defined, so that the macro list can be displayed in a consistent
+order.  Each macro is also placed in a hash table, which is used by
+find_macro() and by add_macro() to find an existing definition.  When
+a macro is defined again, its expansion text is replaced in place.
+
+The expansion text of a macro may itself refer to other macros.
+expand_macro() expands such text once, and keeps the result with
+the macro, so that a chain of macros that refer to each other isn't
+expanded again every time it is used.  Since the result depends on
+every macro in the chain, all of the kept results are thrown away
+whenever any macro is defined, by advancing 'macro_gen'.  A macro
+that is being expanded is marked busy, so that a macro that refers
+to itself, directly or through other macros, is reported as an
+error instead of recursing forever.
+
 ======================================================================
 */
 
@@ -41,19 +57,107 @@ invocation (expansion) of macros is handled elsewhere.
 /****************************** HEADERS *****************************/
 
 /* Prototypes for functions local to this module: */
+static MACRO    *lookup_macro(char *name, unsigned int hash);
 static int      add_macro(char *name, char *data);
+static void     forget_expansion(MACRO *mac);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the macro table. */
+#define MACRO_HASH_SIZE 64
+
+/* Deepest chain of macros that expand_macro() will follow. */
+#define MAXMACRODEPTH   32
 
 /****************************** VARIABLES ***************************/
 
 /* macro_list:  Linked list of defined macros. */
 static MACRO *macro_list;
 
+/* macro_tail:  Last macro in the macro list. */
+static MACRO *macro_tail;
+
+/* macro_table:  Hash table of defined macros. */
+static MACRO *macro_table[MACRO_HASH_SIZE];
+
+/*
+** macro_gen:  Changed whenever a macro is defined; expansions made
+** by expand_macro() are only good while it has the same value.
+*/
+static unsigned int macro_gen;
+
+/* macro_depth:  Number of nested expand_macro() calls. */
+static int macro_depth;
+
+/*
+** macro_arena:  Memory for macro descriptors and names, which are
+** kept until flush_macros().  A macro's expansion text is changed
+** when the macro is defined again, so it comes from the heap.
+*/
+static ARENA macro_arena;
+
 /*************************** LOCAL FUNCTIONS ************************/
 
+/*
+** lookup_macro:
+** Searches the macro hash table for a particular macro.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      name    Name of macro to search for.
+**      hash    hash_name() value of the macro name.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Specified macro not found.
+**      other   Pointer to macro descriptor.
+*/
+static MACRO *
+lookup_macro(name, hash)
+        char            *name;
+        unsigned int    hash;
+{
+        MACRO   *mptr;
+
+        mptr = macro_table[hash % MACRO_HASH_SIZE];
+        while (mptr != (MACRO *)NULL)
+        {
+                if (mptr->mhash == hash && strcmp(name, mptr->mname) == 0)
+                        return mptr;
+                mptr = mptr->mhnext;
+        }
+
+        return (MACRO *)NULL;
+}
+
+/*
+** forget_expansion:
+** Frees the expansion kept for a macro by expand_macro().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      mac     Macro descriptor.
+**
+** Returns:
+**      NONE
+*/
+static void
+forget_expansion(mac)
+        MACRO   *mac;
+{
+        if (mac->mfull != (char *)NULL && mac->mfull != mac->mexp)
+                mem_free(mac->mfull);
+        mac->mfull = (char *)NULL;
+}
+
 /*
 ** add_macro:
 ** Adds a new macro description to the macro list.  If a macro
-** already exists with the same name, it is overridden.
+** already exists with the same name, its expansion text is
+** replaced.
 **
 ** Parameters:
 **      Name    Description
@@ -73,10 +177,45 @@ add_macro(name, data)
         char    *data;
 {
         MACRO   *mac;
-        MACRO   *mptr;
+        char    *exp;
+        unsigned int hash;
+        int     bucket;
+
+        /*
+        ** Make the expansions kept by expand_macro() stale.  If
+        ** the counter wraps around, throw them all away, so an
+        ** old one can't look current.
+        */
+        if (++macro_gen == 0)
+        {
+                for (mac = macro_list; mac != (MACRO *)NULL;
+                        mac = mac->mnext)
+                {
+                        forget_expansion(mac);
+                }
+        }
+
+        /* If the macro is already defined, just replace its data. */
+        hash = hash_name(name);
+        mac = lookup_macro(name, hash);
+        if (mac != (MACRO *)NULL)
+        {
+                exp = (char *)mem_alloc(strlen(data) + 1);
+                if (exp == (char *)NULL)
+                {
+                        /* Out of memory for macro data. */
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                strcpy(exp, data);
+                forget_expansion(mac);
+                mem_free(mac->mexp);
+                mac->mexp = exp;
+                return 1;
+        }
 
         /* Allocate memory for macro descriptor. */
-        mac = (MACRO *)mem_alloc(sizeof(MACRO));
+        mac = (MACRO *)arena_alloc(&macro_arena, sizeof(MACRO));
         if (mac == (MACRO *)NULL)
         {
                 /* Out of memory for macro definition. */
@@ -84,19 +223,19 @@ add_macro(name, data)
                 return 0;
         }
         mac->mnext = (MACRO *)NULL;
+        mac->mfull = (char *)NULL;
+        mac->mgen = 0;
+        mac->mbusy = 0;
 
-        /* Allocate memory for macro name. */
-        mac->mname = (char *)mem_alloc(strlen(name) + 1);
+        /* Save macro name in dscriptor. */
+        mac->mname = arena_strdup(&macro_arena, name);
         if (mac->mname == (char *)NULL)
         {
                 /* Out of memory for macro name. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(mac);
                 return 0;
         }
-
-        /* Save macro name in dscriptor. */
-        strcpy(mac->mname, name);
+        mac->mhash = hash;
 
         /* Allocate memory for macro data. */
         mac->mexp = (char *)mem_alloc(strlen(data) + 1);
@@ -104,8 +243,6 @@ add_macro(name, data)
         {
                 /* Out of memory for macro data. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(mac->mname);
-                mem_free(mac);
                 return 0;
         }
 
@@ -121,11 +258,14 @@ add_macro(name, data)
         else
         {
                 /* Place macro at end of list. */
-                mptr = macro_list;
-                while (mptr->mnext != (MACRO *)NULL)
-                        mptr = mptr->mnext;
-                mptr->mnext = mac;
+                macro_tail->mnext = mac;
         }
+        macro_tail = mac;
+
+        /* Add new macro descriptor to its hash bucket. */
+        bucket = hash % MACRO_HASH_SIZE;
+        mac->mhnext = macro_table[bucket];
+        macro_table[bucket] = mac;
 
         return 1;
 }
@@ -147,7 +287,13 @@ add_macro(name, data)
 void
 init_macros(void)
 {
+        int     i;
+
+        arena_init(&macro_arena, "macros");
         macro_list = (MACRO *)NULL;
+        macro_tail = (MACRO *)NULL;
+        for (i = 0; i < MACRO_HASH_SIZE; i++)
+                macro_table[i] = (MACRO *)NULL;
 }
 
 /*
@@ -205,8 +351,14 @@ predefine_macros(void)
                 tmp[i++] = OPT_DEBUG;
         if (cmdflags & FLAG_ENV_OVERRIDE)
                 tmp[i++] = OPT_ENV_OVERRIDE;
+        if (cmdflags & FLAG_CMDSIG)
+                tmp[i++] = OPT_CMDSIG;
+        if (cmdflags & FLAG_DIGEST)
+                tmp[i++] = OPT_DIGEST;
         if (cmdflags & FLAG_IGNORE)
                 tmp[i++] = OPT_IGNORE;
+        if (cmdflags & FLAG_SNAPSHOT)
+                tmp[i++] = OPT_SNAPSHOT;
         if (cmdflags & FLAG_NOSPAWN)
                 tmp[i++] = OPT_NOSPAWN;
         if (cmdflags & FLAG_SHOW_INFO)
@@ -244,26 +396,19 @@ predefine_macros(void)
 void
 flush_macros(void)
 {
-        MACRO   *m;     /* Temporary macro descriptor pointers. */
-        MACRO   *m2;
+        MACRO   *m;     /* Temporary macro descriptor pointer. */
 
-        /* Free each entry in the macro list. */
-        m = macro_list;
-        while (m != (MACRO *)NULL)
+        /* Free each macro's expansion text. */
+        for (m = macro_list; m != (MACRO *)NULL; m = m->mnext)
         {
-                /* Free macro name. */
-                mem_free(m->mname);
-
-                /* Free macro expansion text. */
+                forget_expansion(m);
                 mem_free(m->mexp);
-
-                /* Free macro descriptor. */
-                m2 = m->mnext;
-                mem_free(m);
-                m = m2;
         }
 
-        macro_list = (MACRO *)NULL;
+        /* Free the descriptors and names all at once. */
+        arena_release(&macro_arena);
+
+        init_macros();
 }
 
 /*
@@ -287,18 +432,108 @@ find_macro(mname)
         char    *mname;
 {
         MACRO   *mptr;
-        char    *mfound;
 
-        mfound = (char *)NULL;
-        mptr = macro_list;
-        while (mptr != (MACRO *)NULL)
+        mptr = lookup_macro(mname, hash_name(mname));
+        if (mptr == (MACRO *)NULL)
+                return (char *)NULL;
+
+        return mptr->mexp;
+}
+
+/*
+** expand_macro:
+** Gets the expansion of a macro, with any macros that its
+** expansion text refers to expanded as well.  The result is
+** kept with the macro until any macro is defined again.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      mname   Name of macro.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Error occurred (macro not defined, macro refers
+**              to itself, expansion too long, out of memory).
+**      other   Pointer to expansion, which is only good until
+**              the next macro is defined.
+*/
+char *
+expand_macro(mname)
+        char    *mname;
+{
+        MACRO   *mac;
+        char    *tmp;
+        char    *full;
+        int     result;
+
+        mac = lookup_macro(mname, hash_name(mname));
+        if (mac == (MACRO *)NULL)
         {
-                if (strcmp(mname, mptr->mname) == 0)
-                        mfound = mptr->mexp;
-                mptr = mptr->mnext;
+                /* Macro not defined. */
+                errmsg(MSG_ERR_NOMACRO, mname, NOVAL);
+                return (char *)NULL;
+        }
+
+        /* Use the expansion from last time if it's still good. */
+        if (mac->mfull != (char *)NULL && mac->mgen == macro_gen)
+                return mac->mfull;
+        if (mac->mbusy)
+        {
+                /* Macro's expansion text leads back to itself. */
+                errmsg(MSG_ERR_MACROLOOP, mac->mname, NOVAL);
+                return (char *)NULL;
         }
+        forget_expansion(mac);
 
-        return mfound;
+        /* Text without any '$' expands to itself. */
+        if (strchr(mac->mexp, '$') == (char *)NULL)
+        {
+                mac->mfull = mac->mexp;
+                mac->mgen = macro_gen;
+                return mac->mfull;
+        }
+
+        if (macro_depth >= MAXMACRODEPTH)
+        {
+                /* Chain of macros is too long for the stack. */
+                errmsg(MSG_ERR_MACRODEPTH, mac->mname, NOVAL);
+                return (char *)NULL;
+        }
+        tmp = (char *)mem_alloc(MAXLLINE);
+        if (tmp == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return (char *)NULL;
+        }
+
+        /* Expand the text, which may call here again. */
+        mac->mbusy = 1;
+        macro_depth++;
+        result = expand_named_macros(mac->mexp, tmp, MAXLLINE);
+        macro_depth--;
+        mac->mbusy = 0;
+        if (!result)
+        {
+                mem_free(tmp);
+                return (char *)NULL;
+        }
+
+        /* Keep the expansion. */
+        full = (char *)mem_alloc(strlen(tmp) + 1);
+        if (full == (char *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                mem_free(tmp);
+                return (char *)NULL;
+        }
+        strcpy(full, tmp);
+        mem_free(tmp);
+        mac->mfull = full;
+        mac->mgen = macro_gen;
+
+        return full;
 }
 
 /*
@@ -410,3 +645,68 @@ dump_macros(void)
         }
 }
 
+/*
+** save_macros:
+** Writes the macro list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_macros(void)
+{
+        MACRO           *mptr;
+        unsigned        count = 0;
+
+        for (mptr = macro_list; mptr != (MACRO *)NULL; mptr = mptr->mnext)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (mptr = macro_list; mptr != (MACRO *)NULL; mptr = mptr->mnext)
+        {
+                if (!put_snap_str(mptr->mname) || !put_snap_str(mptr->mexp))
+                        return 0;
+        }
+
+        return 1;
+}
+
+/*
+** load_macros:
+** Adds the macros from the snapshot to the macro list.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_macros(void)
+{
+        unsigned        count;
+        char            *name;
+        char            *data;
+
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                name = get_snap_str();
+                data = get_snap_str();
+                if (name == (char *)NULL || data == (char *)NULL)
+                        continue;
+                if (!add_macro(name, data))
+                        return 0;
+        }
+
+        return 1;
+}
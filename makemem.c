@@ -17,6 +17,23 @@ NOTES
 The routines in this module insulate the application from the
 environment specific details of memory handling.
 
+Arenas:
+
+Most of what is read from the makefile (target, rule, and macro
+descriptors and their names) is kept until the program ends, and is
+never freed one piece at a time.  Getting each of these small pieces
+from the heap wastes the heap's overhead for every piece, and
+scatters them around memory.  Instead, such data is taken from an
+arena, which gets memory from the heap in large blocks and hands it
+out by moving a pointer forward through the current block.  The
+memory in an arena can't be freed a piece at a time; the whole arena
+is released at once by arena_release().
+
+A request too large to fit comfortably in a block gets a block of
+its own, so the rest of the current block isn't wasted.  Each arena
+counts its allocations and bytes, which dump_arenas() shows in debug
+mode.
+
 ======================================================================
 */
 
@@ -37,6 +54,28 @@ environment specific details of memory handling.
 
 #include "make.h"
 
+/****************************** CONSTANTS ***************************/
+
+/* Usual size of an arena block, in bytes. */
+#define ARENA_BLOCK     4096
+
+/* Alignment of memory handed out by arena_alloc(). */
+#define ARENA_ALIGN     sizeof(long)
+
+/* Rounds a size up to a multiple of ARENA_ALIGN. */
+#define ARENA_ROUND(n)  (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/*
+** Size of the header at the start of each arena block, which
+** points to the block that was obtained before it.
+*/
+#define ARENA_HDR       ARENA_ROUND(sizeof(char *))
+
+/****************************** VARIABLES ***************************/
+
+/* arena_list:  List of arenas, for dump_arenas() and mem_deinit(). */
+static ARENA *arena_list;
+
 /****************************** FUNCTIONS ***************************/
 
 /*
@@ -74,6 +113,15 @@ mem_init(void)
 int
 mem_deinit(void)
 {
+        ARENA   *arena;
+
+        /* Release anything that is still left in the arenas. */
+        for (arena = arena_list; arena != (ARENA *)NULL;
+                arena = arena->anext)
+        {
+                arena_release(arena);
+        }
+
         return 1;
 }
 
@@ -161,3 +209,217 @@ mem_heapmin(void)
 #endif /* WIN */
 }
 
+
+/*
+** arena_init:
+** Initializes an arena, which must be empty.  The arena is
+** added to the list of arenas shown by dump_arenas(), if it
+** isn't there already.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      arena   Pointer to arena to initialize.
+**      aname   Name of arena, for dump_arenas().
+**
+** Returns:
+**      NONE
+*/
+void
+arena_init(arena, aname)
+        ARENA   *arena;
+        char    *aname;
+{
+        ARENA   *aptr;
+
+        arena->aname = aname;
+        arena->ablock = (char *)NULL;
+        arena->aused = 0;
+        arena->asize = 0;
+        arena->abytes = 0L;
+        arena->acount = 0L;
+        arena->ablocks = 0;
+
+        for (aptr = arena_list; aptr != (ARENA *)NULL; aptr = aptr->anext)
+        {
+                if (aptr == arena)
+                        return;
+        }
+        arena->anext = arena_list;
+        arena_list = arena;
+}
+
+/*
+** arena_alloc:
+** Allocates a block of memory from an arena.  The memory
+** can't be freed by itself; it stays allocated until the
+** arena is released.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      arena   Pointer to arena to allocate from.
+**      bytes   Number of bytes of memory to allocate.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Not enough memory left.
+**      other   Pointer to allocated memory.
+*/
+void *
+arena_alloc(arena, bytes)
+        ARENA   *arena;
+        size_t  bytes;
+{
+        size_t  n;
+        char    *blk;
+
+        /* Make sure the rounded size and header don't overflow. */
+        if (bytes > (size_t)(-1) - ARENA_HDR - ARENA_ALIGN)
+                return NULL;
+        n = ARENA_ROUND(bytes);
+        if (n == 0)
+                n = ARENA_ALIGN;
+
+        if (arena->ablock == (char *)NULL || arena->asize - arena->aused < n)
+        {
+                if (n > (ARENA_BLOCK - ARENA_HDR) / 4)
+                {
+                        /*
+                        ** Give a large request a block of its own,
+                        ** behind the block being filled.
+                        */
+                        blk = (char *)mem_alloc(ARENA_HDR + n);
+                        if (blk == (char *)NULL)
+                                return NULL;
+                        arena->ablocks++;
+                        arena->abytes += bytes;
+                        arena->acount++;
+                        if (arena->ablock == (char *)NULL)
+                        {
+                                *(char **)blk = (char *)NULL;
+                                arena->ablock = blk;
+                                arena->aused = ARENA_HDR + n;
+                                arena->asize = ARENA_HDR + n;
+                        }
+                        else
+                        {
+                                *(char **)blk = *(char **)arena->ablock;
+                                *(char **)arena->ablock = blk;
+                        }
+                        return &blk[ARENA_HDR];
+                }
+
+                /* Start a new block. */
+                blk = (char *)mem_alloc(ARENA_BLOCK);
+                if (blk == (char *)NULL)
+                        return NULL;
+                arena->ablocks++;
+                *(char **)blk = arena->ablock;
+                arena->ablock = blk;
+                arena->aused = ARENA_HDR;
+                arena->asize = ARENA_BLOCK;
+        }
+
+        /* Take the memory from the block being filled. */
+        blk = &arena->ablock[arena->aused];
+        arena->aused += n;
+        arena->abytes += bytes;
+        arena->acount++;
+
+        return blk;
+}
+
+/*
+** arena_strdup:
+** Makes a copy of a string in an arena.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      arena   Pointer to arena to allocate from.
+**      s       String to copy.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Not enough memory left.
+**      other   Pointer to copy of string.
+*/
+char *
+arena_strdup(arena, s)
+        ARENA   *arena;
+        char    *s;
+{
+        char    *d;
+
+        d = (char *)arena_alloc(arena, strlen(s) + 1);
+        if (d != (char *)NULL)
+                strcpy(d, s);
+
+        return d;
+}
+
+/*
+** arena_release:
+** Frees all of the memory allocated from an arena.  The
+** arena is left empty, ready to be used again.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      arena   Pointer to arena to release.
+**
+** Returns:
+**      NONE
+*/
+void
+arena_release(arena)
+        ARENA   *arena;
+{
+        char    *blk;
+
+        while (arena->ablock != (char *)NULL)
+        {
+                blk = arena->ablock;
+                arena->ablock = *(char **)blk;
+                mem_free(blk);
+        }
+        arena->aused = 0;
+        arena->asize = 0;
+        arena->abytes = 0L;
+        arena->acount = 0L;
+        arena->ablocks = 0;
+}
+
+/*
+** dump_arenas:
+** Outputs the number of allocations and bytes in each arena.
+** This function is used for debugging.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_arenas(void)
+{
+        ARENA   *arena;
+
+        for (arena = arena_list; arena != (ARENA *)NULL;
+                arena = arena->anext)
+        {
+                mputs(MSG_DBG_ARENA);
+                mputs(arena->aname);
+                mputs(MSG_DBG_ARENABYTES);
+                mputs(multoa(arena->abytes));
+                mputs(MSG_DBG_ARENACOUNT);
+                mputs(multoa(arena->acount));
+                mputs(MSG_DBG_ARENABLOCKS);
+                mputs(multoa((unsigned long)arena->ablocks));
+                mputs("\n");
+        }
+}
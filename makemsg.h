@@ -36,6 +36,10 @@ error messages, status messages, and debug messages.
 #define OPT_NO_SHOW             's'
 #define OPT_TOUCH               't'
 #define OPT_NEEDNEWER           'y'
+#define OPT_JOBS                'j'
+#define OPT_DIGEST              'h'
+#define OPT_CMDSIG              'g'
+#define OPT_SNAPSHOT            'm'
 
 /* Sign on message. */
 #define MSG_APPNAME     "DXMake"
@@ -96,7 +100,11 @@ usage:  make [-fMakefile] [-wDirectory] [options] [macro=text...] [target...]\n\
    -c   Display name/version message.\n\
    -d   Enable debug output.\n\
    -e   Override macros with environment strings.\n\
+   -g   Rebuild targets whose commands have changed.\n\
+   -h   Compare contents of dependents instead of timestamps.\n\
    -i   Ignore exit codes of commands.\n\
+   -jN  Run up to N commands at the same time.\n\
+   -m   Save parsed makefile in 'make.snp' and reuse it.\n\
    -n   Display commands without executing them.\n\
    -p   Display macros, rules, and targets.\n\
    -q   Query:  return 0 if targets are up-to-date, nonzero otherwise.\n\
@@ -108,6 +116,9 @@ usage:  make [-fMakefile] [-wDirectory] [options] [macro=text...] [target...]\n\
 /* Status messages. */
 #define MSG_UPTODATE            "make:  Target already up to date:  "
 #define MSG_TARGETNOTEXIST      "make:  Warning, target does not exist:  "
+#define MSG_CACHERESTORED       "make:  Restored from cache:  "
+#define MSG_CACHEHITS           "make:  Cache hits:  "
+#define MSG_CACHEMISSES         ", misses:  "
 #define MSG_TOOLHELPWARN        "\
 make:  Warning, TOOLHELP.DLL not installed; can't check exit codes\n"
 #define MSG_PRESSAKEY           "make:  Press a key to continue\n"
@@ -129,11 +140,16 @@ make:  Warning, environment length exceeds buffer size; truncating\n"
 #define MSG_ERR_ENVSYNTAX       "Error in environment string"
 #define MSG_ERR_FNOMAKEFILE     "'-f' requires filename"
 #define MSG_ERR_FNODIRNAME      "'-w' requires directory name"
+#define MSG_ERR_JNOCOUNT        "'-j' requires number of jobs"
 #define MSG_ERR_BADOPTION       "Unrecognized option"
 #define MSG_ERR_NOTARGETS       "No targets defined in makefile"
 #define MSG_ERR_BADSUFFIX       "Invalid suffix in suffix list"
 #define MSG_ERR_IOREAD          "Read failure in input file"
+#define MSG_ERR_IOWRITE         "Write failure in output file"
+#define MSG_ERR_CANTCREATE      "Can't create file"
 #define MSG_ERR_NOMACRO         "Macro not defined"
+#define MSG_ERR_MACROLOOP       "Macro refers to itself"
+#define MSG_ERR_MACRODEPTH      "Macros nested too deeply"
 #define MSG_ERR_NORPAREN        "Missing right parenthesis ')' "
 #define MSG_ERR_UNREADFULL      "Fatal scanner error - multiple unreads"
 #define MSG_ERR_UNREADLEN       "Fatal scanner error - unread data too long"
@@ -167,6 +183,11 @@ Macro expansion causes string to exceed maximum allowable length"
 #define MSG_ERR_OUTOFMEMORY     "Out of memory"
 #define MSG_ERR_BANGUNEXP       "Unexpected directive"
 #define MSG_ERR_TOOMANYIFS      "!IFs nested too deeply"
+#define MSG_ERR_TOOMANYINCS     "!INCLUDEs nested too deeply"
+#define MSG_ERR_BADINCLUDE      "Bad filename in !INCLUDE"
+#define MSG_ERR_CIRCULAR        "Target depends on itself"
+#define MSG_ERR_JOBWAIT         "Error waiting for command to finish"
+#define MSG_ERR_JOBSTUCK        "Jobs waiting for targets that can't be made"
 
 /* Debug mode messages. */
 #define MSG_DBG_ENABLED         "debug:  Debugging output enabled.\n"
@@ -177,10 +198,29 @@ Macro expansion causes string to exceed maximum allowable length"
 #define MSG_DBG_UTEXISTS        "debug:  Undescribed target exists:  "
 #define MSG_DBG_POSSIBLERULE    "debug:    Possible rule:  "
 #define MSG_DBG_HAVEMATCH       "debug:    Matching file:  "
+#define MSG_DBG_RULECHAIN       "\ndebug:    Rules in chain:  "
 #define MSG_DBG_SHOWUPTODATE    "debug:  Target is up to date with dependent:  "
 #define MSG_DBG_ISUPTODATE      "debug:  Target is up to date:  "
 #define MSG_DBG_BUILDING        "debug:  Building:  "
 #define MSG_DBG_ASSUMEDUMMY     "debug:  Assuming target is dummy:  "
+#define MSG_DBG_PHONY           "debug:  Target is phony:  "
+#define MSG_DBG_ALREADYCHECKED  "debug:  Target already checked:  "
+#define MSG_DBG_STATHITS        "debug:  File time/date cache hits:  "
+#define MSG_DBG_STATMISSES      ", misses:  "
+#define MSG_DBG_DIRREADS        "debug:  Directory scans:  "
+#define MSG_DBG_DIRHITS         ", lookups answered from index:  "
+#define MSG_DBG_ARENA           "debug:  Memory for "
+#define MSG_DBG_ARENABYTES      ":  "
+#define MSG_DBG_ARENACOUNT      " bytes in "
+#define MSG_DBG_ARENABLOCKS     " allocations, blocks:  "
+#define MSG_DBG_DIGESTED        "debug:  Computed digest of:  "
+#define MSG_DBG_CMDSCHANGED     "debug:  Commands changed for:  "
+#define MSG_DBG_CACHESTORE      "debug:  Stored in cache:  "
+#define MSG_DBG_CACHEEVICT      "debug:  Removed from cache:  "
+#define MSG_DBG_RESTAT          "debug:  Target unchanged by commands:  "
+#define MSG_DBG_JOBQUEUED       "debug:  Queued job for:  "
+#define MSG_DBG_JOBSTART        "debug:  Starting job for:  "
+#define MSG_DBG_JOBDONE         "debug:  Finished job for:  "
 
 /* Info mode messages. */
 #define MSG_INFO_ENABLED        "info:  Table information output enabled.\n"
@@ -194,10 +234,18 @@ info:  No targets on command line; assuming "
 #define MSG_INFO_PRECIOUS       "info:  PRECIOUS filenames:\n"
 #define MSG_INFO_NOPRECIOUS     "info:    <none>\n"
 #define MSG_INFO_SHOWPRECIOUS   "info:    "
+#define MSG_INFO_RESTAT         "info:  RESTAT filenames:\n"
+#define MSG_INFO_NORESTAT       "info:    <none>\n"
+#define MSG_INFO_RESTATALL      "info:    <all targets>\n"
+#define MSG_INFO_SHOWRESTAT     "info:    "
+#define MSG_INFO_PHONY          "info:  PHONY targets:\n"
+#define MSG_INFO_NOPHONY        "info:    <none>\n"
+#define MSG_INFO_SHOWPHONY      "info:    "
 #define MSG_INFO_NOMACROS       "info:  Macro list is empty.\n"
 #define MSG_INFO_MACRONAME      "info:  Macro:  "
 #define MSG_INFO_MACRODATA      "info:        = "
 #define MSG_INFO_NORULES        "info:  Rule list is empty.\n"
+#define MSG_INFO_NOPATTERNS     "info:  Pattern rule list is empty.\n"
 #define MSG_INFO_RULENAME       "info:  Rule:  "
 #define MSG_INFO_RULECMD        "info:      "
 #define MSG_INFO_NOTARGETS      "info:  Target list is empty.\n"
@@ -0,0 +1,738 @@
+/*
+======================================================================
+makepat.c
+Pattern rule handling routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+A pattern rule describes how to build files whose names fit a
+pattern, from files whose names fit another pattern.  Each pattern
+contains one '%', which stands for any non-empty string (the stem).
+For example:
+
+        obj\%.obj: src\%.c
+                cl -c -Fo$@ $<
+
+builds "obj\test.obj" from "src\test.c".  Unlike ".src.dest" rules,
+pattern rules can name directories, and their suffixes aren't
+limited to MAX_SUFFIX_STR characters.  They don't depend on the
+".SUFFIXES" list.
+
+Pattern rules are kept in their own list, with the most recently
+defined rule first.  They are stored as RULE descriptors with
+rpattern set, rdest holding the target pattern, and rsrc holding
+the source pattern, so the build code can use them the same way
+as ".src.dest" rules (see rule_source() in makerul.c).
+
+Pattern index:
+
+find_patterns() gets the pattern rules whose target pattern fits
+a file's name.  Instead of testing every pattern against the name,
+the target patterns are kept in a trie, keyed on the part after
+the '%' read backward from the end.  Walking the trie backward
+along the file's name visits only the patterns whose suffix fits
+the name, and there the prefix before the '%' is compared.  Each
+step of the walk only looks at the nodes for the next character,
+so the cost depends on the length of the name, not the number of
+pattern rules.  The rules found are returned with the shortest
+stem first, and with the most recently defined rule first among
+those with stems of the same length.
+
+Like the rule index in makerul.c, the trie is built all at once
+in an arena of its own the first time it is needed, and thrown
+away whenever the pattern rule list changes.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static int      check_pattern(char *pat);
+static int      same_prefix(char *name, char *pat, int len);
+static PATNODE  *add_node(PATNODE *parent, char c);
+static int      build_pattern_index(void);
+
+/****************************** CONSTANTS ***************************/
+
+/* Converts an upper case letter to lower case for name comparisons. */
+#define LOWC(c)         ((c) >= 'A' && (c) <= 'Z' ? (c) + ('a' - 'A') : (c))
+
+/****************************** VARIABLES ***************************/
+
+/* Linked list of defined pattern rules. */
+static RULE *pattern_list;
+
+/* Memory for pattern rule descriptors and their patterns. */
+static ARENA pattern_arena;
+
+/* Root of the pattern index trie (see NOTES). */
+static PATNODE *pattern_root;
+
+/* Memory for the pattern index. */
+static ARENA pindex_arena;
+
+/* Nonzero if the pattern index is up to date. */
+static int pattern_index_ok;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** check_pattern:
+** Checks that a pattern contains exactly one '%'.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      pat     Pattern to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Pattern is valid.
+**      0       Pattern has no '%', or more than one.
+*/
+static int
+check_pattern(pat)
+        char    *pat;
+{
+        char    *pct;
+
+        pct = strchr(pat, '%');
+        return pct != (char *)NULL && strchr(pct + 1, '%') == (char *)NULL;
+}
+
+/*
+** same_prefix:
+** Compares the start of a filename with the prefix of a
+** pattern, ignoring case.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      name    Filename to compare.
+**      pat     Pattern to compare.
+**      len     Length of pattern's prefix.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Filename starts with pattern's prefix.
+**      0       Filename doesn't start with pattern's prefix.
+*/
+static int
+same_prefix(name, pat, len)
+        char    *name;
+        char    *pat;
+        int     len;
+{
+        int     i;
+
+        for (i = 0; i < len; i++)
+        {
+                if (LOWC(name[i]) != LOWC(pat[i]))
+                        return 0;
+        }
+
+        return 1;
+}
+
+/*
+** add_node:
+** Gets the child of a pattern index node for a character,
+** adding it if it isn't there yet.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      parent  Node whose child is wanted.
+**      c       Character of child node (lower case).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Out of memory.
+**      other   Pointer to child node.
+*/
+static PATNODE *
+add_node(parent, c)
+        PATNODE *parent;
+        char    c;
+{
+        PATNODE *node;
+
+        for (node = parent->nchild; node != (PATNODE *)NULL;
+                node = node->nsibling)
+        {
+                if (node->nchar == c)
+                        return node;
+        }
+
+        node = (PATNODE *)arena_alloc(&pindex_arena, sizeof(PATNODE));
+        if (node == (PATNODE *)NULL)
+                return (PATNODE *)NULL;
+        node->nchar = c;
+        node->nchild = (PATNODE *)NULL;
+        node->nrules = (PATENT *)NULL;
+        node->nsibling = parent->nchild;
+        parent->nchild = node;
+
+        return node;
+}
+
+/*
+** build_pattern_index:
+** Builds the pattern index from the pattern rule list,
+** replacing any old index.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+build_pattern_index(void)
+{
+        RULE    *rptr;
+        PATENT  *ent;
+        PATNODE *node;
+        char    *pct;           /* Position of '%' in target pattern. */
+        char    *s;
+        int     seq;            /* Position of rule in list. */
+
+        arena_release(&pindex_arena);
+        pattern_root = (PATNODE *)arena_alloc(&pindex_arena,
+                sizeof(PATNODE));
+        if (pattern_root == (PATNODE *)NULL)
+                return 0;
+        pattern_root->nchar = '\0';
+        pattern_root->nchild = (PATNODE *)NULL;
+        pattern_root->nsibling = (PATNODE *)NULL;
+        pattern_root->nrules = (PATENT *)NULL;
+
+        seq = 0;
+        for (rptr = pattern_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+        {
+                ent = (PATENT *)arena_alloc(&pindex_arena, sizeof(PATENT));
+                if (ent == (PATENT *)NULL)
+                        return 0;
+                pct = strchr(rptr->rdest, '%');
+                ent->erule = rptr;
+                ent->eseq = seq++;
+                ent->eprelen = pct - rptr->rdest;
+                ent->esuflen = strlen(pct + 1);
+
+                /* Follow the suffix backward, adding nodes as needed. */
+                node = pattern_root;
+                for (s = pct + ent->esuflen; s > pct; s--)
+                {
+                        node = add_node(node, (char)LOWC(*s));
+                        if (node == (PATNODE *)NULL)
+                                return 0;
+                }
+                ent->enext = node->nrules;
+                node->nrules = ent;
+        }
+
+        pattern_index_ok = 1;
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_patterns:
+** Initializes the pattern rule list.  This function must be
+** called prior to using any of the other pattern rule
+** functions in this module.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_patterns(void)
+{
+        arena_init(&pattern_arena, "pattern rules");
+        arena_init(&pindex_arena, "pattern index");
+        pattern_list = (RULE *)NULL;
+        pattern_index_ok = 0;
+}
+
+/*
+** flush_patterns:
+** Empties and frees the pattern rule list.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_patterns(void)
+{
+        RULE    *r;
+
+        /* Free each rule's command lines. */
+        for (r = pattern_list; r != (RULE *)NULL; r = r->rnext)
+                free_lines(r->rcommands);
+
+        /* Free the descriptors, patterns, and index all at once. */
+        arena_release(&pattern_arena);
+        arena_release(&pindex_arena);
+
+        pattern_list = (RULE *)NULL;
+        pattern_index_ok = 0;
+}
+
+/*
+** define_pattern:
+** Adds a pattern rule to the pattern rule list.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    First line of pattern rule definition.
+**      handle  File handle to read for remaining lines of rule.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred (syntax error, out of memory, I/O error).
+*/
+int
+define_pattern(line, handle)
+        char    *line;
+        int     handle;
+{
+        int     pos;
+        int     itmp;
+        int     result;         /* Return code from last read. */
+        char    tpat[MAXPATH];  /* Target pattern. */
+        char    spat[MAXPATH];  /* Source pattern. */
+        RULE    *rul;           /* Temporary rule descriptor pointer. */
+        LIST    cmds;           /* Rule's command lines. */
+
+        /* Get target pattern. */
+        pos = 0;
+        itmp = 0;
+        while (line[pos] != '\0' &&
+                line[pos] != ' ' &&
+                line[pos] != '\t' &&
+                !(line[pos] == ':' && line[pos + 1] != '\\'))
+        {
+                if (itmp >= MAXPATH - 1)
+                {
+                        /* Pattern is too long. */
+                        errmsg(MSG_ERR_PATHTOOLONG, line, NOVAL);
+                        return 0;
+                }
+                tpat[itmp++] = line[pos++];
+        }
+        tpat[itmp] = '\0';
+
+        /* Skip any whitespace before the colon. */
+        while (line[pos] == ' ' || line[pos] == '\t')
+                pos++;
+
+        /* Check for colon. */
+        if (line[pos] != ':')
+        {
+                /* Syntax error in rule definition. */
+                errmsg(MSG_ERR_RULESYNTAX, line, NOVAL);
+                return 0;
+        }
+        pos++;  /* Skip the colon. */
+
+        /* Skip any whitespace after the colon. */
+        while (line[pos] == ' ' || line[pos] == '\t')
+                pos++;
+
+        /* Get source pattern. */
+        itmp = 0;
+        while (line[pos] != '\0' &&
+                line[pos] != ' ' &&
+                line[pos] != '\t')
+        {
+                if (itmp >= MAXPATH - 1)
+                {
+                        /* Pattern is too long. */
+                        errmsg(MSG_ERR_PATHTOOLONG, line, NOVAL);
+                        return 0;
+                }
+                spat[itmp++] = line[pos++];
+        }
+        spat[itmp] = '\0';
+
+        /* Skip any trailing whitespace. */
+        while (line[pos] == ' ' || line[pos] == '\t')
+                pos++;
+
+        /*
+        ** There must be exactly one source pattern, and each
+        ** pattern must have exactly one '%'.
+        */
+        if (line[pos] != '\0' || !check_pattern(tpat) ||
+                !check_pattern(spat))
+        {
+                /* Syntax error in rule definition. */
+                errmsg(MSG_ERR_RULESYNTAX, line, NOVAL);
+                return 0;
+        }
+
+        /* The rule's name, as rule_name() builds it, must fit. */
+        if (strlen(tpat) + strlen(spat) + 3 > MAXPATH)
+        {
+                /* Patterns are too long. */
+                errmsg(MSG_ERR_PATHTOOLONG, line, NOVAL);
+                return 0;
+        }
+
+        /*
+        ** Build new rule descriptor.
+        */
+
+        rul = (RULE *)arena_alloc(&pattern_arena, sizeof(RULE));
+        if (rul == (RULE *)NULL)
+        {
+                /* Out of memory for rule definition. */
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+        rul->rdest = arena_strdup(&pattern_arena, tpat);
+        rul->rsrc = arena_strdup(&pattern_arena, spat);
+        if (rul->rdest == (char *)NULL || rul->rsrc == (char *)NULL)
+        {
+                /* Out of memory for patterns. */
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+        rul->rpattern = 1;
+        rul->rcommands = (LINE *)NULL;
+
+        /* Insert rule at head of list. */
+        rul->rnext = pattern_list;
+        pattern_list = rul;
+        pattern_index_ok = 0;
+
+        /*
+        ** Get the command lines for the rule.
+        */
+        init_list(&cmds);
+        while (1)
+        {
+                result = read_logical_line(handle, inpline, MAXLLINE);
+                if (result == -1)
+                {
+                        /* Fatal read error. */
+                        return 0;
+                }
+                if (result < 1)
+                {
+                        /* Unexpected end of file. */
+                        errmsg(MSG_ERR_EOF, (char *)NULL, NOVAL);
+                        return 0;
+                }
+
+                /* Check for a comment line. */
+                if (inpline[0] == '#')
+                        continue;
+
+                /*
+                ** Check for end of rule's commands.  A line that
+                ** isn't indented isn't part of the rule's commands,
+                ** so push it back into the input stream.
+                */
+                if (inpline[0] != ' ' && inpline[0] != '\t')
+                {
+                        unread_logical_line(inpline);
+                        break;
+                }
+
+                /* Find first non-whitespace character. */
+                pos = 0;
+                while (inpline[pos] == ' ' || inpline[pos] == '\t')
+                        pos++;
+
+                /* Add line to rule. */
+                if (!add_to_list(&cmds, &inpline[pos]))
+                {
+                        /* Out of memory for rule data. */
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                rul->rcommands = cmds.lhead;
+        } /* End while(1) */
+
+        return 1;
+}
+
+/*
+** dump_patterns:
+** Outputs the pattern rule list.  This function is used for
+** debugging.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_patterns(void)
+{
+        LINE    *lptr;
+        RULE    *rptr;
+        char    name[MAXPATH];
+
+        if (pattern_list == (RULE *)NULL)
+                mputs(MSG_INFO_NOPATTERNS);
+        for (rptr = pattern_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+        {
+                rule_name(rptr, name);
+                mputs(MSG_INFO_RULENAME);
+                mputs(name);
+                mputs("\n");
+                for (lptr = rptr->rcommands; lptr != (LINE *)NULL;
+                        lptr = lptr->lnext)
+                {
+                        mputs(MSG_INFO_RULECMD);
+                        mputs(lptr->ldata);
+                        mputs("\n");
+                }
+        }
+}
+
+/*
+** find_patterns:
+** Gets the pattern rules whose target pattern fits a file's
+** name, using the pattern index (see NOTES).  The index is
+** built first if it isn't up to date.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of file to be built.
+**      rules   Array to return rules in, which must have
+**              room for MAX_PATMATCH + 1 entries.  The rules
+**              are in order of preference, ending with NULL.
+**              If more than MAX_PATMATCH rules fit, the least
+**              preferred are left out.
+**
+** Returns:
+**      Number of rules returned (0 if none, or out of memory).
+*/
+int
+find_patterns(tname, rules)
+        char    *tname;
+        RULE    **rules;
+{
+        PATNODE *node;
+        PATENT  *ent;
+        int     stems[MAX_PATMATCH];    /* Stem length of each rule. */
+        int     seqs[MAX_PATMATCH];     /* List position of each rule. */
+        int     len;                    /* Length of tname. */
+        int     stem;
+        int     n;                      /* Number of rules found. */
+        int     i;
+        int     j;
+        char    c;
+
+        n = 0;
+        rules[0] = (RULE *)NULL;
+        if (pattern_list == (RULE *)NULL)
+                return 0;
+        if (!pattern_index_ok && !build_pattern_index())
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+
+        /* Walk the trie backward from the end of the name. */
+        len = strlen(tname);
+        i = len;
+        node = pattern_root;
+        while (node != (PATNODE *)NULL)
+        {
+                /* Check the rules whose suffix ends here. */
+                for (ent = node->nrules; ent != (PATENT *)NULL;
+                        ent = ent->enext)
+                {
+                        stem = len - ent->eprelen - ent->esuflen;
+                        if (stem < 1 || !same_prefix(tname,
+                                ent->erule->rdest, ent->eprelen))
+                        {
+                                continue;
+                        }
+
+                        /* Insert the rule in order of preference. */
+                        for (j = n; j > 0 && (stems[j - 1] > stem ||
+                                (stems[j - 1] == stem &&
+                                seqs[j - 1] > ent->eseq)); j--)
+                        {
+                                if (j < MAX_PATMATCH)
+                                {
+                                        rules[j] = rules[j - 1];
+                                        stems[j] = stems[j - 1];
+                                        seqs[j] = seqs[j - 1];
+                                }
+                        }
+                        if (j < MAX_PATMATCH)
+                        {
+                                rules[j] = ent->erule;
+                                stems[j] = stem;
+                                seqs[j] = ent->eseq;
+                                if (n < MAX_PATMATCH)
+                                        n++;
+                        }
+                }
+
+                /* Step to the node for the next character back. */
+                if (i == 0)
+                        break;
+                i--;
+                c = (char)LOWC(tname[i]);
+                for (node = node->nchild; node != (PATNODE *)NULL &&
+                        node->nchar != c; node = node->nsibling)
+                {
+                        ;
+                }
+        }
+
+        rules[n] = (RULE *)NULL;
+        return n;
+}
+
+/*
+** save_patterns:
+** Writes the pattern rule list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_patterns(void)
+{
+        RULE            *rptr;
+        unsigned        count = 0;
+
+        for (rptr = pattern_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (rptr = pattern_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+        {
+                if (!put_snap_str(rptr->rdest) ||
+                        !put_snap_str(rptr->rsrc) ||
+                        !put_snap_lines(rptr->rcommands))
+                {
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** load_patterns:
+** Loads the pattern rule list from the snapshot.  The
+** pattern rule list must be empty.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory, or snapshot is damaged.
+*/
+int
+load_patterns(void)
+{
+        RULE            *rul;
+        RULE            *tail = (RULE *)NULL;
+        LIST            cmds;
+        unsigned        count;
+        char            *tpat;
+        char            *spat;
+
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                tpat = get_snap_str();
+                spat = get_snap_str();
+                if (tpat == (char *)NULL || spat == (char *)NULL ||
+                        !check_pattern(tpat) || !check_pattern(spat))
+                {
+                        return 0;
+                }
+
+                /* Allocate and fill in rule descriptor. */
+                rul = (RULE *)arena_alloc(&pattern_arena, sizeof(RULE));
+                if (rul == (RULE *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                rul->rnext = (RULE *)NULL;
+                rul->rpattern = 1;
+                rul->rdest = arena_strdup(&pattern_arena, tpat);
+                rul->rsrc = arena_strdup(&pattern_arena, spat);
+                if (rul->rdest == (char *)NULL || rul->rsrc == (char *)NULL ||
+                        !get_snap_lines(&cmds))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                rul->rcommands = cmds.lhead;
+
+                /* Keep the rules in the same order as when saved. */
+                if (tail == (RULE *)NULL)
+                        pattern_list = rul;
+                else
+                        tail->rnext = rul;
+                tail = rul;
+        }
+        pattern_index_ok = 0;
+
+        return 1;
+}
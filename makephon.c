@@ -0,0 +1,404 @@
+/*
+======================================================================
+makephon.c
+"Phony targets" table handling routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+Many makefiles have targets such as "all", "clean", or "zip" that
+name a job to be done rather than a file to be built.  Make would
+normally look for a file by that name, warn that it doesn't exist,
+and try to find a rule to build it.  By placing a ".PHONY"
+psuedo-target in the makefile, the user can tell make which
+targets aren't files.  Make never looks for them on disk or tries
+rules on them; their commands (if any) are always run, and the
+time/date stamp they pass on to the targets that depend on them is
+that of their newest dependent.
+
+The ".PHONY" psuedo-target is followed by a colon, and then by a
+list of the target names that aren't files.
+
+For example:  ".PHONY: all clean zip"
+
+Since make asks whether a target is phony once for every target
+it checks, the names are kept in a hash table, in an arena of
+their own.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static PHONY    *find_phony(char *tname, unsigned int hash);
+static int      add_phony(char *tname);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the phony targets table. */
+#define PHONY_HASH_SIZE 32
+
+/****************************** VARIABLES ***************************/
+
+/* phony_table:  Hash table of phony target names. */
+static PHONY *phony_table[PHONY_HASH_SIZE];
+
+/* phony_count:  Number of names in phony_table. */
+static unsigned int phony_count;
+
+/* Memory for the phony targets table. */
+static ARENA phony_arena;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** find_phony:
+** Searches the phony targets table for a name.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to search for.
+**      hash    hash_name() value of tname.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Name is not in the table.
+**      other   Pointer to name's entry.
+*/
+static PHONY *
+find_phony(tname, hash)
+        char            *tname;
+        unsigned int    hash;
+{
+        PHONY   *pptr;
+
+        pptr = phony_table[hash % PHONY_HASH_SIZE];
+        while (pptr != (PHONY *)NULL)
+        {
+                if (pptr->phash == hash && strcmp(pptr->pname, tname) == 0)
+                        return pptr;
+                pptr = pptr->pnext;
+        }
+
+        return (PHONY *)NULL;
+}
+
+/*
+** add_phony:
+** Adds a name to the phony targets table, unless it is
+** already there.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of phony target.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+add_phony(tname)
+        char    *tname;
+{
+        PHONY           *pptr;
+        unsigned int    hash;
+
+        hash = hash_name(tname);
+        if (find_phony(tname, hash) != (PHONY *)NULL)
+                return 1;
+
+        pptr = (PHONY *)arena_alloc(&phony_arena, sizeof(PHONY));
+        if (pptr == (PHONY *)NULL)
+                return 0;
+        pptr->pname = arena_strdup(&phony_arena, tname);
+        if (pptr->pname == (char *)NULL)
+                return 0;
+        pptr->phash = hash;
+        pptr->pnext = phony_table[hash % PHONY_HASH_SIZE];
+        phony_table[hash % PHONY_HASH_SIZE] = pptr;
+        phony_count++;
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_phony:
+** Initializes the phony targets table.  This function
+** gets called before any other actions are performed on
+** the phony targets table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_phony(void)
+{
+        int     i;
+
+        arena_init(&phony_arena, "phony targets");
+        for (i = 0; i < PHONY_HASH_SIZE; i++)
+                phony_table[i] = (PHONY *)NULL;
+        phony_count = 0;
+}
+
+/*
+** flush_phony:
+** Flushes the contents of the phony targets table.
+** This function gets called before the program terminates
+** to free up memory used by the phony targets table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_phony(void)
+{
+        arena_release(&phony_arena);
+        init_phony();
+}
+
+/*
+** do_phony:
+** Parses ".PHONY" psuedo-target lines from the makefile.
+** The names are added to the phony targets table.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    String containing ".PHONY" psuedo-target
+**              to be parsed.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+do_phony(line)
+        char    *line;
+{
+        int     i = 0;                  /* Line position index. */
+        int     j;                      /* Loop index. */
+        char    tname[MAXPATH];         /* Phony target name. */
+
+        if (strncmp(line, ".PHONY", 6) != 0)
+        {
+                /*
+                ** Line isn't a ".PHONY" line.
+                ** This should never happen, since the primary
+                ** input dispatching code calls us.
+                */
+                return 0;
+        }
+
+        /* Skip the psuedo-target name and the colon. */
+        while (line[i] != '\0' &&
+                line[i] != ' ' &&
+                line[i] != '\t')
+        {
+                i++;
+        }
+
+        /* Skip leading whitespace. */
+        while (line[i] == ' ' || line[i] == '\t')
+                i++;
+
+        /* Extract each name from input line. */
+        while (line[i] != '\0')
+        {
+                /* Extract next name from input line. */
+                j = 0;
+                while (line[i] != ' ' && line[i] != '\t' &&
+                        line[i] != '\0' && j < MAXPATH - 1)
+                {
+                        tname[j++] = line[i++];
+                }
+                tname[j] = '\0';
+                if (line[i] != ' ' && line[i] != '\t' &&
+                        line[i] != '\0')
+                {
+                        /* Error in ".PHONY:" */
+                        errmsg(MSG_ERR_PATHTOOLONG, line, NOVAL);
+                        return 0;
+                }
+
+                /* Add the name to the phony targets table. */
+                if (!add_phony(tname))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+
+                /* Skip whitespace before next name. */
+                while (line[i] == ' ' || line[i] == '\t')
+                        i++;
+        } /* End while() */
+
+        /* Success! */
+        return 1;
+}
+
+/*
+** is_phony:
+** Determines if the specified target is a phony target.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Target is phony.
+**      0       Target is not phony.
+*/
+int
+is_phony(tname)
+        char    *tname;
+{
+        if (phony_count == 0)
+                return 0;
+
+        return find_phony(tname, hash_name(tname)) != (PHONY *)NULL;
+}
+
+/*
+** dump_phony:
+** Outputs the contents of the phony targets table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_phony(void)
+{
+        PHONY   *pptr;
+        int     i;
+
+        mputs(MSG_INFO_PHONY);
+        if (phony_count == 0)
+        {
+                mputs(MSG_INFO_NOPHONY);
+                return;
+        }
+        for (i = 0; i < PHONY_HASH_SIZE; i++)
+        {
+                for (pptr = phony_table[i]; pptr != (PHONY *)NULL;
+                        pptr = pptr->pnext)
+                {
+                        mputs(MSG_INFO_SHOWPHONY);
+                        mputs(pptr->pname);
+                        mputs("\n");
+                }
+        }
+}
+
+/*
+** save_phony:
+** Writes the phony targets table to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_phony(void)
+{
+        PHONY   *pptr;
+        int     i;
+
+        if (!put_snap_word(phony_count))
+                return 0;
+        for (i = 0; i < PHONY_HASH_SIZE; i++)
+        {
+                for (pptr = phony_table[i]; pptr != (PHONY *)NULL;
+                        pptr = pptr->pnext)
+                {
+                        if (!put_snap_str(pptr->pname))
+                                return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** load_phony:
+** Loads the phony targets table from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_phony(void)
+{
+        unsigned int    count;
+        char            *tname;
+
+        flush_phony();
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                tname = get_snap_str();
+                if (tname != (char *)NULL && !add_phony(tname))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
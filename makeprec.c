@@ -50,7 +50,7 @@ file, where each line contains one filename.
 /****************************** VARIABLES ***************************/
 
 /* precious_list:  Linked list of precious filenames. */
-static LINE *precious_list;
+static LIST precious_list;
 
 /****************************** FUNCTIONS ***************************/
 
@@ -69,7 +69,7 @@ static LINE *precious_list;
 void
 init_precious(void)
 {
-        precious_list = (LINE *)NULL;
+        init_list(&precious_list);
 }
 
 /*
@@ -87,8 +87,7 @@ init_precious(void)
 void
 flush_precious(void)
 {
-        free_lines(precious_list);
-        precious_list = (LINE *)NULL;
+        flush_list(&precious_list);
 }
 
 /*
@@ -117,7 +116,6 @@ do_precious(line)
         int     j;                      /* Loop index. */
         int     num_precious;           /* Number of filenames extracted. */
         char    precname[MAXPATH];      /* Precious filename. */
-        LINE    *tmp;                   /* Temporary line pointer. */
 
         /* Skip the psuedo-target name. */
         while (line[i] != '\0' &&
@@ -162,13 +160,11 @@ do_precious(line)
                 }
 
                 /* Add the filename to the precious list. */
-                tmp = append_line(precious_list, precname);
-                if (tmp == (LINE *)NULL)
+                if (!add_to_list(&precious_list, precname))
                 {
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
                         return 0;
                 }
-                precious_list = tmp;
                 num_precious++;
 
                 /* Skip whitespace before next filename. */
@@ -202,7 +198,7 @@ is_precious(tname)
 {
         LINE    *lptr;
 
-        lptr = precious_list;
+        lptr = precious_list.lhead;
         while (lptr != (LINE *)NULL)
         {
                 if (stricmp(lptr->ldata, tname) == 0)
@@ -233,7 +229,7 @@ dump_precious(void)
         LINE    *lptr;
 
         mputs(MSG_INFO_PRECIOUS);
-        lptr = precious_list;
+        lptr = precious_list.lhead;
         if (lptr == (LINE *)NULL)
         {
                 mputs(MSG_INFO_NOPRECIOUS);
@@ -249,3 +245,41 @@ dump_precious(void)
         }
 }
 
+/*
+** save_precious:
+** Writes the precious filenames list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_precious(void)
+{
+        return put_snap_lines(precious_list.lhead);
+}
+
+/*
+** load_precious:
+** Loads the precious filenames list from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_precious(void)
+{
+        flush_precious();
+        return get_snap_lines(&precious_list);
+}
@@ -0,0 +1,556 @@
+/*
+======================================================================
+makerst.c
+"Restat filenames" list handling routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+Normally, once the commands for a target have been run, everything
+that depends on the target is rebuilt too.  Some commands, such as
+code generators or "if exist ... copy" commands, often leave the
+target exactly as it was.  By placing a ".RESTAT" psuedo-target in
+the makefile, the user can have make check such targets again
+after their commands have been run.  If a target's contents didn't
+change, the targets that depend on it are not rebuilt.
+
+The ".RESTAT" psuedo-target is followed by a colon, and then by a
+list of the filenames to be checked again.  If no filenames are
+given, every target is checked again.
+
+For example:  ".RESTAT: version.h tables.c"
+
+The target keeps the new time/date stamp its commands gave it, so
+it is up to date the next time make is run.  Instead, the time its
+contents last changed is recorded in the digest database ("make.dig",
+see "makedig.c"), and make_target() passes that time on to the
+targets that depend on it.  The record only applies while the
+target keeps the same time/date stamp.
+
+When jobs are run with '-j', the targets that depend on a target
+have already been queued by the time its commands are run, so they
+are still built during that run; later runs use the record.
+
+Since make asks whether a target is to be checked again once for
+every target it builds, the filenames are kept in a hash table, in
+an arena of their own, in the same way as the phony targets (see
+"makephon.c").  DOS filenames aren't case sensitive, so the names
+are kept in lowercase.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static RESTAT   *find_restat(char *lname, unsigned int hash);
+static int      add_restat(char *fname);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the restat filenames table. */
+#define RESTAT_HASH_SIZE 32
+
+/****************************** VARIABLES ***************************/
+
+/* restat_table:  Hash table of restat filenames. */
+static RESTAT *restat_table[RESTAT_HASH_SIZE];
+
+/* restat_count:  Number of names in restat_table. */
+static unsigned int restat_count;
+
+/* Memory for the restat filenames table. */
+static ARENA restat_arena;
+
+/* restat_all:  Flag, nonzero if every target is to be checked again. */
+static int restat_all;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** find_restat:
+** Searches the restat filenames table for a name.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      lname   Filename to search for, in lowercase.
+**      hash    hash_name() value of lname.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Name is not in the table.
+**      other   Pointer to name's entry.
+*/
+static RESTAT *
+find_restat(lname, hash)
+        char            *lname;
+        unsigned int    hash;
+{
+        RESTAT  *rptr;
+
+        rptr = restat_table[hash % RESTAT_HASH_SIZE];
+        while (rptr != (RESTAT *)NULL)
+        {
+                if (rptr->rhash == hash && strcmp(rptr->rname, lname) == 0)
+                        return rptr;
+                rptr = rptr->rnext;
+        }
+
+        return (RESTAT *)NULL;
+}
+
+/*
+** add_restat:
+** Adds a name to the restat filenames table, unless it is
+** already there.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Filename to be checked again.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+add_restat(fname)
+        char    *fname;
+{
+        RESTAT          *rptr;
+        char            lname[MAXPATH];
+        unsigned int    hash;
+
+        strcpy(lname, fname);
+        strlwr(lname);
+        hash = hash_name(lname);
+        if (find_restat(lname, hash) != (RESTAT *)NULL)
+                return 1;
+
+        rptr = (RESTAT *)arena_alloc(&restat_arena, sizeof(RESTAT));
+        if (rptr == (RESTAT *)NULL)
+                return 0;
+        rptr->rname = arena_strdup(&restat_arena, lname);
+        if (rptr->rname == (char *)NULL)
+                return 0;
+        rptr->rhash = hash;
+        rptr->rnext = restat_table[hash % RESTAT_HASH_SIZE];
+        restat_table[hash % RESTAT_HASH_SIZE] = rptr;
+        restat_count++;
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** init_restat:
+** Initializes the restat filenames table.  This function
+** gets called before any other actions are performed on
+** the restat filenames table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_restat(void)
+{
+        int     i;
+
+        arena_init(&restat_arena, "restat filenames");
+        for (i = 0; i < RESTAT_HASH_SIZE; i++)
+                restat_table[i] = (RESTAT *)NULL;
+        restat_count = 0;
+        restat_all = 0;
+}
+
+/*
+** flush_restat:
+** Flushes the contents of the restat filenames table.
+** This function gets called before the program terminates
+** to free up memory used by the restat filenames table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_restat(void)
+{
+        arena_release(&restat_arena);
+        init_restat();
+}
+
+/*
+** do_restat:
+** Parses ".RESTAT" psuedo-target lines from the makefile.
+** Any filenames are added to the restat filenames table.
+** If there are no filenames, every target is checked again.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      line    String containing ".RESTAT" psuedo-target
+**              to be parsed.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+do_restat(line)
+        char    *line;
+{
+        int     i = 0;                  /* Line position index. */
+        int     j;                      /* Loop index. */
+        char    rstname[MAXPATH];       /* Restat filename. */
+
+        if (strncmp(line, ".RESTAT", 7) != 0)
+        {
+                /*
+                ** Line isn't a ".RESTAT" line.
+                ** This should never happen, since the primary
+                ** input dispatching code calls us.
+                */
+                return 0;
+        }
+
+        /* Skip the psuedo-target name. */
+        while (line[i] != '\0' &&
+                line[i] != ' ' &&
+                line[i] != '\t')
+        {
+                i++;
+        }
+
+        /* Skip leading whitespace. */
+        while (line[i] == ' ' || line[i] == '\t')
+                i++;
+
+        /* No filenames means all targets. */
+        if (line[i] == '\0')
+        {
+                restat_all = 1;
+                return 1;
+        }
+
+        /* Extract each filename from input line. */
+        while (line[i] != '\0')
+        {
+                /* Extract next filename from input line. */
+                j = 0;
+                while (line[i] != ' ' && line[i] != '\t' &&
+                        line[i] != '\0' && j < MAXPATH - 1)
+                {
+                        rstname[j++] = line[i++];
+                }
+                rstname[j] = '\0';
+                if (line[i] != ' ' && line[i] != '\t' &&
+                        line[i] != '\0')
+                {
+                        /* Error in ".RESTAT:" */
+                        errmsg(MSG_ERR_PATHTOOLONG, line, NOVAL);
+                        return 0;
+                }
+
+                /* Add the filename to the restat filenames table. */
+                if (!add_restat(rstname))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+
+                /* Skip whitespace before next filename. */
+                while (line[i] == ' ' || line[i] == '\t')
+                        i++;
+        } /* End while() */
+
+        /* Success! */
+        return 1;
+}
+
+/*
+** is_restat:
+** Determines if the specified target is to be checked
+** again after its commands have been run.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Target is to be checked again.
+**      0       Target is not to be checked again.
+*/
+int
+is_restat(tname)
+        char    *tname;
+{
+        char    lname[MAXPATH];
+
+        if (restat_all)
+                return 1;
+        if (restat_count == 0)
+                return 0;
+
+        strncpy(lname, tname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+        return find_restat(lname, hash_name(lname)) != (RESTAT *)NULL;
+}
+
+/*
+** begin_restat:
+** Remembers the time/date stamp and contents of a target
+** whose commands are about to be run, if the target is to
+** be checked again afterward.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      otime   Pointer to value to receive target's time/date stamp.
+**      ocrc    Pointer to value to receive digest of target.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Target is to be checked by end_restat().
+**      0       Target is not to be checked.
+*/
+int
+begin_restat(tname, otime, ocrc)
+        char            *tname;
+        time_t          *otime;
+        unsigned long   *ocrc;
+{
+        struct mstat_t  tstat;
+
+        if (CHKFLAG(FLAG_NOSPAWN | FLAG_TOUCH) || !is_restat(tname) ||
+                is_phony(tname))
+        {
+                return 0;
+        }
+
+        /* A target that doesn't exist yet can't stay the same. */
+        if (mstat(tname, &tstat) != 0)
+                return 0;
+        if (!file_digest(tname, ocrc))
+                return 0;
+        *otime = tstat.st_mtime;
+
+        return 1;
+}
+
+/*
+** end_restat:
+** Checks a target again after its commands have been run.
+** If its contents didn't change, the time they last changed
+** is recorded, so that the targets that depend on it aren't
+** rebuilt.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      tname   Name of target.
+**      otime   Time/date stamp from begin_restat().
+**      ocrc    Digest from begin_restat().
+**
+** Returns:
+**      NONE
+*/
+void
+end_restat(tname, otime, ocrc)
+        char            *tname;
+        time_t          otime;
+        unsigned long   ocrc;
+{
+        struct mstat_t  tstat;
+        unsigned long   crc;
+
+        if (mstat(tname, &tstat) != 0)
+                return;
+
+        /* Nothing to do if the commands didn't touch the target. */
+        if (tstat.st_mtime == otime)
+                return;
+
+        if (!file_digest(tname, &crc) || crc != ocrc)
+        {
+                mark_changed(tname);
+                return;
+        }
+
+        mark_unchanged(tname, otime, tstat.st_mtime);
+        if (CHKFLAG(FLAG_DEBUG))
+        {
+                mputs(MSG_DBG_RESTAT);
+                mputs(tname);
+                mputs("\n");
+        }
+}
+
+/*
+** uses_restat:
+** Determines if the makefile has any ".RESTAT" psuedo-targets,
+** in which case the digest database is needed.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Some targets are to be checked again.
+**      0       No targets are to be checked again.
+*/
+int
+uses_restat(void)
+{
+        return restat_all || restat_count != 0;
+}
+
+/*
+** dump_restat:
+** Outputs the contents of the restat filenames table.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_restat(void)
+{
+        RESTAT  *rptr;
+        int     i;
+
+        mputs(MSG_INFO_RESTAT);
+        if (restat_all)
+        {
+                mputs(MSG_INFO_RESTATALL);
+                return;
+        }
+        if (restat_count == 0)
+        {
+                mputs(MSG_INFO_NORESTAT);
+                return;
+        }
+        for (i = 0; i < RESTAT_HASH_SIZE; i++)
+        {
+                for (rptr = restat_table[i]; rptr != (RESTAT *)NULL;
+                        rptr = rptr->rnext)
+                {
+                        mputs(MSG_INFO_SHOWRESTAT);
+                        mputs(rptr->rname);
+                        mputs("\n");
+                }
+        }
+}
+
+/*
+** save_restat:
+** Writes the restat filenames table to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_restat(void)
+{
+        RESTAT  *rptr;
+        int     i;
+
+        if (!put_snap_word(restat_all) || !put_snap_word(restat_count))
+                return 0;
+        for (i = 0; i < RESTAT_HASH_SIZE; i++)
+        {
+                for (rptr = restat_table[i]; rptr != (RESTAT *)NULL;
+                        rptr = rptr->rnext)
+                {
+                        if (!put_snap_str(rptr->rname))
+                                return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** load_restat:
+** Loads the restat filenames table from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_restat(void)
+{
+        unsigned int    count;
+        char            *fname;
+
+        flush_restat();
+        restat_all = get_snap_word();
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                fname = get_snap_str();
+                if (fname != (char *)NULL && !add_restat(fname))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
@@ -18,6 +18,21 @@ makefile into the rule list used internally by the make utility.
 Only the parsing and list management is handled here; the matching
 of rules to files during the build process is handled elsewhere.
 
+Rule index:
+
+To find a rule for an undescribed target, find_rule() needs the rules
+whose destination suffix is the target's suffix, in the order of
+their source suffixes in the ".SUFFIXES" list.  Working that out
+from the rule list and the suffixes list each time takes a pass over
+the suffixes list with a pass over the rule list for each suffix.
+Instead, find_rules() keeps an index:  a hash table with one RULESET
+for each destination suffix, holding the array of its rules in
+".SUFFIXES" order.  The index is built all at once the first time
+it is needed, and is forgotten whenever the rule list or the
+suffixes list changes, so it is built again on the next lookup.
+The index is kept in an arena of its own, so it can be thrown away
+in one step.
+
 ======================================================================
 */
 
@@ -37,11 +52,150 @@ of rules to files during the build process is handled elsewhere.
 
 #include "make.h"
 
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static RULESET  *find_ruleset(char *dest, unsigned int hash);
+static int      build_rule_index(void);
+
+/****************************** CONSTANTS ***************************/
+
+/* Number of hash buckets in the rule index. */
+#define RULESET_HASH_SIZE 32
+
 /****************************** VARIABLES ***************************/
 
 /* Linked list of defined rules. */
 static RULE *rule_list;
 
+/* Memory for rule descriptors and their suffixes. */
+static ARENA rule_arena;
+
+/* Hash table of rules by destination suffix (see NOTES). */
+static RULESET *ruleset_table[RULESET_HASH_SIZE];
+
+/* Memory for the rule index. */
+static ARENA index_arena;
+
+/* Nonzero if ruleset_table is up to date. */
+static int rule_index_ok;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** find_ruleset:
+** Searches the rule index for a destination suffix.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dest    Destination suffix to search for.
+**      hash    hash_name() value of dest.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Suffix is not in the index.
+**      other   Pointer to suffix's rule set.
+*/
+static RULESET *
+find_ruleset(dest, hash)
+        char            *dest;
+        unsigned int    hash;
+{
+        RULESET *set;
+
+        set = ruleset_table[hash % RULESET_HASH_SIZE];
+        while (set != (RULESET *)NULL)
+        {
+                if (set->shash == hash && strcmp(set->sdest, dest) == 0)
+                        return set;
+                set = set->snext;
+        }
+
+        return (RULESET *)NULL;
+}
+
+/*
+** build_rule_index:
+** Builds the rule index from the rule list and the suffixes
+** list, replacing any old index.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+static int
+build_rule_index(void)
+{
+        RULE            *rptr;          /* Rule whose suffix is indexed. */
+        RULE            *rul;           /* Rule for one source suffix. */
+        RULESET         *set;
+        char            *suffix;
+        unsigned int    hash;
+        int             nsuffixes;      /* Length of suffixes list. */
+        int             i;
+        int             n;              /* Number of rules in set. */
+        int             j;
+
+        arena_release(&index_arena);
+        for (i = 0; i < RULESET_HASH_SIZE; i++)
+                ruleset_table[i] = (RULESET *)NULL;
+
+        nsuffixes = 0;
+        while (enum_suffix(nsuffixes) != (char *)NULL)
+                nsuffixes++;
+
+        for (rptr = rule_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+        {
+                hash = hash_name(rptr->rdest);
+                if (find_ruleset(rptr->rdest, hash) != (RULESET *)NULL)
+                        continue;
+
+                set = (RULESET *)arena_alloc(&index_arena, sizeof(RULESET));
+                if (set == (RULESET *)NULL)
+                        return 0;
+                set->srules = (RULE **)arena_alloc(&index_arena,
+                        (nsuffixes + 1) * sizeof(RULE *));
+                if (set->srules == (RULE **)NULL)
+                        return 0;
+                set->sdest = rptr->rdest;
+                set->shash = hash;
+
+                /*
+                ** Collect the rule for each source suffix, in the
+                ** order of the suffixes list, skipping the
+                ** destination suffix itself and any suffix that
+                ** is listed more than once.
+                */
+                n = 0;
+                for (i = 0; (suffix = enum_suffix(i)) != (char *)NULL; i++)
+                {
+                        if (strcmp(suffix, rptr->rdest) == 0)
+                                continue;
+                        rul = lookup_rule(suffix, rptr->rdest);
+                        if (rul == (RULE *)NULL)
+                                continue;
+                        for (j = 0; j < n && set->srules[j] != rul; j++)
+                                ;
+                        if (j == n)
+                                set->srules[n++] = rul;
+                }
+                set->srules[n] = (RULE *)NULL;
+
+                set->snext = ruleset_table[hash % RULESET_HASH_SIZE];
+                ruleset_table[hash % RULESET_HASH_SIZE] = set;
+        }
+
+        rule_index_ok = 1;
+        return 1;
+}
+
 /****************************** FUNCTIONS ***************************/
 
 /*
@@ -59,7 +213,10 @@ static RULE *rule_list;
 void
 init_rules(void)
 {
+        arena_init(&rule_arena, "rules");
+        arena_init(&index_arena, "rule index");
         rule_list = (RULE *)NULL;
+        forget_rule_index();
 }
 
 /*
@@ -75,29 +232,17 @@ init_rules(void)
 void
 flush_rules(void)
 {
-        RULE    *r;     /* Temporary rule descriptor pointers. */
-        RULE    *r2;
-
-        /* Free each entry in the rule list. */
-        r = rule_list;
-        while (r != (RULE *)NULL)
-        {
-                /* Free rule source. */
-                mem_free(r->rsrc);
-
-                /* Free rule dest. */
-                mem_free(r->rdest);
+        RULE    *r;     /* Temporary rule descriptor pointer. */
 
-                /* Free rule command lines. */
+        /* Free each rule's command lines. */
+        for (r = rule_list; r != (RULE *)NULL; r = r->rnext)
                 free_lines(r->rcommands);
 
-                /* Free rule descriptor. */
-                r2 = r->rnext;
-                mem_free(r);
-                r = r2;
-        }
+        /* Free the descriptors and suffixes all at once. */
+        arena_release(&rule_arena);
 
         rule_list = (RULE *)NULL;
+        forget_rule_index();
 }
 
 /*
@@ -128,7 +273,7 @@ define_rule(line, handle)
         char    rdest[MAX_SUFFIX_STR + 2];/* Dest file extension. */
         RULE    *rul;           /* Temporary rule descriptor pointer. */
         RULE    *rptr;          /* Temporary rule descriptor pointer. */
-        LINE    *ltmp;          /* Temporary line pointer. */
+        LIST    cmds;           /* Rule's command lines. */
 
         /* Check for starting dot. */
         pos = 0;
@@ -217,7 +362,7 @@ define_rule(line, handle)
         */
 
         /* Allocate memory for rule descriptor. */
-        rul = (RULE *)mem_alloc(sizeof(RULE));
+        rul = (RULE *)arena_alloc(&rule_arena, sizeof(RULE));
         if (rul == (RULE *)NULL)
         {
                 /* Out of memory for rule definition. */
@@ -226,34 +371,26 @@ define_rule(line, handle)
         }
         rul->rnext = (RULE *)NULL;
 
-        /* Allocate memory for rule dest extension. */
-        rul->rdest = (char *)mem_alloc(strlen(rdest) + 1);
+        /* Save dest extension in rule descriptor. */
+        rul->rdest = arena_strdup(&rule_arena, rdest);
         if (rul->rdest == (char *)NULL)
         {
                 /* Out of memory for rule name. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(rul);
                 return 0;
         }
 
-        /* Save dest extension in rule descriptor. */
-        strcpy(rul->rdest, rdest);
-
-        /* Allocate memory for rule source extension. */
-        rul->rsrc = (char *)mem_alloc(strlen(rsrc) + 1);
+        /* Save source extension in rule descriptor. */
+        rul->rsrc = arena_strdup(&rule_arena, rsrc);
         if (rul->rsrc == (char *)NULL)
         {
                 /* Out of memory for rule name. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(rul->rdest);
-                mem_free(rul);
                 return 0;
         }
 
-        /* Save source extension in rule descriptor. */
-        strcpy(rul->rsrc, rsrc);
-
         /* Assume rule has no commands. */
+        rul->rpattern = 0;
         rul->rcommands = (LINE *)NULL;
 
         if (rule_list == (RULE *)NULL)
@@ -268,10 +405,12 @@ define_rule(line, handle)
                 rule_list = rul;
                 rul->rnext = rptr;
         }
+        forget_rule_index();
 
         /*
         ** Get the command lines for the rule.
         */
+        init_list(&cmds);
         while (1)
         {
                 result = read_logical_line(handle, inpline, MAXLLINE);
@@ -319,14 +458,13 @@ define_rule(line, handle)
                         pos++;
 
                 /* Add line to rule. */
-                ltmp = append_line(rul->rcommands, &inpline[pos]);
-                if (ltmp == (LINE *)NULL)
+                if (!add_to_list(&cmds, &inpline[pos]))
                 {
                         /* Out of memory for rule data. */
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
                         return 0;
                 }
-                rul->rcommands = ltmp;
+                rul->rcommands = cmds.lhead;
         } /* End while(1) */
 
         return 1;
@@ -375,42 +513,58 @@ dump_rules(void)
 }
 
 /*
-** check_rules:
-** Checks to see if the rule list contains any rules for which
-** the destination extension is a particular extension.  This
-** is useful if the caller wishes to find out if there are any
-** rules that might be of interest before calling lookup_rule
-** repeatedly to match each possible suffix to.
+** find_rules:
+** Gets the rules that can build a file with a particular
+** suffix, in the order their source suffixes appear in the
+** suffixes list.  The rule index is built first if it isn't
+** up to date.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      suf     Suffix to check for in rule list.  The suffix
+**      dest    Suffix of file to be built.  The suffix
 **              should not have a leading '.'.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       The rule list contains at least one rule for which
-**              the destination suffix is the specified suffix.
-**      0       The rule list doesn't contain any rules for which
-**              the destination suffix is the specified suffix.
+**      NULL    No rules can build the file, or out of memory.
+**      other   Pointer to array of rules, ending with NULL.
 */
-int
-check_rules(suf)
-        char    *suf;
+RULE **
+find_rules(dest)
+        char    *dest;
 {
-        RULE    *rptr;
+        RULESET *set;
 
-        rptr = rule_list;
-        while (rptr != (RULE *)NULL)
+        if (!rule_index_ok && !build_rule_index())
         {
-                if (strcmp(rptr->rdest, suf) == 0)
-                        return 1;
-                rptr = rptr->rnext;
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return (RULE **)NULL;
         }
 
-        return 0;
+        set = find_ruleset(dest, hash_name(dest));
+        if (set == (RULESET *)NULL || set->srules[0] == (RULE *)NULL)
+                return (RULE **)NULL;
+
+        return set->srules;
+}
+
+/*
+** forget_rule_index:
+** Marks the rule index as out of date.  This must be called
+** whenever the rule list or the suffixes list changes.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+forget_rule_index(void)
+{
+        rule_index_ok = 0;
 }
 
 /*
@@ -466,3 +620,198 @@ lookup_rule(src, dest)
         return (RULE *)NULL;
 }
 
+/*
+** rule_source:
+** Builds the name of the source file that a rule would use
+** to build a particular target file.  For a suffix rule, the
+** target's suffix is replaced by the rule's source suffix.
+** For a pattern rule, the part of the target's name that
+** matches the '%' in the rule's target pattern (the stem)
+** is put in place of the '%' in the rule's source pattern.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      rul     Rule to be used.
+**      tname   Name of target file.
+**      srcname Buffer to return name of source file in.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Target's name doesn't fit the rule, or the
+**              source file's name would be too long.
+*/
+int
+rule_source(rul, tname, srcname)
+        RULE    *rul;
+        char    *tname;
+        char    *srcname;
+{
+        char    *pct;           /* Position of '%' in pattern. */
+        int     prelen;         /* Length of target pattern's prefix. */
+        int     stemlen;        /* Length of stem. */
+        int     i;
+
+        if (!rul->rpattern)
+        {
+                /* Replace the target's suffix. */
+                get_part_filename(5, tname, srcname);
+                strcat(srcname, ".");
+                strcat(srcname, rul->rsrc);
+                return 1;
+        }
+
+        /* Find the stem in the target's name. */
+        pct = strchr(rul->rdest, '%');
+        prelen = pct - rul->rdest;
+        stemlen = (int)strlen(tname) - (int)strlen(rul->rdest) + 1;
+        if (stemlen < 1 || (int)strlen(rul->rsrc) + stemlen > MAXPATH)
+                return 0;
+
+        /* Put the stem in place of the source pattern's '%'. */
+        for (i = 0; rul->rsrc[i] != '%'; i++)
+                srcname[i] = rul->rsrc[i];
+        strncpy(&srcname[i], &tname[prelen], stemlen);
+        strcpy(&srcname[i + stemlen], &rul->rsrc[i + 1]);
+
+        return 1;
+}
+
+/*
+** rule_name:
+** Builds the name of a rule, as it would appear in the
+** makefile, for messages to the user.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      rul     Rule to be named.
+**      name    Buffer to return name in (MAXPATH characters).
+**
+** Returns:
+**      NONE
+*/
+void
+rule_name(rul, name)
+        RULE    *rul;
+        char    *name;
+{
+        if (rul->rpattern)
+        {
+                /* Pattern rules are "dest: src". */
+                strcpy(name, rul->rdest);
+                strcat(name, ": ");
+                strcat(name, rul->rsrc);
+        }
+        else
+        {
+                /* Suffix rules are ".src.dest". */
+                strcpy(name, ".");
+                strcat(name, rul->rsrc);
+                strcat(name, ".");
+                strcat(name, rul->rdest);
+        }
+}
+
+/*
+** save_rules:
+** Writes the rule list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_rules(void)
+{
+        RULE            *rptr;
+        unsigned        count = 0;
+
+        for (rptr = rule_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (rptr = rule_list; rptr != (RULE *)NULL; rptr = rptr->rnext)
+        {
+                if (!put_snap_str(rptr->rsrc) ||
+                        !put_snap_str(rptr->rdest) ||
+                        !put_snap_lines(rptr->rcommands))
+                {
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** load_rules:
+** Loads the rule list from the snapshot.  The rule list
+** must be empty.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_rules(void)
+{
+        RULE            *rul;
+        RULE            *tail = (RULE *)NULL;
+        LIST            cmds;
+        unsigned        count;
+        char            *rsrc;
+        char            *rdest;
+
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                rsrc = get_snap_str();
+                rdest = get_snap_str();
+                if (rsrc == (char *)NULL)
+                        rsrc = "";
+                if (rdest == (char *)NULL)
+                        rdest = "";
+
+                /* Allocate and fill in rule descriptor. */
+                rul = (RULE *)arena_alloc(&rule_arena, sizeof(RULE));
+                if (rul == (RULE *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                rul->rnext = (RULE *)NULL;
+                rul->rpattern = 0;
+                rul->rsrc = arena_strdup(&rule_arena, rsrc);
+                rul->rdest = arena_strdup(&rule_arena, rdest);
+                if (rul->rsrc == (char *)NULL || rul->rdest == (char *)NULL ||
+                        !get_snap_lines(&cmds))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                rul->rcommands = cmds.lhead;
+
+                /* Keep the rules in the same order as when saved. */
+                if (tail == (RULE *)NULL)
+                        rule_list = rul;
+                else
+                        tail->rnext = rul;
+                tail = rul;
+        }
+        forget_rule_index();
+
+        return 1;
+}
@@ -0,0 +1,686 @@
+/*
+======================================================================
+makesnap.c
+Parsed makefile snapshot routines for make utility.
+
+This source file is part of a computer program that is
+(C) Copyright 1988 Ammon R. Campbell.  All rights reserved.
+
+This source file contains trade secrets of the author and
+may not be disclosed without the express written consent
+of the author.
+======================================================================
+
+NOTES
+
+When the '-m' option is given, make saves the tables it builds
+from the makefile and the initialization file (the macros,
+suffixes, rules, pattern rules, targets, precious filenames,
+restat filenames, and phony targets) in the file 'make.snp' in
+the same directory as the makefile.  The next time make is run,
+if nothing that went into those tables has changed, the tables
+are loaded from the snapshot with a single read, instead of
+reading and parsing the makefile.
+
+The snapshot is only used if its key matches.  The key is a digest
+of the names, time/date stamps, and sizes of the makefile and the
+initialization file, the options and macro definitions given on
+the command line, the current directory, and all of the
+environment strings, since any of them may have been used while
+parsing.  The names of the files read by "!INCLUDE" aren't known
+until the makefile has been parsed, so they are saved in the
+snapshot, along with a digest of the name, time/date stamp, and
+size of each, and are checked after the key.  The makefile is read
+as usual if anything has changed.
+
+Each module saves and loads its own table with the put_snap_xxx()
+and get_snap_xxx() functions here.  Numbers are saved as 16-bit
+words, low byte first.  Strings are saved as a word giving their
+length plus one (zero for a NULL pointer), followed by the
+characters and a null.  Lists of lines are saved as a word giving
+the number of lines, followed by the lines as strings.  The file
+begins with a header word and the key, and ends with the CRC-32
+of everything before it.
+
+The whole snapshot has to fit in one memory block, so makefiles
+that produce very large snapshots are simply parsed every time.
+
+======================================================================
+*/
+
+/****************************** INCLUDES ****************************/
+
+#ifdef WIN
+# include <windows.h>
+#endif /* WIN */
+#include <stdio.h>
+#include <stdlib.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys\types.h>
+#include <sys\stat.h>
+#include <dos.h>
+#include <string.h>
+#include <direct.h>
+
+#include "make.h"
+
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static unsigned long    key_file(unsigned long crc, char *fname);
+static int              put_snap(char *p, unsigned n);
+static int              get_snap(unsigned n);
+static int              put_snap_includes(void);
+static int              check_snap_includes(void);
+
+/****************************** CONSTANTS ***************************/
+
+/* First word of a snapshot file; change when the format changes. */
+#define SNAP_MAGIC      0x5351U
+
+/* Size of buffer for writing the snapshot. */
+#define SNAP_IOSIZE     1024
+
+/* Largest snapshot that will be loaded. */
+#define SNAP_MAXSIZE    65000L
+
+/****************************** VARIABLES ***************************/
+
+/* snap_fh:  Handle of snapshot file being written. */
+static int snap_fh;
+
+/* snap_crc:  CRC-32 of data written so far. */
+static unsigned long snap_crc;
+
+/* snap_iobfr:  Buffer for writing the snapshot. */
+static char snap_iobfr[SNAP_IOSIZE];
+
+/* snap_iopos:  Number of bytes waiting in snap_iobfr to be written. */
+static int snap_iopos;
+
+/* snap_data:  Contents of snapshot being loaded. */
+static char *snap_data;
+
+/* snap_size:  Number of bytes in snap_data. */
+static unsigned snap_size;
+
+/* snap_pos:  Position of next byte to load from snap_data. */
+static unsigned snap_pos;
+
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** key_file:
+** Adds the name, time/date stamp, and size of a file to a
+** snapshot key.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      crc     Key so far.
+**      fname   Name of file (NULL if none).
+**
+** Returns:
+**      New value of key.
+*/
+static unsigned long
+key_file(crc, fname)
+        unsigned long   crc;
+        char            *fname;
+{
+        struct mstat_t  fstat;
+
+        if (fname == (char *)NULL)
+                return crc_long(crc, 0L);
+
+        crc = crc_block(crc, fname, strlen(fname) + 1);
+        if (mstat(fname, &fstat) != 0)
+                return crc_long(crc, 0L);
+        crc = crc_long(crc, (unsigned long)fstat.st_mtime);
+        return crc_long(crc, fstat.st_size);
+}
+
+/*
+** put_snap:
+** Adds bytes to the snapshot file being written.  Passing
+** NULL writes out whatever is left in the buffer.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      p       Pointer to bytes to write, or NULL.
+**      n       Number of bytes to write.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+put_snap(p, n)
+        char            *p;
+        unsigned        n;
+{
+        if (p != (char *)NULL)
+                snap_crc = crc_block(snap_crc, p, n);
+
+        while (p == (char *)NULL || n > 0)
+        {
+                if (p == (char *)NULL || snap_iopos >= SNAP_IOSIZE)
+                {
+                        if (mwrite(snap_fh, snap_iobfr, snap_iopos) !=
+                                snap_iopos)
+                        {
+                                return 0;
+                        }
+                        snap_iopos = 0;
+                        if (p == (char *)NULL)
+                                break;
+                }
+                snap_iobfr[snap_iopos++] = *p++;
+                n--;
+        }
+
+        return 1;
+}
+
+/*
+** get_snap:
+** Checks that a number of bytes remain to be loaded from
+** the snapshot.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      n       Number of bytes needed.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Bytes are available.
+**      0       Snapshot is too short.
+*/
+static int
+get_snap(n)
+        unsigned        n;
+{
+        return snap_data != (char *)NULL && n <= snap_size - snap_pos;
+}
+
+/*
+** put_snap_includes:
+** Writes the names of the files read by "!INCLUDE" to the
+** snapshot file, each followed by its digest from key_file().
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+put_snap_includes(void)
+{
+        unsigned        count = 0;
+        char            *iname;
+
+        while (enum_include(count) != (char *)NULL)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (count = 0; (iname = enum_include(count)) != (char *)NULL;
+                count++)
+        {
+                if (!put_snap_str(iname) ||
+                        !put_snap_long(key_file(0xFFFFFFFFL, iname)))
+                {
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** check_snap_includes:
+** Checks that none of the files read by "!INCLUDE" have
+** changed since the snapshot was saved.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Included files are unchanged.
+**      0       An included file has changed.
+*/
+static int
+check_snap_includes(void)
+{
+        unsigned        count;
+        char            *iname;
+
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                iname = get_snap_str();
+                if (iname == (char *)NULL ||
+                        key_file(0xFFFFFFFFL, iname) != get_snap_long())
+                {
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/****************************** FUNCTIONS ***************************/
+
+/*
+** snapshot_key:
+** Computes the key that a snapshot must match to be used.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      argc    Number of command line arguments.
+**      argv    Command line arguments.
+**      envp    Environment strings.
+**      mfname  Name of makefile.
+**      ifname  Name of initialization file (NULL if none).
+**
+** Returns:
+**      Key value.
+*/
+unsigned long
+snapshot_key(argc, argv, envp, mfname, ifname)
+        int     argc;
+        char    *argv[];
+        char    *envp[];
+        char    *mfname;
+        char    *ifname;
+{
+        unsigned long   crc = 0xFFFFFFFFL;
+        char            tmp[MAXPATH];
+        int             i;
+
+        crc = key_file(crc, mfname);
+        crc = key_file(crc, ifname);
+
+        /*
+        ** The program name (predefined as MAKE), the options, and
+        ** macro definitions, but not target names.
+        */
+        crc = crc_block(crc, argv[0], strlen(argv[0]) + 1);
+        for (i = 1; i < argc; i++)
+        {
+                if (argv[i][0] == '-' || cindex(argv[i], '=') >= 0)
+                        crc = crc_block(crc, argv[i], strlen(argv[i]) + 1);
+        }
+
+        /* The current directory is predefined as MAKEDIR. */
+        getcwd(tmp, MAXPATH - 1);
+        crc = crc_block(crc, tmp, strlen(tmp) + 1);
+
+        for (i = 0; envp[i] != (char *)NULL; i++)
+                crc = crc_block(crc, envp[i], strlen(envp[i]) + 1);
+
+        return crc;
+}
+
+/*
+** load_snapshot:
+** Loads the tables from a snapshot file, if it exists and
+** its key matches.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      sname   Name of snapshot file.
+**      key     Key computed by snapshot_key().
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Tables were loaded.
+**      0       Snapshot can't be used; nothing was loaded.
+**      -1      Fatal error occurred while loading.
+*/
+int
+load_snapshot(sname, key)
+        char            *sname;
+        unsigned long   key;
+{
+        struct mstat_t  sstat;
+        unsigned long   crc;
+        int             fh;
+        int             ok;
+
+        if (mstat(sname, &sstat) != 0 || sstat.st_size < 10L ||
+                sstat.st_size > SNAP_MAXSIZE)
+        {
+                return 0;
+        }
+        snap_size = (unsigned)sstat.st_size;
+
+        /* Read the whole file at once. */
+        snap_data = (char *)mem_alloc(snap_size);
+        if (snap_data == (char *)NULL)
+                return 0;
+        fh = mopen_r(sname);
+        ok = fh != -1 && mread(fh, snap_data, snap_size) == (int)snap_size;
+        if (fh != -1)
+                mclose(fh);
+
+        /* Check the trailing CRC, the header, and the key. */
+        snap_pos = 0;
+        if (ok)
+        {
+                snap_size -= 4;
+                crc = crc_block(0xFFFFFFFFL, snap_data, snap_size);
+                snap_pos = snap_size;
+                ok = get_snap_long() == crc;
+                snap_size += 4;
+                snap_pos = 0;
+        }
+        ok = ok && get_snap_word() == SNAP_MAGIC && get_snap_long() == key &&
+                check_snap_includes();
+        if (!ok)
+        {
+                mem_free(snap_data);
+                snap_data = (char *)NULL;
+                return 0;
+        }
+
+        /* Load each table. */
+        makeflags |= get_snap_word();
+        ok = load_macros() && load_suffixes() && load_rules() &&
+                load_patterns() && load_targets() && load_precious() &&
+                load_restat() && load_phony();
+
+        mem_free(snap_data);
+        snap_data = (char *)NULL;
+        return ok ? 1 : -1;
+}
+
+/*
+** save_snapshot:
+** Saves the tables to a snapshot file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      sname   Name of snapshot file.
+**      key     Key computed by snapshot_key().
+**      pflags  Flags that were set while parsing the makefile.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_snapshot(sname, key, pflags)
+        char            *sname;
+        unsigned long   key;
+        unsigned int    pflags;
+{
+        int     ok;
+
+        snap_fh = mcreat(sname);
+        if (snap_fh == -1)
+        {
+                errmsg(MSG_ERR_CANTCREATE, sname, NOVAL);
+                return 0;
+        }
+        snap_crc = 0xFFFFFFFFL;
+        snap_iopos = 0;
+
+        ok = put_snap_word(SNAP_MAGIC) && put_snap_long(key) &&
+                put_snap_includes() && put_snap_word(pflags) &&
+                save_macros() && save_suffixes() && save_rules() &&
+                save_patterns() && save_targets() && save_precious() &&
+                save_restat() && save_phony() &&
+                put_snap_long(snap_crc) && put_snap((char *)NULL, 0);
+
+        if (mclose(snap_fh) == -1)
+                ok = 0;
+        if (!ok)
+        {
+                errmsg(MSG_ERR_IOWRITE, sname, NOVAL);
+                unlink(sname);
+                return 0;
+        }
+
+        return 1;
+}
+
+/*
+** put_snap_word:
+** Writes a word to the snapshot file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      val     Value to write.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+put_snap_word(val)
+        unsigned        val;
+{
+        char    b[2];
+
+        b[0] = (char)(val & 0xFF);
+        b[1] = (char)((val >> 8) & 0xFF);
+        return put_snap(b, 2);
+}
+
+/*
+** put_snap_long:
+** Writes a long value to the snapshot file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      val     Value to write.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+put_snap_long(val)
+        unsigned long   val;
+{
+        return put_snap_word((unsigned)(val & 0xFFFFL)) &&
+                put_snap_word((unsigned)((val >> 16) & 0xFFFFL));
+}
+
+/*
+** put_snap_str:
+** Writes a string to the snapshot file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      s       String to write (may be NULL).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+put_snap_str(s)
+        char    *s;
+{
+        unsigned        len;
+
+        if (s == (char *)NULL)
+                return put_snap_word(0);
+
+        len = strlen(s) + 1;
+        return put_snap_word(len) && put_snap(s, len);
+}
+
+/*
+** put_snap_lines:
+** Writes a list of lines to the snapshot file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      lptr    First line in list (may be NULL).
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+put_snap_lines(lptr)
+        LINE    *lptr;
+{
+        LINE            *l;
+        unsigned        count = 0;
+
+        for (l = lptr; l != (LINE *)NULL; l = l->lnext)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (l = lptr; l != (LINE *)NULL; l = l->lnext)
+        {
+                if (!put_snap_str(l->ldata))
+                        return 0;
+        }
+
+        return 1;
+}
+
+/*
+** get_snap_word:
+** Loads a word from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value loaded (zero if the snapshot is too short).
+*/
+unsigned
+get_snap_word(void)
+{
+        unsigned        val;
+
+        if (!get_snap(2))
+                return 0;
+        val = (unsigned char)snap_data[snap_pos] |
+                ((unsigned)(unsigned char)snap_data[snap_pos + 1] << 8);
+        snap_pos += 2;
+
+        return val;
+}
+
+/*
+** get_snap_long:
+** Loads a long value from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value loaded (zero if the snapshot is too short).
+*/
+unsigned long
+get_snap_long(void)
+{
+        unsigned long   val;
+
+        val = (unsigned long)get_snap_word();
+        return val | ((unsigned long)get_snap_word() << 16);
+}
+
+/*
+** get_snap_str:
+** Loads a string from the snapshot.  The string is left in
+** the snapshot's memory, so the caller must copy it.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Pointer to string (NULL if a NULL pointer was saved, or
+**      "" if the snapshot is too short).
+*/
+char *
+get_snap_str(void)
+{
+        unsigned        len;
+        char            *s;
+
+        len = get_snap_word();
+        if (len == 0)
+                return (char *)NULL;
+        if (!get_snap(len))
+                return "";
+        s = &snap_data[snap_pos];
+        snap_pos += len;
+
+        return s;
+}
+
+/*
+** get_snap_lines:
+** Loads a list of lines from the snapshot.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      list    Pointer to list to receive the lines, which
+**              should be empty.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+get_snap_lines(list)
+        LIST    *list;
+{
+        unsigned        count;
+        char            *s;
+
+        init_list(list);
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                s = get_snap_str();
+                if (!add_to_list(list, s == (char *)NULL ? "" : s))
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        flush_list(list);
+                        return 0;
+                }
+        }
+
+        return 1;
+}
@@ -54,7 +54,15 @@ line contains one filename suffix.
 /****************************** VARIABLES ***************************/
 
 /* suffixes_list:  Linked list of suffix (file extension) names. */
-static LINE *suffixes_list;
+static LIST suffixes_list;
+
+/*
+** suffix_cursor:  Line last returned by enum_suffix(), and its index,
+** so the list can be enumerated in order without starting over at
+** the head each time.
+*/
+static LINE *suffix_cursor;
+static int suffix_cursor_index;
 
 /****************************** FUNCTIONS ***************************/
 
@@ -73,7 +81,9 @@ static LINE *suffixes_list;
 void
 init_suffixes(void)
 {
-        suffixes_list = (LINE *)NULL;
+        init_list(&suffixes_list);
+        suffix_cursor = (LINE *)NULL;
+        forget_rule_index();
 }
 
 /*
@@ -93,8 +103,9 @@ init_suffixes(void)
 void
 flush_suffixes(void)
 {
-        free_lines(suffixes_list);
-        suffixes_list = (LINE *)NULL;
+        flush_list(&suffixes_list);
+        suffix_cursor = (LINE *)NULL;
+        forget_rule_index();
 }
 
 /*
@@ -124,7 +135,6 @@ do_suffixes(line)
         int     j;
         int     num_suffixes;
         char    suffix[MAX_SUFFIX_STR + 2];
-        LINE    *tmp;
 
         /* Skip the psuedo-target name. */
         while (line[i] != '\0' &&
@@ -170,17 +180,14 @@ do_suffixes(line)
                 }
 
                 /* Add the suffix to the suffixes list. */
-                if (suffix[0] == '.')
-                        tmp = append_line(suffixes_list, &suffix[1]);
-                else
-                        tmp = append_line(suffixes_list, suffix);
-                if (tmp == (LINE *)NULL)
+                if (!add_to_list(&suffixes_list,
+                        (suffix[0] == '.') ? &suffix[1] : suffix))
                 {
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
                         return 0;
                 }
-                suffixes_list = tmp;
                 num_suffixes++;
+                forget_rule_index();
 
                 /* Skip whitespace before next suffix. */
                 while (line[i] == ' ' || line[i] == '\t')
@@ -223,8 +230,16 @@ enum_suffix(index)
         LINE    *lptr;
         int     i = 0;
 
-        /* Start at head of suffixes list. */
-        lptr = suffixes_list;
+        /*
+        ** Start where the last call left off if we can, otherwise
+        ** at head of suffixes list.
+        */
+        lptr = suffixes_list.lhead;
+        if (suffix_cursor != (LINE *)NULL && suffix_cursor_index <= index)
+        {
+                lptr = suffix_cursor;
+                i = suffix_cursor_index;
+        }
 
         /*
         ** Step through suffixes until we get to the one
@@ -243,6 +258,8 @@ enum_suffix(index)
         }
 
         /* Return pointer to suffix name. */
+        suffix_cursor = lptr;
+        suffix_cursor_index = index;
         return (char *)lptr->ldata;
 }
 
@@ -262,7 +279,7 @@ dump_suffixes(void)
         LINE    *lptr;
 
         mputs(MSG_INFO_SUFFIXES);
-        lptr = suffixes_list;
+        lptr = suffixes_list.lhead;
         if (lptr == (LINE *)NULL)
         {
                 mputs(MSG_INFO_NOSUFFIXES);
@@ -277,3 +294,41 @@ dump_suffixes(void)
         }
 }
 
+/*
+** save_suffixes:
+** Writes the suffixes list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_suffixes(void)
+{
+        return put_snap_lines(suffixes_list.lhead);
+}
+
+/*
+** load_suffixes:
+** Loads the suffixes list from the snapshot.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Out of memory.
+*/
+int
+load_suffixes(void)
+{
+        flush_suffixes();
+        return get_snap_lines(&suffixes_list);
+}
@@ -19,6 +19,17 @@ the make utility.  Only the parsing and list management is done
 here; the actual testing and building of targets is done
 elsewhere.
 
+The targets are kept in a linked list in the order they were
+defined in the makefile, since the first target is the default
+target.  To find a target by name quickly, the targets are also
+placed in an open-addressed hash table, which is searched using the
+hash value stored in each target descriptor.  The hash table is
+doubled in size whenever it becomes half full.
+
+The target descriptors, their names, their dependent lines, and
+their expanded dependents are allocated from an arena, since they
+are all kept until flush_targets() frees the whole target list.
+
 ======================================================================
 */
 
@@ -41,55 +52,97 @@ elsewhere.
 /****************************** HEADERS *****************************/
 
 /* Prototypes of functions local to this module: */
-#ifdef BT_TARGETS
-void    free_target_tree(TARGET *t);
-#endif /* BT_TARGETS */
+static int      grow_target_index(void);
 static TARGET   *dup_target(TARGET *tar, char *tname);
 static int      add_target(TARGET *tar);
 
+/****************************** CONSTANTS ***************************/
+
+/* Initial number of slots in the target hash table (power of two). */
+#define TINDEX_MIN      64
+
+/* Largest number of slots allowed in the target hash table. */
+#define TINDEX_MAX      16384
+
 /****************************** VARIABLES ***************************/
 
 /* target_list:  Linked list of defined targets. */
 static TARGET *target_list;
 
+/* target_tail:  Last target in the target list. */
+static TARGET *target_tail;
+
+/* target_index:  Hash table of pointers to the defined targets. */
+static TARGET **target_index;
+
+/* tindex_size:  Number of slots in the target hash table. */
+static unsigned int tindex_size;
+
+/* tindex_count:  Number of targets in the target hash table. */
+static unsigned int tindex_count;
+
+/* target_arena:  Memory for target descriptors and their names. */
+static ARENA target_arena;
+
 /*************************** LOCAL FUNCTIONS ************************/
 
-#ifdef BT_TARGETS
 /*
-** free_target_tree:
-** Frees a binary tree of target nodes.
+** grow_target_index:
+** Doubles the size of the target hash table, or creates it if
+** it doesn't exist yet.
 **
 ** Parameters:
-**      Name    Description
-**      ----    -----------
-**      t       Pointer to tree to be freed.
+**      NONE
 **
 ** Returns:
-**      NONE
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Not enough memory, or table is already at its
+**              maximum size.
 */
-void
-free_target_tree(t)
-        TARGET  *t;
+static int
+grow_target_index(void)
 {
-        /* Check if this is the end of a branch. */
-        if (t == (TARGET *)NULL)
-                return;
-
-        /* Free children first. */
-        free_target_tree(t->tleft);
-        free_target_tree(t->tright);
-
-        /* Free strings. */
-        mem_free(t->tname);
-        if (t->tdependents != (char *)NULL)
-                mem_free(t->tdependents);
-        if (t->tcommands != (LINE *)NULL)
-                free_lines(t->tcommands);
-
-        /* Free the target descriptor structure. */
-        mem_free(t);
+        TARGET          **newindex;
+        unsigned int    newsize;
+        unsigned int    i;
+        unsigned int    slot;
+
+        /* Determine new size of table. */
+        if (tindex_size == 0)
+                newsize = TINDEX_MIN;
+        else if (tindex_size < TINDEX_MAX)
+                newsize = tindex_size * 2;
+        else
+                return 0;
+
+        /* Allocate memory for the new table and clear it. */
+        newindex = (TARGET **)mem_alloc(newsize * sizeof(TARGET *));
+        if (newindex == (TARGET **)NULL)
+                return 0;
+        for (i = 0; i < newsize; i++)
+                newindex[i] = (TARGET *)NULL;
+
+        /* Move the targets from the old table into the new one. */
+        for (i = 0; i < tindex_size; i++)
+        {
+                if (target_index[i] != (TARGET *)NULL)
+                {
+                        slot = target_index[i]->thash & (newsize - 1);
+                        while (newindex[slot] != (TARGET *)NULL)
+                                slot = (slot + 1) & (newsize - 1);
+                        newindex[slot] = target_index[i];
+                }
+        }
+
+        if (target_index != (TARGET **)NULL)
+                mem_free(target_index);
+        target_index = newindex;
+        tindex_size = newsize;
+
+        return 1;
 }
-#endif /* BT_TARGETS */
 
 /*
 ** add_target:
@@ -111,82 +164,42 @@ add_target(tar)
         TARGET  *tar;
 {
         TARGET  *tptr;
-        int     comparison;
+        unsigned int slot;
 
-        if (target_list == (TARGET *)NULL)
+        /* Make sure there is room in the hash table. */
+        if ((tindex_count + 1) * 2 > tindex_size)
         {
-                /* This is the first entry in the targets list. */
-                target_list = tar;
-#ifdef BT_TARGETS
-                target_list->tleft = (TARGET *)NULL;
-                target_list->tright = (TARGET *)NULL;
-#else
-                target_list->tnext = (TARGET *)NULL;
-#endif /* BT_TARGETS */
-        }
-        else
-        {
-#ifdef BT_TARGETS
-                /*
-                ** This is not the first entry; find the appropriate
-                ** leaf on the tree to add the new entry.
-                */
-                tptr = target_list;
-                while (1)
+                if (!grow_target_index() && tindex_count + 1 >= tindex_size)
                 {
-                        comparison = strcmp(tar->tname, tptr->tname);
-                        if (comparison == 0)
-                        {
-                                /* Same target is already defined. */
-                                errmsg(MSG_ERR_SAMETARGET, tar->tname, NOVAL);
-                                return 0;
-                        }
-                        else if (comparison < 0)
-                        {
-                                /* Check if left branch is empty. */
-                                if (tptr->tleft == (TARGET *)NULL)
-                                {
-                                        tptr->tleft = tar;
-                                        tptr->tleft->tleft = (TARGET *)NULL;
-                                        tptr->tleft->tright = (TARGET *)NULL;
-                                        break;
-                                }
-
-                                /* Move down left side of tree. */
-                                tptr = tptr->tleft;
-                        }
-                        else /* comparison > 0 */
-                        {
-                                /* Check if right branch is empty. */
-                                if (tptr->tright == (TARGET *)NULL)
-                                {
-                                        tptr->tright = tar;
-                                        tptr->tright->tleft = (TARGET *)NULL;
-                                        tptr->tright->tright = (TARGET *)NULL;
-                                        break;
-                                }
-
-                                /* Move down right side of tree. */
-                                tptr = tptr->tright;
-                        }
+                        /* Out of memory for hash table. */
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
                 }
-#else
-                /* This is not the first entry; insert at the end. */
-                tptr = target_list;
-                while (tptr->tnext != (TARGET *)NULL)
+        }
+
+        /* Find an empty slot, checking for a duplicate target. */
+        slot = tar->thash & (tindex_size - 1);
+        while ((tptr = target_index[slot]) != (TARGET *)NULL)
+        {
+                if (tptr->thash == tar->thash &&
+                        strcmp(tptr->tname, tar->tname) == 0)
                 {
-                        if (strcmp(tptr->tname, tar->tname) == 0)
-                        {
-                                /* Same target is already defined. */
-                                errmsg(MSG_ERR_SAMETARGET, tar->tname, NOVAL);
-                                return 0;
-                        }
-                        tptr = tptr->tnext;
+                        /* Same target is already defined. */
+                        errmsg(MSG_ERR_SAMETARGET, tar->tname, NOVAL);
+                        return 0;
                 }
-                tptr->tnext = tar;
-                tptr->tnext->tnext = (TARGET *)NULL;
-#endif /* BT_TARGETS */
+                slot = (slot + 1) & (tindex_size - 1);
         }
+        target_index[slot] = tar;
+        tindex_count++;
+
+        /* Place the target at the end of the list. */
+        tar->tnext = (TARGET *)NULL;
+        if (target_list == (TARGET *)NULL)
+                target_list = tar;
+        else
+                target_tail->tnext = tar;
+        target_tail = tar;
 
         return 1;
 }
@@ -216,66 +229,36 @@ dup_target(tar, tname)
         TARGET  *newtar;
 
         /* Allocate memory for target descriptor. */
-        newtar = (TARGET *)mem_alloc(sizeof(TARGET));
+        newtar = (TARGET *)arena_alloc(&target_arena, sizeof(TARGET));
         if (newtar == (TARGET *)NULL)
         {
                 /* Out of memory for target definition. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
                 return (TARGET *)NULL;
         }
-#ifdef BT_TARGETS
-        newtar->tleft = (TARGET *)NULL;
-        newtar->tright = (TARGET *)NULL;
-#else
         newtar->tnext = (TARGET *)NULL;
-#endif /* BT_TARGETS */
         newtar->tdependents = (char *)NULL;
+        newtar->tdeps = (DEPEND *)NULL;
+        newtar->ttime = 0L;
         newtar->tcommands = (LINE *)NULL;
+        newtar->tshared = 1;
 
-        /* Allocate memory for target name. */
-        newtar->tname = (char *)mem_alloc(strlen(tname) + 1);
+        /* Save target name and its hash value in descriptor. */
+        newtar->tname = arena_strdup(&target_arena, tname);
         if (newtar->tname == (char *)NULL)
         {
                 /* Out of memory for target name. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(newtar);
                 return (TARGET *)NULL;
         }
+        newtar->thash = hash_name(tname);
 
-        /* Save target name in descriptor. */
-        strcpy(newtar->tname, tname);
-
-        /* Copy dependents info. */
-        /* Allocate memory for dependent line (if any). */
-        if (tar->tdependents != (char *)NULL)
-        {
-                newtar->tdependents =
-                        mem_alloc(strlen(tar->tdependents) + 1);
-                if (newtar->tdependents == (char *)NULL)
-                {
-                        /* Out of memory for dependent list. */
-                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                        mem_free(newtar->tname);
-                        mem_free(newtar);
-                        return (TARGET *)NULL;
-                }
-                strcpy(newtar->tdependents, tar->tdependents);
-        }
-
-        /* Copy command info. */
-        if (tar->tcommands != (LINE *)NULL)
-        {
-                newtar->tcommands = dup_lines(tar->tcommands);
-                if (newtar->tcommands == (LINE *)NULL)
-                {
-                        /* Out of memory for dependent list. */
-                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                        mem_free(newtar->tname);
-                        mem_free(newtar->tdependents);
-                        mem_free(newtar);
-                        return (TARGET *)NULL;
-                }
-        }
+        /*
+        ** The dependent line and command lines are never changed
+        ** once the target is defined, so the copy can share them.
+        */
+        newtar->tdependents = tar->tdependents;
+        newtar->tcommands = tar->tcommands;
 
         return newtar;
 }
@@ -297,7 +280,12 @@ dup_target(tar, tname)
 void
 init_targets(void)
 {
+        arena_init(&target_arena, "targets");
         target_list = (TARGET *)NULL;
+        target_tail = (TARGET *)NULL;
+        target_index = (TARGET **)NULL;
+        tindex_size = 0;
+        tindex_count = 0;
 }
 
 /*
@@ -343,47 +331,53 @@ find_target(tname)
         char    *tname;
 {
         TARGET  *tar;           /* Pointer to target's descriptor. */
-        int     comparison;     /* Result of target name comparison. */
+        unsigned int hash;      /* Hash value of target name. */
+        unsigned int slot;      /* Index into hash table. */
+
+        if (tindex_count == 0)
+                return (TARGET *)NULL;
 
         /* Find target descriptor for specified target (if any). */
-        tar = target_list;
-#ifdef BT_TARGETS
-        while (tar != (TARGET *)NULL)
-        {
-                comparison = strcmp(tname, tar->tname);
-                if (comparison == 0)
-                {
-                        /* Found it. */
-                        return tar;
-                }
-                else if (comparison < 0)
-                {
-                        /* Move down left side of tree. */
-                        tar = tar->tleft;
-                }
-                else /* comparison > 0 */
-                {
-                        /* Move down right side of tree. */
-                        tar = tar->tright;
-                }
-        }
-#else
-        while (tar != (TARGET *)NULL)
+        hash = hash_name(tname);
+        slot = hash & (tindex_size - 1);
+        while ((tar = target_index[slot]) != (TARGET *)NULL)
         {
                 /* Is this descriptor for the target we want? */
-                if (strcmp(tname, tar->tname) == 0)
+                if (tar->thash == hash && strcmp(tname, tar->tname) == 0)
                 {
                         /* Found the right descriptor. */
                         return tar;
                 }
 
-                tar = tar->tnext;
+                slot = (slot + 1) & (tindex_size - 1);
         }
-#endif /* BT_TARGETS */
 
         return (TARGET *)NULL;
 }
 
+/*
+** target_alloc:
+** Allocates memory that is kept with the target list, and
+** freed along with it by flush_targets().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      bytes   Number of bytes of memory to allocate.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Not enough memory left.
+**      other   Pointer to allocated memory.
+*/
+void *
+target_alloc(bytes)
+        size_t  bytes;
+{
+        return arena_alloc(&target_arena, bytes);
+}
+
 /*
 ** flush_targets:
 ** Empties and frees the target list.
@@ -397,35 +391,23 @@ find_target(tname)
 void
 flush_targets(void)
 {
-#ifdef BT_TARGETS
-        free_target_tree(target_list);
-#else
-        TARGET  *t;     /* Temporary target descriptor pointers. */
-        TARGET  *t2;
-
-        /* Free each entry in the target list. */
-        t = target_list;
-        while (t != (TARGET *)NULL)
-        {
-                /* Free target name. */
-                mem_free(t->tname);
-
-                /* Free target dependent files. */
-                if (t->tdependents != (char *)NULL)
-                        mem_free(t->tdependents);
+        TARGET  *t;     /* Temporary target descriptor pointer. */
 
-                /* Free target command lines. */
-                if (t->tcommands != (LINE *)NULL)
+        /* Free each target's own command lines. */
+        for (t = target_list; t != (TARGET *)NULL; t = t->tnext)
+        {
+                if (!t->tshared && t->tcommands != (LINE *)NULL)
                         free_lines(t->tcommands);
-
-                /* Free target descriptor. */
-                t2 = t->tnext;
-                mem_free(t);
-                t = t2;
         }
-#endif
 
-        target_list = (TARGET *)NULL;
+        /* Free the descriptors, names, and dependents all at once. */
+        arena_release(&target_arena);
+
+        /* Free the hash table. */
+        if (target_index != (TARGET **)NULL)
+                mem_free(target_index);
+
+        init_targets();
 }
 
 /*
@@ -458,11 +440,12 @@ define_target(line, handle)
         TARGET  *tar2;          /* Temporary target descriptor pointer. */
         LINE    *nptr;          /* Temporary line descriptor pointer. */
         int     didcmds = 0;    /* Flag, nonzero after first command read. */
-        LINE    *names;         /* Temporary list of target names. */
+        LIST    names;          /* Temporary list of target names. */
+        LIST    cmds;           /* Target's command lines. */
         int     result;         /* Result of last read. */
 
         /* Get target name(s) from input line. */
-        names = (LINE *)NULL;
+        init_list(&names);
         pos = 0;
         while (line[pos] != '\0' &&
                 !(line[pos] == ':' && line[pos + 1] != '\\'))
@@ -488,15 +471,13 @@ define_target(line, handle)
                 tname[tpos] = '\0';
 
                 /* Add target name to temporary list of target names. */
-                nptr = append_line(names, tname);
-                if (nptr == (LINE *)NULL)
+                if (!add_to_list(&names, tname))
                 {
                         /* Out of memory for dependent list. */
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                        free_lines(names);
+                        flush_list(&names);
                         return 0;
                 }
-                names = nptr;
 
                 /* Skip any whitespace after target name. */
                 while (line[pos] == ' ' ||
@@ -505,7 +486,7 @@ define_target(line, handle)
         }
 
         /* Make sure at least one target name was given. */
-        if (names == (LINE *)NULL)
+        if (names.lhead == (LINE *)NULL)
         {
                 /* No targets given; syntax error. */
                 errmsg(MSG_ERR_TARGETSYNTAX, line, NOVAL);
@@ -517,7 +498,7 @@ define_target(line, handle)
         {
                 /* Syntax error in target definition. */
                 errmsg(MSG_ERR_TARGETSYNTAX, line, NOVAL);
-                free_lines(names);
+                flush_list(&names);
                 return 0;
         }
 
@@ -534,51 +515,43 @@ define_target(line, handle)
         */
 
         /* Allocate memory for target descriptor. */
-        tar = (TARGET *)mem_alloc(sizeof(TARGET));
+        tar = (TARGET *)arena_alloc(&target_arena, sizeof(TARGET));
         if (tar == (TARGET *)NULL)
         {
                 /* Out of memory for target definition. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                free_lines(names);
+                flush_list(&names);
                 return 0;
         }
-#ifdef BT_TARGETS
-        tar->tleft = (TARGET *)NULL;
-        tar->tright = (TARGET *)NULL;
-#else
         tar->tnext = (TARGET *)NULL;
-#endif /* BT_TARGETS */
         tar->tdependents = (char *)NULL;
+        tar->tdeps = (DEPEND *)NULL;
+        tar->ttime = 0L;
         tar->tcommands = (LINE *)NULL;
+        tar->tshared = 0;
 
-        /* Allocate memory for target name. */
-        tar->tname = (char *)mem_alloc(strlen(names->ldata) + 1);
+        /* Save target name and its hash value in descriptor. */
+        tar->tname = arena_strdup(&target_arena, names.lhead->ldata);
         if (tar->tname == (char *)NULL)
         {
                 /* Out of memory for target name. */
                 errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                mem_free(tar);
-                free_lines(names);
+                flush_list(&names);
                 return 0;
         }
+        tar->thash = hash_name(tar->tname);
 
-        /* Save target name in descriptor. */
-        strcpy(tar->tname, names->ldata);
-
-        /* Allocate memory for dependent line (if any). */
+        /* Save dependent line (if any). */
         if (line[pos] != '\0')
         {
-                tar->tdependents = (char *)mem_alloc(strlen(&line[pos]) + 1);
+                tar->tdependents = arena_strdup(&target_arena, &line[pos]);
                 if (tar->tdependents == (char *)NULL)
                 {
                         /* Out of memory for dependent list. */
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                        mem_free(tar->tname);
-                        mem_free(tar);
-                        free_lines(names);
+                        flush_list(&names);
                         return 0;
                 }
-                strcpy(tar->tdependents, &line[pos]);
         }
 
         /* Add new target descriptor to target list. */
@@ -591,6 +564,7 @@ define_target(line, handle)
         /*
         ** Build target's command list.
         */
+        init_list(&cmds);
         while (1)
         {
                 result = read_logical_line(handle, inpline, MAXLLINE);
@@ -615,7 +589,7 @@ define_target(line, handle)
 
                         /* Unexpected end-of-file. */
                         errmsg(MSG_ERR_EOF, (char *)NULL, NOVAL);
-                        free_lines(names);
+                        flush_list(&names);
                         return 0;
                 }
 
@@ -647,23 +621,21 @@ define_target(line, handle)
                         pos++;
 
                 /* Add line to target commands. */
-                nptr = append_line(tar->tcommands, &inpline[pos]);
-                if (nptr == (LINE *)NULL)
+                if (!add_to_list(&cmds, &inpline[pos]))
                 {
                         /* Out of memory for target commands. */
                         errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                        free_lines(names);
-                        free_lines(tar->tcommands);
+                        flush_list(&names);
                         return 0;
                 }
-                tar->tcommands = nptr;
+                tar->tcommands = cmds.lhead;
         } /* End while(1) */
 
         /*
         ** Duplicate target description for each target that was named
         ** on this line.
         */
-        nptr = names->lnext;
+        nptr = names.lhead->lnext;
         while (nptr != (LINE *)NULL)
         {
                 /* Duplicate descriptor info. */
@@ -671,7 +643,7 @@ define_target(line, handle)
                 if (tar2 == (TARGET *)NULL)
                 {
                         /* Error duplicating target. */
-                        free_lines(names);
+                        flush_list(&names);
                         return 0;
                 }
 
@@ -679,11 +651,7 @@ define_target(line, handle)
                 if (!add_target(tar2))
                 {
                         /* Error adding target to list. */
-                        mem_free(tar2->tname);
-                        mem_free(tar2->tdependents);
-                        free_lines(tar2->tcommands);
-                        mem_free(tar2);
-                        free_lines(names);
+                        flush_list(&names);
                         return 0;
                 }
 
@@ -691,7 +659,7 @@ define_target(line, handle)
                 nptr = nptr->lnext;
         }
 
-        free_lines(names);
+        flush_list(&names);
         return 1;
 }
 
@@ -712,9 +680,6 @@ dump_targets(void)
         LINE    *lptr;  /* Temporary line pointer. */
         TARGET  *tptr;  /* Temporary target pointer. */
 
-#ifdef BT_TARGETS
-        mputs("********** TARGET DUMP NOT IMPLEMENTED *********\n");
-#else
         tptr = target_list;
         if (tptr == (TARGET *)NULL)
                 mputs(MSG_INFO_NOTARGETS);
@@ -744,6 +709,113 @@ dump_targets(void)
 
                 tptr = tptr->tnext;
         }
-#endif /* BT_TARGETS */
 }
 
+/*
+** save_targets:
+** Writes the target list to the snapshot file.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+save_targets(void)
+{
+        TARGET          *tar;
+        unsigned        count = 0;
+
+        for (tar = target_list; tar != (TARGET *)NULL; tar = tar->tnext)
+                count++;
+        if (!put_snap_word(count))
+                return 0;
+        for (tar = target_list; tar != (TARGET *)NULL; tar = tar->tnext)
+        {
+                if (!put_snap_str(tar->tname) ||
+                        !put_snap_str(tar->tdependents) ||
+                        !put_snap_lines(tar->tcommands))
+                {
+                        return 0;
+                }
+        }
+
+        return 1;
+}
+
+/*
+** load_targets:
+** Loads the target list from the snapshot.  The target list
+** must be empty.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+int
+load_targets(void)
+{
+        TARGET          *tar;
+        unsigned        count;
+        char            *tname;
+        char            *deps;
+        LIST            cmds;
+
+        count = get_snap_word();
+        while (count-- > 0)
+        {
+                tname = get_snap_str();
+                deps = get_snap_str();
+                if (tname == (char *)NULL)
+                        tname = "";
+
+                /* Allocate and fill in target descriptor. */
+                tar = (TARGET *)arena_alloc(&target_arena, sizeof(TARGET));
+                if (tar == (TARGET *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                tar->tnext = (TARGET *)NULL;
+                tar->tdependents = (char *)NULL;
+                tar->tdeps = (DEPEND *)NULL;
+                tar->ttime = 0L;
+                tar->tname = arena_strdup(&target_arena, tname);
+                if (tar->tname == (char *)NULL)
+                {
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        return 0;
+                }
+                tar->thash = hash_name(tname);
+                if (deps != (char *)NULL)
+                {
+                        tar->tdependents = arena_strdup(&target_arena, deps);
+                        if (tar->tdependents == (char *)NULL)
+                        {
+                                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL,
+                                        NOVAL);
+                                return 0;
+                        }
+                }
+                tar->tcommands = (LINE *)NULL;
+                tar->tshared = 0;
+                init_list(&cmds);
+                if (!get_snap_lines(&cmds))
+                        return 0;
+                tar->tcommands = cmds.lhead;
+
+                if (!add_target(tar))
+                        return 0;
+        }
+
+        return 1;
+}
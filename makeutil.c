@@ -29,8 +29,41 @@ of the author.
 
 #include "make.h"
 
+/****************************** HEADERS *****************************/
+
+/* Functions local to this file: */
+static int      grow_mstat(void);
+static FSTAT    *find_mstat(char *fname, char *lname, unsigned int *hash);
+static int      dos_mstat(char *fname, struct mstat_t *tstat);
+
+/****************************** CONSTANTS ***************************/
+
+/*
+** Initial number of hash buckets in the file time/date stamp
+** cache (power of two).
+*/
+#define FSTAT_MIN       64
+
+/* Largest number of hash buckets allowed in the cache. */
+#define FSTAT_MAX       16384
+
 /****************************** VARIABLES ***************************/
 
+/*
+** Hash table of file time/date stamps already retrieved by mstat(),
+** its number of buckets, and the number of files in it.
+*/
+static FSTAT **fstat_table;
+static unsigned int fstat_size;
+static unsigned int fstat_count;
+
+/*
+** Number of mstat() calls answered from the cache, and number that
+** had to ask DOS.
+*/
+static unsigned long fstat_hits;
+static unsigned long fstat_misses;
+
 /*
 ** Temporary pathname buffer used by enumpath().
 */
@@ -41,6 +74,198 @@ static char locpath[MAXPATH];
 */
 static char *pathptr;
 
+/*************************** LOCAL FUNCTIONS ************************/
+
+/*
+** grow_mstat:
+** Doubles the number of hash buckets in the file time/date
+** stamp cache, or creates the table if it doesn't exist yet.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Not enough memory, or table is already at its
+**              maximum size.
+*/
+static int
+grow_mstat(void)
+{
+        FSTAT           **newtable;
+        FSTAT           *fptr;
+        FSTAT           *fptr2;
+        unsigned int    newsize;
+        unsigned int    i;
+        unsigned int    bucket;
+
+        /* Determine new size of table. */
+        if (fstat_size == 0)
+                newsize = FSTAT_MIN;
+        else if (fstat_size < FSTAT_MAX)
+                newsize = fstat_size * 2;
+        else
+                return 0;
+
+        /* Allocate memory for the new table and clear it. */
+        newtable = (FSTAT **)mem_alloc(newsize * sizeof(FSTAT *));
+        if (newtable == (FSTAT **)NULL)
+                return 0;
+        for (i = 0; i < newsize; i++)
+                newtable[i] = (FSTAT *)NULL;
+
+        /* Move the entries from the old buckets into the new ones. */
+        for (i = 0; i < fstat_size; i++)
+        {
+                fptr = fstat_table[i];
+                while (fptr != (FSTAT *)NULL)
+                {
+                        fptr2 = fptr->fnext;
+                        bucket = fptr->fhash & (newsize - 1);
+                        fptr->fnext = newtable[bucket];
+                        newtable[bucket] = fptr;
+                        fptr = fptr2;
+                }
+        }
+
+        if (fstat_table != (FSTAT **)NULL)
+                mem_free(fstat_table);
+        fstat_table = newtable;
+        fstat_size = newsize;
+
+        return 1;
+}
+
+/*
+** find_mstat:
+** Searches the file time/date stamp cache for a file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to search for.
+**      lname   Buffer of MAXPATH bytes to receive the
+**              lowercase form of the filename.
+**      hash    Pointer to value to receive the hash
+**              value of the lowercase filename.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    File is not in the cache.
+**      other   Pointer to file's cache entry.
+*/
+static FSTAT *
+find_mstat(fname, lname, hash)
+        char            *fname;
+        char            *lname;
+        unsigned int    *hash;
+{
+        FSTAT   *fptr;
+
+        /* DOS filenames aren't case sensitive. */
+        strncpy(lname, fname, MAXPATH - 1);
+        lname[MAXPATH - 1] = '\0';
+        strlwr(lname);
+        *hash = hash_name(lname);
+        if (fstat_size == 0)
+                return (FSTAT *)NULL;
+
+        fptr = fstat_table[*hash & (fstat_size - 1)];
+        while (fptr != (FSTAT *)NULL)
+        {
+                if (fptr->fhash == *hash && strcmp(lname, fptr->fname) == 0)
+                        return fptr;
+                fptr = fptr->fnext;
+        }
+
+        return (FSTAT *)NULL;
+}
+
+/*
+** dos_mstat:
+** Retrieves the time/date stamp and size of a file from DOS.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to get status of.
+**      tstat   Pointer to mstat_t structure to
+**              put time/date stamp and size of file into.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      0       Successful.
+**      other   Error occurred.
+*/
+static int
+dos_mstat(fname, tstat)
+        char            *fname;
+        struct mstat_t  *tstat;
+{
+        int             handle;
+        union REGS      dosregs;
+
+        /* Open the file. */
+        dosregs.h.ah = 0x3D;            /* DOS open file function. */
+        dosregs.x.dx = (int)fname;      /* DX gets offset of filename. */
+        dosregs.h.al = 0;               /* 0 = open for reading. */
+        intdos(&dosregs, &dosregs);
+
+        if (dosregs.x.cflag)
+                return -1;      /* Error occurred. */
+
+        handle = (int)dosregs.x.ax;
+
+        /* Get time/date of file. */
+        dosregs.h.ah = 0x57;    /* DOS get/set time/date stamp function. */
+        dosregs.h.al = 0;       /* subfunction 0 = get time/date stamp. */
+        dosregs.x.bx = handle;  /* BX gets file handle. */
+        intdos(&dosregs, &dosregs);
+
+        /* Check for error. */
+        if (dosregs.x.cflag)
+        {
+                /* Close the file. */
+                dosregs.h.ah = 0x3E;    /* DOS close file function. */
+                dosregs.x.bx = handle;  /* BX gets file handle. */
+                intdos(&dosregs, &dosregs);
+
+                return -1;
+        }
+
+        /* Save time/date stamp in caller's structure. */
+        tstat->st_mtime =
+                (0xFFFF0000L & ((unsigned long)dosregs.x.dx << 16)) +
+                        (0x0000FFFFL & (unsigned long)dosregs.x.cx);
+
+        /* Get size of file by seeking to the end of it. */
+        dosregs.x.ax = 0x4202;  /* DOS seek function, from end of file. */
+        dosregs.x.bx = handle;  /* BX gets file handle. */
+        dosregs.x.cx = 0;       /* CX:DX gets offset from end. */
+        dosregs.x.dx = 0;
+        intdos(&dosregs, &dosregs);
+        if (dosregs.x.cflag)
+                tstat->st_size = 0L;
+        else
+                tstat->st_size =
+                        (0xFFFF0000L & ((unsigned long)dosregs.x.dx << 16)) +
+                                (0x0000FFFFL & (unsigned long)dosregs.x.ax);
+
+        /* Close the file. */
+        dosregs.h.ah = 0x3E;    /* DOS close file function. */
+        dosregs.x.bx = handle;  /* BX gets file handle. */
+        intdos(&dosregs, &dosregs);
+
+        if (dosregs.x.cflag)
+                return -1;      /* Error occurred. */
+
+        return 0;
+}
+
 /****************************** FUNCTIONS ***************************/
 
 /*
@@ -229,6 +454,9 @@ touch_file(name)
         if (dosregs.x.cflag)
                 return 0;       /* Error occurred. */
 
+        /* The file's time/date stamp is about to change. */
+        forget_mstat(name);
+
         /* Close the file. */
         dosregs.h.ah = 0x3E;    /* DOS close file function. */
         dosregs.x.bx = handle;  /* BX gets file handle. */
@@ -279,7 +507,6 @@ mutoa(val)
         return &s[pos + 1];
 }
 
-#ifdef NOTUSED
 /*
 ** multoa:
 ** Converts a long unsigned integer value to ASCII text.
@@ -317,7 +544,6 @@ multoa(val)
 
         return &s[pos + 1];
 }
-#endif
 
 /*
 ** mputs:
@@ -535,72 +761,307 @@ mread(fh, bfr, count)
 }
 
 /*
-** mstat:
-** Retrieves the time/date stamp of a file.
+** mcreat:
+** Creates a file for writing in binary mode, truncating
+** it if it already exists.  This is similar to "open(fname,
+** O_WRONLY | O_CREAT | O_TRUNC | O_BINARY)", but takes up
+** alot less code space.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      fname   Name of file to get status of.
-**      tstat   Pointer to mstat_t structure to
-**              put time/date stamp of file into.
+**      fname   Name of file to create.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      0       Successful.
-**      other   Error occurred.
+**      -1      Error occurred.
+**      other   File handle of open file.
 */
 int
-mstat(fname, tstat)
-        char            *fname;
-        struct mstat_t  *tstat;
+mcreat(fname)
+        char    *fname;
 {
-        int             handle;
-        union REGS      dosregs;
+        union REGS dosregs;
 
-        /* Open the file. */
-        dosregs.h.ah = 0x3D;            /* DOS open file function. */
+        dosregs.h.ah = 0x3C;            /* DOS create file function. */
         dosregs.x.dx = (int)fname;      /* DX gets offset of filename. */
-        dosregs.h.al = 0;               /* 0 = open for reading. */
+        dosregs.x.cx = 0;               /* CX gets file attributes. */
         intdos(&dosregs, &dosregs);
 
         if (dosregs.x.cflag)
                 return -1;      /* Error occurred. */
 
-        handle = (int)dosregs.x.ax;
+        return (int)dosregs.x.ax;
+}
 
-        /* Get time/date of file. */
-        dosregs.h.ah = 0x57;    /* DOS get/set time/date stamp function. */
-        dosregs.h.al = 0;       /* subfunction 0 = get time/date stamp. */
-        dosregs.x.bx = handle;  /* BX gets file handle. */
+/*
+** mwrite:
+** Writes data to a file that was opened with mcreat().  This
+** does basically the same thing as write() but takes up alot
+** less code space.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fh      File handle.
+**      bfr     Buffer containing data to write.
+**      count   Number of bytes to write.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      -1      Error occurred.
+**      other   Number of bytes written.
+*/
+int
+mwrite(fh, bfr, count)
+        int     fh;
+        char    *bfr;
+        int     count;
+{
+        union REGS dosregs;
+
+        dosregs.h.ah = 0x40;            /* DOS write file function. */
+        dosregs.x.bx = fh;              /* BX gets file handle. */
+        dosregs.x.dx = (int)bfr;        /* DX gets buffer offset. */
+        dosregs.x.cx = count;           /* CX gets number of bytes. */
         intdos(&dosregs, &dosregs);
 
-        /* Check for error. */
         if (dosregs.x.cflag)
+                return -1;
+
+        /* Return number of bytes written. */
+        return (int)dosregs.x.ax;
+}
+
+/*
+** mstat:
+** Retrieves the time/date stamp and size of a file.  Each file is only
+** looked up once; the results are kept in a cache until the
+** file is changed by make, as reported through forget_mstat().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to get status of.
+**      tstat   Pointer to mstat_t structure to
+**              put time/date stamp and size of file into.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      0       Successful.
+**      other   Error occurred.
+*/
+int
+mstat(fname, tstat)
+        char            *fname;
+        struct mstat_t  *tstat;
+{
+        FSTAT           *fptr;
+        char            lname[MAXPATH];
+        unsigned int    hash;
+        unsigned int    bucket;
+
+        /* Check the cache first. */
+        fptr = find_mstat(fname, lname, &hash);
+        if (fptr != (FSTAT *)NULL)
         {
-                /* Close the file. */
-                dosregs.h.ah = 0x3E;    /* DOS close file function. */
-                dosregs.x.bx = handle;  /* BX gets file handle. */
-                intdos(&dosregs, &dosregs);
+                fstat_hits++;
+                tstat->st_mtime = fptr->ftime;
+                tstat->st_size = fptr->fsize;
+                return fptr->fresult;
+        }
+        fstat_misses++;
 
-                return -1;
+        /*
+        ** Keep no more than two files per bucket on average, so
+        ** the chains stay short however many files are looked up.
+        */
+        if (fstat_count >= fstat_size * 2 && !grow_mstat() &&
+                fstat_size == 0)
+        {
+                /* There's no table at all; just ask DOS. */
+                return dos_mstat(fname, tstat);
         }
 
-        /* Save time/date stamp in caller's structure. */
-        tstat->st_mtime =
-                (0xFFFF0000L & ((unsigned long)dosregs.x.dx << 16)) +
-                        (0x0000FFFFL & (unsigned long)dosregs.x.cx);
+        /* Make a new cache entry for the file. */
+        fptr = (FSTAT *)mem_alloc(sizeof(FSTAT));
+        if (fptr == (FSTAT *)NULL)
+        {
+                /* No room to cache it; just ask DOS. */
+                return dos_mstat(fname, tstat);
+        }
+        fptr->fname = (char *)mem_alloc(strlen(lname) + 1);
+        if (fptr->fname == (char *)NULL)
+        {
+                mem_free(fptr);
+                return dos_mstat(fname, tstat);
+        }
+        strcpy(fptr->fname, lname);
+        fptr->fhash = hash;
 
-        /* Close the file. */
-        dosregs.h.ah = 0x3E;    /* DOS close file function. */
-        dosregs.x.bx = handle;  /* BX gets file handle. */
-        intdos(&dosregs, &dosregs);
+        /*
+        ** Get the file's time/date stamp and save it.  The index of
+        ** the file's directory can usually answer without DOS.
+        */
+        tstat->st_mtime = 0L;
+        tstat->st_size = 0L;
+        fptr->fresult = dir_mstat(fname, tstat);
+        if (fptr->fresult < 0)
+                fptr->fresult = dos_mstat(fname, tstat);
+        fptr->ftime = tstat->st_mtime;
+        fptr->fsize = tstat->st_size;
+
+        /* Add the entry to its hash bucket. */
+        bucket = hash & (fstat_size - 1);
+        fptr->fnext = fstat_table[bucket];
+        fstat_table[bucket] = fptr;
+        fstat_count++;
+
+        return fptr->fresult;
+}
 
-        if (dosregs.x.cflag)
-                return -1;      /* Error occurred. */
+/*
+** mexists:
+** Checks if a file exists, using the mstat() cache.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file to check.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       File exists.
+**      0       File doesn't exist or can't be accessed.
+*/
+int
+mexists(fname)
+        char    *fname;
+{
+        struct mstat_t tstat;
 
-        return 0;
+        return mstat(fname, &tstat) == 0;
+}
+
+/*
+** init_mstat:
+** Initializes the file time/date stamp cache used by mstat().
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+init_mstat(void)
+{
+        fstat_table = (FSTAT **)NULL;
+        fstat_size = 0;
+        fstat_count = 0;
+        fstat_hits = 0L;
+        fstat_misses = 0L;
+}
+
+/*
+** flush_mstat:
+** Empties and frees the file time/date stamp cache.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+flush_mstat(void)
+{
+        FSTAT           *fptr;
+        FSTAT           *fptr2;
+        unsigned int    i;
+
+        for (i = 0; i < fstat_size; i++)
+        {
+                fptr = fstat_table[i];
+                while (fptr != (FSTAT *)NULL)
+                {
+                        fptr2 = fptr->fnext;
+                        mem_free(fptr->fname);
+                        mem_free(fptr);
+                        fptr = fptr2;
+                }
+        }
+        if (fstat_table != (FSTAT **)NULL)
+                mem_free(fstat_table);
+        fstat_table = (FSTAT **)NULL;
+        fstat_size = 0;
+        fstat_count = 0;
+}
+
+/*
+** forget_mstat:
+** Removes a file from the file time/date stamp cache.  This
+** must be called whenever make does something that may create,
+** change, or delete the file.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fname   Name of file that may have changed.
+**
+** Returns:
+**      NONE
+*/
+void
+forget_mstat(fname)
+        char    *fname;
+{
+        FSTAT           *fptr;
+        FSTAT           **fprev;
+        char            lname[MAXPATH];
+        unsigned int    hash;
+
+        /* The file's directory entry may have changed too. */
+        forget_dirent(fname);
+
+        fptr = find_mstat(fname, lname, &hash);
+        if (fptr == (FSTAT *)NULL)
+                return;
+
+        /* Unlink the entry from its hash bucket and free it. */
+        fprev = &fstat_table[hash & (fstat_size - 1)];
+        while (*fprev != fptr)
+                fprev = &(*fprev)->fnext;
+        *fprev = fptr->fnext;
+        fstat_count--;
+        mem_free(fptr->fname);
+        mem_free(fptr);
+}
+
+/*
+** dump_mstat:
+** Outputs the number of mstat() calls that were answered from
+** the cache and the number that had to ask DOS.  This function
+** is used for debugging.
+**
+** Parameters:
+**      NONE
+**
+** Returns:
+**      NONE
+*/
+void
+dump_mstat(void)
+{
+        mputs(MSG_DBG_STATHITS);
+        mputs(multoa(fstat_hits));
+        mputs(MSG_DBG_STATMISSES);
+        mputs(multoa(fstat_misses));
+        mputs("\n");
 }
 
 /*
@@ -747,6 +1208,8 @@ free_lines(lptr)
         while (lptr != (LINE *)NULL)
         {
                 mem_free(lptr->ldata);
+                if (lptr->lcmd != (CMDPART *)NULL)
+                        mem_free(lptr->lcmd);
                 ltmp = lptr->lnext;
                 mem_free(lptr);
                 lptr = ltmp;
@@ -794,113 +1257,245 @@ create_line(s)
 
         /* Set descriptor fields. */
         strcpy(l->ldata, s);
+        l->lcmd = (CMDPART *)NULL;
         l->lnext = (LINE *)NULL;
 
         return l;
 }
 
 /*
-** append_line:
-** Appends a string to the end of a linked list of lines.
+** init_list:
+** Initializes a list of lines to be empty.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      lhead   Pointer to first line in list of lines to
-**              be appended to.
+**      list    Pointer to list to initialize.
+**
+** Returns:
+**      NONE
+*/
+void
+init_list(list)
+        LIST    *list;
+{
+        list->lhead = (LINE *)NULL;
+        list->ltail = (LINE *)NULL;
+        list->lcount = 0;
+}
+
+/*
+** add_to_list:
+** Adds a string to the end of a list of lines.  Since the
+** list keeps track of its last line, this takes the same
+** time no matter how long the list is.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      list    Pointer to list to add to.
 **      s       Pointer to buffer containing null terminated
-**              string to be appended to list of lines.
+**              string to be added to list.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      NULL    Error occurred.
-**      other   Pointer to new head of line list.
+**      1       Successful.
+**      0       Out of memory.
 */
-LINE *
-append_line(lhead, s)
-        LINE    *lhead;
+int
+add_to_list(list, s)
+        LIST    *list;
         char    *s;
 {
-        LINE    *lptr;
+        LINE    *l;
 
-        if (lhead == (LINE *)NULL)
-        {
-                lhead = create_line(s);
-                if (lhead == (LINE *)NULL)
-                        return (LINE *)NULL;
-                lhead->lnext = (LINE *)NULL;
-        }
+        l = create_line(s);
+        if (l == (LINE *)NULL)
+                return 0;
+
+        if (list->ltail == (LINE *)NULL)
+                list->lhead = l;
         else
+                list->ltail->lnext = l;
+        list->ltail = l;
+        list->lcount++;
+
+        return 1;
+}
+
+/*
+** flush_list:
+** Frees the lines in a list of lines, leaving it empty.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      list    Pointer to list to flush.
+**
+** Returns:
+**      NONE
+*/
+void
+flush_list(list)
+        LIST    *list;
+{
+        free_lines(list->lhead);
+        init_list(list);
+}
+
+/*
+** grow_block:
+** Moves a block of memory to a new, larger block.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      ptr     Pointer to old block (or NULL).
+**      used    Number of bytes in use in old block.
+**      size    Size of new block, in bytes.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      NULL    Out of memory; the old block is left alone.
+**      other   Pointer to new block.  The old block is freed.
+*/
+char *
+grow_block(ptr, used, size)
+        char            *ptr;
+        unsigned int    used;
+        unsigned int    size;
+{
+        char    *newptr;
+
+        newptr = (char *)mem_alloc(size);
+        if (newptr == (char *)NULL)
+                return (char *)NULL;
+        if (ptr != (char *)NULL)
         {
-                lptr = lhead;
-                while (lptr->lnext != (LINE *)NULL)
-                        lptr = lptr->lnext;
-                lptr->lnext = create_line(s);
-                if (lptr->lnext == (LINE *)NULL)
-                        return (LINE *)NULL;
-                lptr->lnext->lnext = (LINE *)NULL;
+                memcpy(newptr, ptr, used);
+                mem_free(ptr);
         }
 
-        return lhead;
+        return newptr;
+}
+
+/*
+** init_strvec:
+** Initializes a string vector to be empty.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      vec     Pointer to string vector to initialize.
+**
+** Returns:
+**      NONE
+*/
+void
+init_strvec(vec)
+        STRVEC  *vec;
+{
+        vec->voff = (unsigned int *)NULL;
+        vec->vcount = 0;
+        vec->vmax = 0;
+        vec->vpool = (char *)NULL;
+        vec->vused = 0;
+        vec->vsize = 0;
 }
 
 /*
-** dup_lines:
-** Makes a duplicate of a list of lines.
+** add_strvec:
+** Adds a copy of a string to the end of a string vector.
+** The strings are kept end to end in one block, and their
+** offsets in another, and both blocks are doubled in size
+** when they fill up.  Use VSTR() to get at the strings,
+** since the blocks move when they grow.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      lorg    Pointer to first LINE to duplicate.
+**      vec     Pointer to string vector to add to.
+**      s       String to add.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      NULL    Error occurred (i.e. out of memory).
-**      other   Pointer to first LINE in duplicate list.
+**      1       Successful.
+**      0       Out of memory.
 */
-LINE *
-dup_lines(lorg)
-        LINE    *lorg;
+int
+add_strvec(vec, s)
+        STRVEC  *vec;
+        char    *s;
 {
-        LINE    *lnew;
-        LINE    *lorgnext;
-        LINE    *lnewnext = (LINE *)NULL;
+        unsigned int    len;
+        unsigned int    n;
+        char            *p;
 
-        /* Check for empty list. */
-        if (lorg == (LINE *)NULL)
-                return (LINE *)NULL;
+        len = strlen(s) + 1;
 
-        /* Process each line in the original list. */
-        lorgnext = lorg;
-        while (lorgnext != (LINE *)NULL)
+        /* Make room for another offset. */
+        if (vec->vcount == vec->vmax)
         {
-                if (lnewnext == (LINE *)NULL)
-                {
-                        /* This is first item in new list. */
-                        lnew = create_line(lorgnext->ldata);
-                        if (lnew == (LINE *)NULL)
-                                return (LINE *)NULL;
-                        lnewnext = lnew;
-                }
-                else
+                n = (vec->vmax == 0) ? 16 : vec->vmax * 2;
+                if (n <= vec->vmax || n > MAXALLOC / sizeof(unsigned int))
+                        return 0;
+                p = grow_block((char *)vec->voff,
+                        vec->vcount * sizeof(unsigned int),
+                        n * sizeof(unsigned int));
+                if (p == (char *)NULL)
+                        return 0;
+                vec->voff = (unsigned int *)p;
+                vec->vmax = n;
+        }
+
+        /* Make room for the string. */
+        if (vec->vsize - vec->vused < len)
+        {
+                n = (vec->vsize == 0) ? 256 : vec->vsize;
+                while (n - vec->vused < len)
                 {
-                        /* This is next item in new list. */
-                        lnewnext->lnext = create_line(lorgnext->ldata);
-                        if (lnewnext->lnext == (LINE *)NULL)
-                        {
-                                free_lines(lnew);
-                                return (LINE *)NULL;
-                        }
-                        lnewnext = lnewnext->lnext;
+                        if (n > MAXALLOC / 2)
+                                return 0;
+                        n *= 2;
                 }
-
-                /* Step to next line in original list. */
-                lorgnext = lorgnext->lnext;
+                p = grow_block(vec->vpool, vec->vused, n);
+                if (p == (char *)NULL)
+                        return 0;
+                vec->vpool = p;
+                vec->vsize = n;
         }
 
-        return lnew;
+        memcpy(&vec->vpool[vec->vused], s, len);
+        vec->voff[vec->vcount++] = vec->vused;
+        vec->vused += len;
+
+        return 1;
+}
+
+/*
+** flush_strvec:
+** Frees the strings in a string vector, leaving it empty.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      vec     Pointer to string vector to flush.
+**
+** Returns:
+**      NONE
+*/
+void
+flush_strvec(vec)
+        STRVEC  *vec;
+{
+        if (vec->voff != (unsigned int *)NULL)
+                mem_free(vec->voff);
+        if (vec->vpool != (char *)NULL)
+                mem_free(vec->vpool);
+        init_strvec(vec);
 }
 
 /*
@@ -936,3 +1531,29 @@ cindex(s, c)
         return -1;
 }
 
+
+/*
+** hash_name:
+** Computes a hash value for a name, for use in locating the
+** name in a hash table.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      s       String containing name.
+**
+** Returns:
+**      Hash value for the name.  The caller reduces this to
+**      the size of its own table.
+*/
+unsigned int
+hash_name(s)
+        char    *s;
+{
+        unsigned int    h = 0;
+
+        while (*s)
+                h = (h << 5) + h + (unsigned char)*s++;
+
+        return h;
+}
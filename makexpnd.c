@@ -42,6 +42,18 @@ Make's 'special macros' include the following:
                 for the current target.  This may be used in the
                 commands list of a target or a rule.
 
+Dependent Lists:
+
+A target's dependent list is split into filenames, and any
+wildcards in it are expanded, only once per run, by
+expand_dependents().  The resulting array is kept in the target's
+descriptor and shared by everything that needs the list: building
+the dependents, the job queue, the dependents digest, and the '$?'
+and '$**' macros.  When make_target() is called for each dependent,
+the timestamp it returns is saved in the array, so that '$?' can
+pick out the dependents that are newer than the target without
+getting the time/date stamps of the files again.
+
 ======================================================================
 */
 
@@ -62,9 +74,20 @@ Make's 'special macros' include the following:
 #include "fnexp.h"
 #include "wild.h"
 
+/* Functions local to this file: */
+static int      split_parts(char *text, char *kind, int n, CMDPART *parts,
+                        char *pool);
+static int      add_match(char *fspec, char *fname, int dlen, char *name,
+                        STRVEC *vec);
+static int      scan_index(DIRIDX *dir, char *fspec, char *fname, int dlen,
+                        STRVEC *vec);
+
 /*
 ** expand_named_macros:
-** Expands any named macros in a given string.
+** Expands any named macros in a given string.  Macros that
+** are referred to by the expansion text of other macros are
+** expanded too (by expand_macro()), so only one pass over the
+** string is needed.
 **
 ** Parameters:
 **      Name    Description
@@ -90,10 +113,17 @@ expand_named_macros(src, dest, maxlen)
         int     spos = 0;       /* Position in src string. */
         int     dpos = 0;       /* Position in dest string. */
         int     mpos;           /* Position in mname string. */
-        char    mname[MAXPATH]; /* Name of macro. */
         char    *mptr;          /* Pointer to macro expansion. */
+        int     mlen;           /* Length of macro expansion. */
         int     did = 0;        /* Flag, nonzero if macro gets expanded. */
 
+        /*
+        ** Name of macro.  This function calls itself through
+        ** expand_macro(), so to save stack space, the name is
+        ** static; it isn't needed after expand_macro() is called.
+        */
+        static char mname[MAXPATH];
+
         /* Process each character in the source string. */
         while (src[spos] != '\0')
         {
@@ -259,34 +289,25 @@ expand_named_macros(src, dest, maxlen)
                         */
                         if (mpos > 0)
                         {
-                                /* Get macro expansion. */
-                                mptr = find_macro(mname);
+                                /* Get fully expanded macro text. */
+                                mptr = expand_macro(mname);
                                 if (mptr == (char *)NULL)
-                                {
-                                        /* Macro not defined. */
-                                        errmsg(MSG_ERR_NOMACRO, mname, NOVAL);
                                         return 0;
-                                }
 
                                 /* Place macro expansion in dest buffer. */
-                                mpos = 0;
-                                while (mptr[mpos] != '\0')
+                                mlen = strlen(mptr);
+                                if (dpos + mlen >= maxlen)
                                 {
-                                        /* Check for dest buffer overflow. */
-                                        if (dpos >= maxlen - 1)
-                                        {
-                                                /*
-                                                ** Expansion caused string
-                                                ** to become too long.
-                                                */
-                                                errmsg(MSG_ERR_EXPTOOLONG,
-                                                        src, NOVAL);
-                                                return 0;
-                                        }
-
-                                        /* Copy macro character to dest. */
-                                        dest[dpos++] = mptr[mpos++];
+                                        /*
+                                        ** Expansion caused string
+                                        ** to become too long.
+                                        */
+                                        errmsg(MSG_ERR_EXPTOOLONG,
+                                                src, NOVAL);
+                                        return 0;
                                 }
+                                memcpy(&dest[dpos], mptr, mlen);
+                                dpos += mlen;
 
                                 did = 1;
                         }
@@ -306,85 +327,202 @@ expand_named_macros(src, dest, maxlen)
         return 1;
 }
 
+/*
+** add_match:
+** Adds a filename matched by a wildcard scan to a string
+** vector, with the directory part of the filespec in front
+** of it.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      fspec   Wildcard filespec being expanded.
+**      fname   Buffer of MAXPATH bytes that holds the
+**              directory part of fspec.
+**      dlen    Length of the directory part in fname.
+**      name    Name of matched file.
+**      vec     Pointer to string vector to receive the
+**              filename.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      1       Successful.
+**      0       Error occurred.
+*/
+static int
+add_match(fspec, fname, dlen, name, vec)
+        char    *fspec;
+        char    *fname;
+        int     dlen;
+        char    *name;
+        STRVEC  *vec;
+{
+        /* Build full pathname of matched file. */
+        if (dlen + strlen(name) >= MAXPATH)
+        {
+                errmsg(MSG_ERR_PATHTOOLONG, fspec, NOVAL);
+                return 0;
+        }
+        strcpy(&fname[dlen], name);
+        strlwr(fname);                  /* Just for MS-DOS. */
+
+        /* Add filename to vector. */
+        if (!add_strvec(vec, fname))
+        {
+                /* Error adding to vector. */
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                return 0;
+        }
+
+        return 1;
+}
+
+/*
+** scan_index:
+** Expands a wildcard filespec using the index of its
+** directory, in the same way as expand_wildcard().
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      dir     Index of directory to be scanned.
+**      fspec   Wildcard filespec to be expanded.
+**      fname   Buffer of MAXPATH bytes that holds the
+**              directory part of fspec.
+**      dlen    Length of the directory part in fname.
+**      vec     Pointer to string vector to receive the
+**              filenames.
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      -1      Error occurred.
+**      other   Number of filenames added to the vector.
+*/
+static int
+scan_index(dir, fspec, fname, dlen, vec)
+        DIRIDX  *dir;
+        char    *fspec;
+        char    *fname;
+        int     dlen;
+        STRVEC  *vec;
+{
+        REXP            cre;            /* Compiled filename part. */
+        unsigned int    i;
+        int             count = 0;      /* Number of matched files. */
+
+        if (compile_rexp(&fspec[dir->dlen], &cre) != 1)
+        {
+                /* Error in wildcard expression; nothing matches. */
+                return 0;
+        }
+
+        /* Entries are checked in directory order, as DOS gives them. */
+        for (i = 0; i < dir->dnames.vcount; i++)
+        {
+                /* Check if entry is the right kind of file. */
+                if (dir->dents[i].dattrib &
+                        (_A_SUBDIR | _A_HIDDEN | _A_SYSTEM))
+                {
+                        continue;
+                }
+
+                if (match_rexp(&cre, VSTR(&dir->dnames, i)))
+                {
+                        if (!add_match(fspec, fname, dlen,
+                                VSTR(&dir->dnames, i), vec))
+                        {
+                                return -1;
+                        }
+                        count++;
+                }
+        }
+
+        return count;
+}
+
 /*
 ** expand_wildcard:
-** Expands a wildcard filespec into individual filenames.
+** Expands a wildcard filespec into individual filenames,
+** which are added to the end of a string vector.
 ** Directories, hidden files, and system files are not
-** included.
+** included.  The directory's index is used when it has
+** one (see "makedir.c").
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
 **      fspec   Wildcard filespec to be expanded.
+**      vec     Pointer to string vector to receive the
+**              filenames.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
 **      -1      Error occurred.
-**      NULL    No files matched the wildcard.
-**      other   Pointer to list of lines containing the
-**              filenames.
+**      0       No files matched the wildcard.
+**      other   Number of filenames added to the vector.
 */
-LINE *
-expand_wildcard(fspec)
+int
+expand_wildcard(fspec, vec)
         char    *fspec;
+        STRVEC  *vec;
 {
-        LINE            *names = (LINE *)NULL;
-        LINE            *ltmp;
-        struct find_t   findbfr;        /* Buffer for w_find...() */
+        WFIND           wf;             /* Buffer for w_find...() */
+        DIRIDX          *dir;           /* Index of directory. */
         int             result;         /* Result of last w_find...() */
+        int             count = 0;      /* Number of matched files. */
+        int             dlen;           /* Length of directory part. */
         char            fname[MAXPATH]; /* Name of matched file. */
 
+        /*
+        ** Get the directory part of the filespec, which is the
+        ** same for every matched file.
+        */
+        get_part_filename(1, fspec, fname);
+        dlen = strlen(fname);
+        if (dlen > 0 && fname[dlen - 1] != '\\' && fname[dlen - 1] != ':')
+                fname[dlen++] = '\\';
+
+        /* Use the directory's index if it has one. */
+        dir = scan_dir(fspec);
+        if (dir != (DIRIDX *)NULL)
+                return scan_index(dir, fspec, fname, dlen, vec);
+
         /* Process each matching filespec. */
-        result = w_findfirst(fspec, &findbfr);
+        result = w_findfirst(fspec, &wf);
         while (!result)
         {
                 /* Check if matched file is the right kind. */
-                if (!(findbfr.attrib & _A_SUBDIR) &&
-                        !(findbfr.attrib & _A_HIDDEN) &&
-                        !(findbfr.attrib & _A_SYSTEM))
+                if (!(wf.wfind.attrib & _A_SUBDIR) &&
+                        !(wf.wfind.attrib & _A_HIDDEN) &&
+                        !(wf.wfind.attrib & _A_SYSTEM))
                 {
-                        /* Build full pathname of matched file. */
-                        strcpy(fname, fspec);
-                        get_part_filename(1, fname, fname);
-                        if (fname[0] != '\0' &&
-                                fname[strlen(fname) - 1] != '\\' &&
-                                fname[strlen(fname) - 1] != ':')
+                        if (!add_match(fspec, fname, dlen, wf.wfind.name,
+                                vec))
                         {
-                                strcat(fname, "\\");
+                                return -1;
                         }
-                        strcat(fname, findbfr.name);
-                        strlwr(fname);                  /* Just for MS-DOS. */
-
-                        /* Add filename to list. */
-                        ltmp = append_line(names, fname);
-                        if (ltmp == (LINE *)NULL)
-                        {
-                                /* Error adding to list. */
-                                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                                free_lines(names);
-                                return (LINE *)(-1);
-                        }
-                        names = ltmp;
+                        count++;
                 }
 
                 /* Find next match (if any). */
-                result = w_findnext(fspec, &findbfr);
+                result = w_findnext(&wf);
         }
 
-        /* Check if any files matched. */
-        if (names == (LINE *)NULL)
-                return (LINE *)NULL;
-
-        return names;
+        return count;
 }
 
 /*
 ** expand_dependents:
 ** Expands the dependent files list for a particular target
 ** by taking the text stored in the 'tdependents' field of
-** the specified target and creating a list of the individual
-** dependent filenames found there.
+** the specified target and creating an array of the individual
+** dependent filenames found there, with any wildcards resolved.
+** The array is kept in the 'tdeps' field of the target, so the
+** list is only expanded once during a run, no matter how many
+** times it is used.
 **
 ** Parameters:
 **      Name    Description
@@ -395,366 +533,398 @@ expand_wildcard(fspec)
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      NULL    Error expanding dependents.
-**      other   Pointer to first line descriptor of expanded
-**              dependent list.
+**      1       Successful; 'tar->tdeps' points to the array.
+**      0       Error expanding dependents.
 */
-LINE *
+int
 expand_dependents(tar)
         TARGET  *tar;
 {
         char    tmp[MAXPATH];           /* Temporary dependent filename. */
-        LINE    *dlhead = (LINE *)NULL; /* Head of dependent filenames list. */
+        STRVEC  names;                  /* Dependent filenames. */
+        char    *deps;                  /* Target's dependent info line. */
         int     tpos;                   /* Position in temporary buffer. */
         int     dpos;                   /* Position in dependent info line. */
-        LINE    *ltmp;                  /* Temporary line pointer. */
-        LINE    *matches;               /* Temporary line pointer. */
-        LINE    *ltmp2;                 /* Temporary line pointer. */
+        int     result;                 /* Result of expand_wildcard(). */
+        unsigned i;                     /* Index into names. */
+        DEPEND  *dtmp;                  /* Temporary dependent pointer. */
+        char    *ntmp;                  /* Copy of dependent names. */
+
+        /* Nothing to do if the list was already expanded. */
+        if (tar->tdeps != (DEPEND *)NULL)
+                return 1;
 
         /*
         ** Extract individual filenames from dependent info line.
         ** "tar->tdependents" contains a line of text from the
         ** makefile with one or more dependent filenames.  These
         ** are extracted one at a time into the buffer tmp and
-        ** then appended to the linked list of lines starting at
-        ** "dlhead".
+        ** then added to the string vector "names".
         */
+        init_strvec(&names);
+        deps = (tar->tdependents != (char *)NULL) ? tar->tdependents : "";
         dpos = 0;
-        while (tar->tdependents[dpos] != '\0')
+        while (deps[dpos] != '\0')
         {
                 /* Skip any leading whitespace. */
-                while (tar->tdependents[dpos] == ' ' ||
-                        tar->tdependents[dpos] == '\t')
-                {
+                while (deps[dpos] == ' ' || deps[dpos] == '\t')
                         dpos++;
-                }
 
                 /* Copy filename to temporary buffer. */
                 tpos = 0;
-                while (tar->tdependents[dpos] != ' ' &&
-                        tar->tdependents[dpos] != '\t' &&
-                        tar->tdependents[dpos] != '\0')
+                while (deps[dpos] != ' ' && deps[dpos] != '\t' &&
+                        deps[dpos] != '\0')
                 {
                         /* Check for overflow. */
-                        if (tpos >= MAXPATH)
+                        if (tpos >= MAXPATH - 1)
                         {
                                 /* Filename exceeds maximum length. */
-                                errmsg(MSG_ERR_PATHTOOLONG,
-                                        tar->tdependents, NOVAL);
-                                free_lines(dlhead);
-                                return (LINE *)NULL;
+                                errmsg(MSG_ERR_PATHTOOLONG, deps, NOVAL);
+                                flush_strvec(&names);
+                                return 0;
                         }
 
                         /* Copy character to buffer. */
-                        tmp[tpos++] = tar->tdependents[dpos++];
+                        tmp[tpos++] = deps[dpos++];
                 }
                 tmp[tpos] = '\0';
+                if (tpos == 0)
+                        continue;
 
                 /* Check if it's a wildcard or not. */
                 if (cindex(tmp, '*') >= 0 || cindex(tmp, '?') >= 0)
                 {
-                        /* Get list of matching files. */
-                        matches = expand_wildcard(tmp);
-                        if (matches == (LINE *)(-1))
+                        /* Add the matching files to the vector. */
+                        result = expand_wildcard(tmp, &names);
+                        if (result == -1)
                         {
                                 /* Error expanding wildcard. */
-                                free_lines(dlhead);
-                                return (LINE *)NULL;
+                                flush_strvec(&names);
+                                return 0;
                         }
 
                         /* Complain if wildcard didn't match anything. */
-                        if (matches == (LINE *)NULL)
+                        if (result == 0)
                         {
                                 errmsg(MSG_ERR_NOWILDDEP, tmp, NOVAL);
-                                return (LINE *)NULL;
+                                flush_strvec(&names);
+                                return 0;
                         }
+                }
+                else if (!add_strvec(&names, tmp))
+                {
+                        /* Out of memory. */
+                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                        flush_strvec(&names);
+                        return 0;
+                }
+        }
 
-                        /* Add matches to dependent list. */
-                        ltmp2 = matches;
-                        while (ltmp2 != (LINE *)NULL)
+        /*
+        ** Allocate the array, with room for the terminating entry,
+        ** and a copy of the names, along with the target list.
+        */
+        dtmp = (DEPEND *)target_alloc((names.vcount + 1) * sizeof(DEPEND));
+        ntmp = (char *)target_alloc(names.vused);
+        if (dtmp == (DEPEND *)NULL || ntmp == (char *)NULL)
+        {
+                /* Out of memory. */
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                flush_strvec(&names);
+                return 0;
+        }
+        tar->tdeps = dtmp;
+
+        /* Fill in the array from the vector. */
+        if (names.vused > 0)
+                memcpy(ntmp, names.vpool, names.vused);
+        for (i = 0; i < names.vcount; i++)
+        {
+                dtmp->dname = &ntmp[names.voff[i]];
+                dtmp->dtime = 0L;
+                dtmp++;
+        }
+        dtmp->dname = (char *)NULL;
+        dtmp->dtime = 0L;
+
+        flush_strvec(&names);
+        return 1;
+}
+
+/*
+** split_parts:
+** Splits the output of the first pass of compile_command()
+** into pieces, finding the '$?' and '$**' macros in the text.
+** If 'parts' is NULL, the pieces are only counted.
+**
+** Parameters:
+**      Name    Description
+**      ----    -----------
+**      text    Characters from first pass.
+**      kind    CMD_xxx kind of each character from first pass
+**              (CMD_TEXT for a literal character).
+**      n       Number of characters from first pass.
+**      parts   Array to receive pieces (or NULL).
+**      pool    Buffer to receive text of pieces (if 'parts'
+**              isn't NULL).
+**
+** Returns:
+**      Number of pieces, not counting the CMD_END piece.
+*/
+static int
+split_parts(text, kind, n, parts, pool)
+        char    *text;
+        char    *kind;
+        int     n;
+        CMDPART *parts;
+        char    *pool;
+{
+        int     i = 0;          /* Position in text. */
+        int     count = 0;      /* Number of pieces so far. */
+        int     last = CMD_END; /* Kind of last piece found. */
+        int     slot;           /* Kind of piece found. */
+        int     span;           /* Number of literal characters found. */
+
+        while (i < n)
+        {
+                /* Find the next piece. */
+                slot = kind[i];
+                span = 0;
+                if (slot != CMD_TEXT)
+                {
+                        i++;
+                }
+                else if (text[i] == '$' && i + 1 < n &&
+                        kind[i + 1] == CMD_TEXT)
+                {
+                        if (text[i + 1] == '?')
                         {
-                                ltmp = append_line(dlhead, ltmp2->ldata);
-                                if (ltmp == (LINE *)NULL)
-                                {
-                                        /* Out of memory. */
-                                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                                        free_lines(dlhead);
-                                        return (LINE *)NULL;
-                                }
-                                dlhead = ltmp;
-                                ltmp2 = ltmp2->lnext;
+                                slot = CMD_NEWER;
+                                i += 2;
+                        }
+                        else if (text[i + 1] == '*' && i + 2 < n &&
+                                kind[i + 2] == CMD_TEXT && text[i + 2] == '*')
+                        {
+                                slot = CMD_ALLDEPS;
+                                i += 3;
+                        }
+                        else
+                        {
+                                /* Any other '$' is kept with what follows. */
+                                span = 2;
                         }
-                        free_lines(matches);
                 }
                 else
                 {
-                        /* Add the filename to the new dependent list. */
-                        if (tpos > 0)
+                        span = 1;
+                }
+
+                if (span == 0)
+                {
+                        /* Add a special macro. */
+                        if (parts != (CMDPART *)NULL)
+                                parts[count].ckind = (char)slot;
+                        count++;
+                        last = slot;
+                        continue;
+                }
+
+                /* Add literal text, joining it to any text before it. */
+                if (last != CMD_TEXT)
+                {
+                        if (parts != (CMDPART *)NULL)
                         {
-                                ltmp = append_line(dlhead, tmp);
-                                if (ltmp == (LINE *)NULL)
-                                {
-                                        /* Out of memory. */
-                                        errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
-                                        free_lines(dlhead);
-                                        return (LINE *)NULL;
-                                }
-                                dlhead = ltmp;
+                                parts[count].ckind = CMD_TEXT;
+                                parts[count].clen = 0;
+                                parts[count].ctext = pool;
                         }
+                        count++;
+                        last = CMD_TEXT;
+                }
+                if (parts != (CMDPART *)NULL)
+                {
+                        memcpy(pool, &text[i], span);
+                        pool += span;
+                        parts[count - 1].clen += span;
                 }
+                i += span;
         }
 
-        return dlhead;
-}
+        if (parts != (CMDPART *)NULL)
+                parts[count].ckind = CMD_END;
 
+        return count;
+}
 /*
-** expand_tarspecial:
-** Expands the '$<', '$*', and '$@' special macros.
+** compile_command:
+** Compiles a command line from a target's or rule's command
+** list into pieces of literal text and the special macros
+** '$@', '$*', '$<', '$?', and '$**', so the command line only
+** has to be parsed once, no matter how many targets it is
+** used for.
+**
+** The special macros are found in two passes, the same way
+** they used to be expanded:  the first pass finds '$<', '$*',
+** and '$@' (which may be enclosed in parenthesis), and turns
+** "\$" into '$'.  The second pass, in split_parts(), finds
+** '$?' and '$**' in what's left.
 **
 ** Parameters:
 **      Name    Description
 **      ----    -----------
-**      src     String to be expanded.
-**      dest    String to place expanded text in.
-**      maxlen  Maximum length of expanded text.
-**      tfile   Target filename.
-**      sfile   Source filename for rule (if rule is not being
-**              used, this should be NULL).
+**      line    Command line to compile.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      1       Successful.
-**      0       Error occurred.
+**      NULL    Error occurred.
+**      other   Pointer to array of pieces, ending with a
+**              CMD_END piece, in one block from mem_alloc().
 */
-int
-expand_tarspecial(src, dest, maxlen, tfile, sfile)
-        char    *src;
-        char    *dest;
-        int     maxlen;
-        char    *tfile;
-        char    *sfile;
+CMDPART *
+compile_command(line)
+        char    *line;
 {
-        int     spos = 0;       /* Position in src string. */
-        int     dpos = 0;       /* Position in dest string. */
-        int     i;              /* Temporary loop index. */
-        int     j;              /* Temporary loop index. */
+        char    *text;          /* Characters from first pass. */
+        char    *kind;          /* Kind of each character. */
+        int     spos = 0;       /* Position in line. */
+        int     n = 0;          /* Number of characters from first pass. */
         int     did_paren;      /* Flag, nonzero if macro in parenthesis. */
-
-        while (src[spos] != '\0')
+        int     slot;           /* Kind of special macro found. */
+        int     count;          /* Number of pieces. */
+        int     len;            /* Number of literal characters. */
+        int     i;
+        CMDPART *parts;
+
+        /* The first pass never makes the line longer. */
+        text = (char *)mem_alloc(strlen(line) + 1);
+        kind = (char *)mem_alloc(strlen(line) + 1);
+        if (text == (char *)NULL || kind == (char *)NULL)
         {
-                did_paren = 0;
-
-                /* Check for destination string overflow. */
-                if (dpos >= maxlen - 1)
-                {
-                        /* Expansion caused string to become too long. */
-                        errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                        return 0;
-                }
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+                if (text != (char *)NULL)
+                        mem_free(text);
+                return (CMDPART *)NULL;
+        }
 
-                /*
-                ** Do the right thing depending on what the next
-                ** character in the source string is.
-                */
-                if (src[spos] == '\\')
+        while (line[spos] != '\0')
+        {
+                if (line[spos] == '\\')
                 {
                         /*
                         ** Character is a backslash, so treat the
                         ** next character literally if it is a '$'.
                         */
-
-                        /* Check for overflow. */
-                        if (dpos >= maxlen - 2)
+                        if (line[spos + 1] == '$')
                         {
-                                /* Expansion caused string to be too long. */
-                                errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                                return 0;
-                        }
-
-                        if (src[spos + 1] == '$')
-                        {
-                                spos++;                         /* Skip '\\' */
-                                dest[dpos++] = src[spos++];     /* Get '$' */
+                                spos++;                 /* Skip '\\' */
+                                kind[n] = CMD_TEXT;
+                                text[n++] = line[spos++];
                         }
                         else
                         {
-                                dest[dpos++] = src[spos++];     /* Get '\\' */
-                                if (src[spos] != '\0')          /* Get char */
-                                        dest[dpos++] = src[spos++];
+                                kind[n] = CMD_TEXT;
+                                text[n++] = line[spos++];
+                                if (line[spos] != '\0')
+                                {
+                                        kind[n] = CMD_TEXT;
+                                        text[n++] = line[spos++];
+                                }
                         }
+                        continue;
                 }
-                if (src[spos] == '$')
+                if (line[spos] != '$')
                 {
-                        /*
-                        ** We got a '$', so see if it's the start of
-                        ** a special macro.  If not, we treat it as
-                        ** a literal '$'.
-                        ** Also, the macro may be enclosed in '()'.
-                        */
-                        spos++;                         /* Skip '$' */
-                        if (src[spos] == '(')
-                        {
-                                did_paren = 1;
-                                spos++;                 /* Skip '(' */
-                        }
+                        /* Nothing special, so just copy it. */
+                        kind[n] = CMD_TEXT;
+                        text[n++] = line[spos++];
+                        continue;
+                }
 
-                        if (src[spos] == '<')
+                /*
+                ** We got a '$', so see if it's the start of a
+                ** special macro, which may be enclosed in '()'.
+                */
+                spos++;                                 /* Skip '$' */
+                did_paren = 0;
+                if (line[spos] == '(')
+                {
+                        did_paren = 1;
+                        spos++;                         /* Skip '(' */
+                }
+                if (line[spos] != '<' && line[spos] != '*' &&
+                        line[spos] != '@')
+                {
+                        /* A '$' with nothing special; copy the '$'. */
+                        kind[n] = CMD_TEXT;
+                        text[n++] = '$';
+                        if (did_paren)
                         {
-                                /*
-                                ** Handle '$<'
-                                */
-                                spos++;                 /* Skip '<' */
-                                if (did_paren)
-                                {
-                                        if (src[spos] != ')')
-                                        {
-                                                errmsg(MSG_ERR_NORPAREN,
-                                                        src, NOVAL);
-                                                return 0;
-                                        }
-                                        spos++;         /* Skip ')' */
-                                }
-                                if (sfile == (char *)NULL ||
-                                        sfile[0] == '\0')
-                                {
-                                        /* We're not in a rule, so complain. */
-                                        errmsg(MSG_ERR_LTNORULE, src, NOVAL);
-                                        return 0;
-                                }
-                                else
-                                {
-                                        /* Check for overflow. */
-                                        if (dpos + strlen(sfile) + 1 >= maxlen)
-                                        {
-                                                /* Expansion caused string to be too long. */
-                                                errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                                                return 0;
-                                        }
-
-                                        /* Copy rule sourcefile into dest. */
-                                        i = 0;
-                                        while (sfile[i] != '\0')
-                                                dest[dpos++] = sfile[i++];
-                                }
+                                kind[n] = CMD_TEXT;
+                                text[n++] = '(';
                         }
-                        else if (src[spos] == '*')
-                        {
-                                /*
-                                ** Handle '$*', making sure to leave '$**'.
-                                */
-                                spos++;                 /* Skip '*' */
-                                if (src[spos] == '*')
-                                {
-                                        /* Leave '$**' alone. */
-                                        dest[dpos++] = '$';
-                                        dest[dpos++] = '*';
-                                        dest[dpos++] = src[spos++];
-                                }
-                                else
-                                {
-                                        /*
-                                        ** It really is '$*' so extract
-                                        ** the basename of the target into
-                                        ** the dest.
-                                        */
-
-                                        /* Find end of basename. */
-                                        i = strlen(tfile);
-                                        while (i > 0 &&
-                                                tfile[i] != '.' &&
-                                                tfile[i] != '\\')
-                                                i--;
-                                        if (i == 0 || tfile[i] == '\\')
-                                                i = strlen(tfile);
-
-                                        /* Check for overflow. */
-                                        if (dpos + i + 1 >= maxlen)
-                                        {
-                                                /* Expansion caused string to be too long. */
-                                                errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                                                return 0;
-                                        }
+                        continue;
+                }
 
-                                        /* Copy basename to dest. */
-                                        j = 0;
-                                        while (j < i)
-                                                dest[dpos++] = tfile[j++];
-                                }
-                                if (did_paren)
-                                {
-                                        if (src[spos] != ')')
-                                        {
-                                                errmsg(MSG_ERR_NORPAREN,
-                                                        src, NOVAL);
-                                                return 0;
-                                        }
-                                        spos++;         /* Skip ')' */
-                                }
-                        }
-                        else if (src[spos] == '@')
+                if (line[spos] == '*' && line[spos + 1] == '*')
+                {
+                        /* Leave '$**' for the second pass. */
+                        for (i = 0; i < 3; i++)
                         {
-                                /*
-                                ** Handle '$@'
-                                */
-                                spos++;                 /* Skip '@' */
-                                if (did_paren)
-                                {
-                                        if (src[spos] != ')')
-                                        {
-                                                errmsg(MSG_ERR_NORPAREN,
-                                                        src, NOVAL);
-                                                return 0;
-                                        }
-                                        spos++;         /* Skip ')' */
-                                }
-
-                                /* Check for overflow. */
-                                if (dpos + strlen(tfile) + 1 >= maxlen)
-                                {
-                                        /* Expansion caused string to be too long. */
-                                        errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                                        return 0;
-                                }
-
-                                /* Copy target name to dest. */
-                                i = 0;
-                                while (tfile[i] != '\0')
-                                        dest[dpos++] = tfile[i++];
+                                kind[n] = CMD_TEXT;
+                                text[n++] = i == 0 ? '$' : '*';
                         }
+                        spos += 2;
+                        slot = CMD_TEXT;
+                }
+                else
+                {
+                        if (line[spos] == '<')
+                                slot = CMD_SOURCE;
+                        else if (line[spos] == '*')
+                                slot = CMD_BASE;
                         else
+                                slot = CMD_TARGET;
+                        spos++;
+                }
+                if (did_paren)
+                {
+                        if (line[spos] != ')')
                         {
-                                /*
-                                ** Character was a '$' with nothing
-                                ** special, so just copy the '$'.
-                                */
-
-                                /* Check for overflow. */
-                                if (dpos >= maxlen - 2)
-                                {
-                                        /* Expansion caused string to be too long. */
-                                        errmsg(MSG_ERR_EXPTOOLONG, src, NOVAL);
-                                        return 0;
-                                }
-
-                                /* Just copy the '$'. */
-                                dest[dpos++] = '$';
-                                if (did_paren)
-                                        dest[dpos++] = '(';
+                                errmsg(MSG_ERR_NORPAREN, line, NOVAL);
+                                mem_free(kind);
+                                mem_free(text);
+                                return (CMDPART *)NULL;
                         }
+                        spos++;                         /* Skip ')' */
                 }
-                else
+                if (slot != CMD_TEXT)
                 {
-                        /*
-                        ** The source character is nothing special,
-                        ** so just copy it.
-                        */
-                        dest[dpos++] = src[spos++];
+                        kind[n] = (char)slot;
+                        text[n++] = '$';
                 }
-        } /* End while() */
+        }
 
-        dest[dpos] = '\0';
+        /* Count the pieces and their text, then fill them in. */
+        count = split_parts(text, kind, n, (CMDPART *)NULL, (char *)NULL);
+        len = 0;
+        for (i = 0; i < n; i++)
+        {
+                if (kind[i] == CMD_TEXT)
+                        len++;
+        }
+        parts = (CMDPART *)mem_alloc((count + 1) * sizeof(CMDPART) + len);
+        if (parts == (CMDPART *)NULL)
+        {
+                errmsg(MSG_ERR_OUTOFMEMORY, (char *)NULL, NOVAL);
+        }
+        else
+        {
+                split_parts(text, kind, n, parts,
+                        (char *)&parts[count + 1]);
+        }
 
-        return 1;
+        mem_free(kind);
+        mem_free(text);
+        return parts;
 }
-
@@ -1187,7 +1187,7 @@ main(argc, argv)
 {
         int                     i;
         int                     did;
-        struct find_t           findbfr;
+        WFIND                   wf;
         char                    pathspec[MAXPATH];
         char                    filespec[MAXPATH];
         struct dosdate_t        systemdate;
@@ -1297,7 +1297,7 @@ main(argc, argv)
                         getpath(pathspec);
                         did++;
 
-                        if (w_findfirst(argv[i], &findbfr))
+                        if (w_findfirst(argv[i], &wf))
                         {
                                 /*
                                 ** There is no match for the specified
@@ -1318,9 +1318,9 @@ main(argc, argv)
                                 {
                                         /* Touch a file. */
                                         strcpy(filespec, pathspec);
-                                        strcat(filespec, findbfr.name);
+                                        strcat(filespec, wf.wfind.name);
                                         strlwr(filespec);
-                                        if (findbfr.attrib & _A_SUBDIR)
+                                        if (wf.wfind.attrib & _A_SUBDIR)
                                         {
                                                 errmsg(MSG_WARN_DIRECTORY,
                                                         filespec);
@@ -1331,7 +1331,7 @@ main(argc, argv)
                                                         date, ttime);
                                         }
                                 }
-                                while (!w_findnext(argv[i], &findbfr));
+                                while (!w_findnext(&wf));
                         }
                 }
         }
@@ -3,7 +3,8 @@
 wild.c
 Routines for handling wildcard filenames for MS-DOS.
 
-The external routines getpath() and check_rexp() are used.
+The external routines getpath(), compile_rexp() and match_rexp()
+are used.
 
 This source file is part of a computer program that is
 Copyright 1988 by Ammon R. Campbell.  All rights reserved.
@@ -25,62 +26,47 @@ of the author.
 #include "fnexp.h"
 #include "wild.h"
 
+/****************************** HEADERS *******************************/
+
+static int      w_scan(int result, WFIND *wf);
+
 /****************************** FUNCTIONS *****************************/
 
 /*
-** w_findfirst:
-** Finds the first matching file for the specified filespec.
+** w_scan:
+** Steps through the directory entries, starting with the one
+** in the find buffer, until one matches the scan's compiled
+** filespec.
 **
 ** Parameters:
 **      Name            Description
 **      ----            -----------
-**      filespec        Filespec to match.
-**      findbfr         Pointer to 'find_t' structure as defined
-**                      in Microsoft C "dos.h" file.
+**      result          Result of the _dos_find...() call that
+**                      filled in the find buffer.
+**      wf              Pointer to WFIND structure for the scan.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      0       Match found; data returned in findbfr.
+**      0       Match found; data returned in wf->wfind.
 **      1       No match.
 */
-int
-w_findfirst(filespec, findbfr)
-        char    *filespec;
-        struct find_t *findbfr;
-{
+static int
+w_scan(result, wf)
         int     result;
-        char    str[128];
-
-        strcpy(str, filespec);
-        getpath(str);
-        strcat(str, "*.*");
-        if ((result = _dos_findfirst(str,
-                        _A_NORMAL | _A_ARCH | _A_SUBDIR |
-                        _A_HIDDEN | _A_SYSTEM | _A_VOLID | _A_RDONLY,
-                        findbfr)))
-        {
-                /* No match. */
-                return 1;
-        }
-
+        WFIND   *wf;
+{
         while (!result)
         {
-                /* Build filename. */
-                strcpy(str, filespec);
-                getpath(str);
-                strcat(str, findbfr->name);
-                strlwr(str);
-
                 /* See if this file matches wildcard expression. */
-                if (check_rexp(str, filespec) == 1)
+                if (match_rexp(&wf->wrexp, wf->wfind.name))
                 {
                         /* Found a match. */
                         return 0;
                 }
 
                 /* Get next file. */
-                result = _dos_findnext(findbfr);
+                result = _dos_findnext(&wf->wfind);
         }
 
         /* No match. */
@@ -88,57 +74,76 @@ w_findfirst(filespec, findbfr)
 }
 
 /*
-** w_findnext:
-** Finds the next matching file for the findbfr from a previous call
-** to w_findfirst().
+** w_findfirst:
+** Finds the first matching file for the specified filespec.
 **
 ** Parameters:
 **      Name            Description
 **      ----            -----------
 **      filespec        Filespec to match.
-**      findbfr         Pointer to 'find_t' structure as defined
-**                      in Microsoft C "dos.h" file, and processed
-**                      by an initial call to w_findfirst().
+**      wf              Pointer to WFIND structure for the scan.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      0       Match found; data returned in findbfr.
+**      0       Match found; data returned in wf->wfind.
 **      1       No match.
 */
 int
-w_findnext(filespec, findbfr)
-        char            *filespec;
-        struct find_t   *findbfr;
+w_findfirst(filespec, wf)
+        char    *filespec;
+        WFIND   *wf;
 {
         int     result;
         char    str[128];
 
-        if ((result = _dos_findnext(findbfr)))
+        if (strlen(filespec) >= sizeof(str) - 3)
         {
-                /* No match. */
+                /* Filespec is too long. */
                 return 1;
         }
+        strcpy(str, filespec);
+        getpath(str);
 
-        while (!result)
+        /*
+        ** Every entry is in the same directory, so only the
+        ** filename part of the filespec needs to be matched.
+        */
+        if (compile_rexp(&filespec[strlen(str)], &wf->wrexp) != 1)
         {
-                /* Build filename. */
-                strcpy(str, filespec);
-                getpath(str);
-                strcat(str, findbfr->name);
-                strlwr(str);
-
-                /* See if this file matches wildcard expression. */
-                if (check_rexp(str, filespec) == 1)
-                {
-                        /* Found a match. */
-                        return 0;
-                }
-
-                /* Get next file. */
-                result = _dos_findnext(findbfr);
+                /* Error in wildcard expression. */
+                return 1;
         }
 
-        return 1;
+        strcat(str, "*.*");
+        result = _dos_findfirst(str,
+                        _A_NORMAL | _A_ARCH | _A_SUBDIR |
+                        _A_HIDDEN | _A_SYSTEM | _A_VOLID | _A_RDONLY,
+                        &wf->wfind);
+
+        return w_scan(result, wf);
 }
 
+/*
+** w_findnext:
+** Finds the next matching file for the scan started by a
+** previous call to w_findfirst().
+**
+** Parameters:
+**      Name            Description
+**      ----            -----------
+**      wf              Pointer to WFIND structure processed
+**                      by an initial call to w_findfirst().
+**
+** Returns:
+**      Value   Meaning
+**      -----   -------
+**      0       Match found; data returned in wf->wfind.
+**      1       No match.
+*/
+int
+w_findnext(wf)
+        WFIND   *wf;
+{
+        return w_scan(_dos_findnext(&wf->wfind), wf);
+}
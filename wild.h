@@ -15,6 +15,19 @@ of the author.
 =========================================================================
 */
 
+/*
+** WFIND data structure for a wildcard directory scan.  The
+** filename part of the filespec is compiled once by w_findfirst()
+** and used to test every entry of the directory.
+** (Requires "dos.h" and "fnexp.h")
+*/
+struct wfind_s
+{
+        struct find_t   wfind;  /* DOS find buffer; holds matched file. */
+        REXP            wrexp;  /* Compiled filename part of filespec. */
+};
+typedef struct wfind_s WFIND;
+
 /*
 ** w_findfirst:
 ** Finds the first matching file for the specified filespec.
@@ -23,35 +36,35 @@ of the author.
 **      Name            Description
 **      ----            -----------
 **      filespec        Filespec to match.
-**      findbfr         Pointer to 'find_t' structure as defined
-**                      in Microsoft C "dos.h" file.
+**      wf              Pointer to WFIND structure for the scan.
+**                      The matched file is described by its
+**                      'wfind' member, which is a 'find_t'
+**                      structure as defined in Microsoft C
+**                      "dos.h" file.
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      0       Match found; data returned in findbfr.
+**      0       Match found; data returned in wf->wfind.
 **      1       No match.
 */
-int     w_findfirst(char *filespec, struct find_t *findbfr);
+int     w_findfirst(char *filespec, WFIND *wf);
 
 /*
 ** w_findnext:
-** Finds the next matching file for the findbfr from a previous call
-** to w_findfirst().
+** Finds the next matching file for the scan started by a
+** previous call to w_findfirst().
 **
 ** Parameters:
 **      Name            Description
 **      ----            -----------
-**      filespec        Filespec to match.
-**      findbfr         Pointer to 'find_t' structure as defined
-**                      in Microsoft C "dos.h" file, and processed
+**      wf              Pointer to WFIND structure processed
 **                      by an initial call to w_findfirst().
 **
 ** Returns:
 **      Value   Meaning
 **      -----   -------
-**      0       Match found; data returned in findbfr.
+**      0       Match found; data returned in wf->wfind.
 **      1       No match.
 */
-int     w_findnext(char *filespec, struct find_t *findbfr);
-
+int     w_findnext(WFIND *wf);